@@ -4,6 +4,8 @@
 #include "../common/events.h"
 #include "../common/game_types.h"
 #include "../networking/net_platform.h"
+#include "../networking/network.h"
+#include "../networking/net_reactor.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -15,29 +17,62 @@ extern "C"
         int player_id;
         char player_name[32];
         int connected;
+        int connecting; // A connect started by client_connect/client_resume is in flight
         int host_player_id;
         int is_host;
 
         net_socket_t socket_fd;
+        NetConnectAttempt connect_attempt;
+        NetReactor *reactor; // Watches socket_fd for client_wait; client_wake interrupts it
+        NetRecvBuffer recv_buffer;
         PlayerGameState player_game_state;
         int has_state_snapshot;
+        unsigned int snapshot_version; // Version of player_game_state.entries, base for incoming deltas
+        unsigned int private_version;  // Version of player_game_state.self
+        int resync_pending;            // Waiting for a keyframe after a missed delta
 
         // Match state tracking
         int match_started;
         int current_turn_player_id;
         int turn_number;
         int valid_actions; // Bitmask of valid actions for this player
+
+        // Heartbeats: ping the server every interval, disconnect after timeout of silence
+        int heartbeat_interval_ms;
+        int heartbeat_timeout_ms;
+        uint64_t last_heard_us; // net_monotonic_us() when the server last sent anything
+        uint64_t last_ping_us;
+        uint32_t ping_sequence;
+        NetRttStats rtt; // Round trip to the server
+
+        // Session resume: after a dropped connection, client_resume reclaims our slot
+        uint64_t resume_token; // From the join ack, 0 when there is nothing to resume
+        char server_addr[64];  // Address of the last client_connect
     } ClientContext;
 
     ClientContext *client_create(const char *name);
     void client_destroy(ClientContext *ctx);
 
     int client_init(ClientContext *ctx, const char *player_name);
+    // Starts connecting and returns at once; client_pump completes the connect and the
+    // join. Returns -1 only if the address cannot be resolved or no socket could be opened.
     int client_connect(ClientContext *ctx, const char *server_addr);
+    // Leaves the game for good; the server frees our slot at once
     void client_disconnect(ClientContext *ctx);
-    void client_pump(ClientContext *ctx);
+    // Reconnects to the last server after the connection dropped and reclaims our slot.
+    // Returns 0 once the request is sent, -1 if there is no session or the server is unreachable.
+    int client_resume(ClientContext *ctx);
+    // Handles every event that has arrived without blocking. Returns how many were handled.
+    int client_pump(ClientContext *ctx);
+    // Blocks until the server sends something, client_wake is called, a heartbeat is due
+    // or timeout_ms passes (-1 waits without a limit). Returns 1 if the socket became readable.
+    int client_wait(ClientContext *ctx, int timeout_ms);
+    // Makes a concurrent or the next client_wait return at once; callable from any thread
+    void client_wake(ClientContext *ctx);
     void client_send_action(ClientContext *ctx, UserActionType action_type, int target_player_id, int value, int metadata);
     void client_request_match_start(ClientContext *ctx);
+    // 0 disables either (defaults: NET_HEARTBEAT_*)
+    void client_set_heartbeat(ClientContext *ctx, int interval_ms, int timeout_ms);
 
 #ifdef __cplusplus
 }
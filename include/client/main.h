@@ -12,6 +12,7 @@ void client_on_disconnected(ClientContext *ctx);
 void client_on_join_request(ClientContext *ctx);
 void client_on_join_ack(ClientContext *ctx, const EventPayload_JoinAck *payload);
 void client_on_player_joined(ClientContext *ctx, const EventPayload_PlayerLifecycle *payload);
+void client_on_lobby_snapshot(ClientContext *ctx, const EventPayload_LobbySnapshot *payload);
 void client_on_player_left(ClientContext *ctx, const EventPayload_PlayerLifecycle *payload);
 void client_on_host_update(ClientContext *ctx, const EventPayload_HostUpdate *payload);
 void client_on_match_start(ClientContext *ctx, const EventPayload_MatchStart *payload);
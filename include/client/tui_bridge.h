@@ -7,6 +7,8 @@ extern "C"
 #endif
 
 #define ARMADA_DISCOVERY_MAX_RESULTS 32
+// Joinable servers read from a directory per refresh
+#define ARMADA_DIRECTORY_MAX_RESULTS 256
 
     int armada_tui_run(void);
 
@@ -23,14 +23,26 @@ typedef enum
     // Gameplay feedback hooks
     EVENT_STAR_THRESHOLD_REACHED,
     EVENT_GAME_OVER,
-    EVENT_ERROR
+    EVENT_ERROR,
+    // Client asks for a full snapshot after missing a delta
+    EVENT_STATE_RESYNC_REQUEST,
+    // Per-viewer half of a turn update (own PlayerState and valid actions)
+    EVENT_TURN_PRIVATE,
+    // Whole roster, host and match phase, sent to a player right after its JOIN_ACK
+    EVENT_LOBBY_SNAPSHOT,
+    // Liveness and round-trip probes; either side may ping, the other echoes a pong
+    EVENT_PING,
+    EVENT_PONG
 } EventType;
 
+#define EVENT_TYPE_COUNT ((int)EVENT_PONG + 1)
+
 // Payload structures for specific events
 
 typedef struct
 {
     char player_name[32];
+    uint64_t resume_token; // From an earlier JOIN_ACK to reclaim that slot, 0 for a fresh join
 } EventPayload_PlayerJoin;
 
 typedef struct
@@ -40,6 +52,8 @@ typedef struct
     char message[64];
     int host_player_id;
     int is_host;
+    int resumed;           // The slot was reclaimed; missed events follow instead of a fresh lobby
+    uint64_t resume_token; // Present on a later join request to resume after a dropped connection
 } EventPayload_JoinAck;
 
 typedef struct
@@ -65,21 +79,61 @@ typedef struct
 #define VALID_ACTION_UPGRADE_PLANET (1 << 3)
 #define VALID_ACTION_UPGRADE_SHIP (1 << 4)
 
+// Field masks for delta-encoded snapshots. Only fields whose bit is set
+// are carried on the wire; the rest are unchanged since base_version.
+#define SNAPSHOT_SELF_ID (1 << 0)
+#define SNAPSHOT_SELF_NAME (1 << 1)
+#define SNAPSHOT_SELF_FLAGS (1 << 2) // is_active, is_connected, has_crossed_threshold
+#define SNAPSHOT_SELF_STARS (1 << 3)
+#define SNAPSHOT_SELF_PLANET_LEVEL (1 << 4)
+#define SNAPSHOT_SELF_PLANET_MAX_HEALTH (1 << 5)
+#define SNAPSHOT_SELF_PLANET_HEALTH (1 << 6)
+#define SNAPSHOT_SELF_PLANET_INCOME (1 << 7)
+#define SNAPSHOT_SELF_SHIP_LEVEL (1 << 8)
+#define SNAPSHOT_SELF_SHIP_DAMAGE (1 << 9)
+#define SNAPSHOT_SELF_ALL 0x3FF
+
+#define SNAPSHOT_ENTRY_ID (1 << 0)
+#define SNAPSHOT_ENTRY_FLAGS (1 << 1) // is_active, show_stars
+#define SNAPSHOT_ENTRY_NAME (1 << 2)
+#define SNAPSHOT_ENTRY_HEALTH (1 << 3)
+#define SNAPSHOT_ENTRY_SHIP_LEVEL (1 << 4)
+#define SNAPSHOT_ENTRY_PLANET_LEVEL (1 << 5)
+#define SNAPSHOT_ENTRY_SHIP_DAMAGE (1 << 6)
+#define SNAPSHOT_ENTRY_ALL 0x7F
+
+// Public half of a turn update, encoded once and broadcast to every viewer.
+// The viewer's own entry is filled in client-side from EVENT_TURN_PRIVATE.
 typedef struct
 {
     int current_player_id;
     int next_player_id;
     int turn_number;
     int is_match_start;
-    int valid_actions;       // Bitmask of valid actions for the receiving player
     int threshold_player_id; // Player who crossed threshold this turn, -1 if none otherwise
     EventPayload_UserAction last_action;
-    PlayerGameState game;
+    unsigned int snapshot_version;         // Version of entries once this event is applied
+    unsigned int base_version;             // Version the delta applies to, 0 for a full keyframe
+    unsigned int entry_masks[MAX_PLAYERS]; // SNAPSHOT_ENTRY_* fields present per entry
+    PlayerPublicInfo entries[MAX_PLAYERS];
 } EventPayload_TurnInfo;
 
+// Private half of a turn update, sent only to the player it describes
+typedef struct
+{
+    int player_id;
+    int valid_actions;             // Bitmask of valid actions for the receiving player
+    unsigned int snapshot_version; // Version of self once this event is applied
+    unsigned int base_version;     // Version the delta applies to, 0 for a full keyframe
+    unsigned int self_mask;        // SNAPSHOT_SELF_* fields present in self
+    PlayerState self;
+} EventPayload_TurnPrivate;
+
 typedef struct
 {
-    GameState state;
+    int host_player_id;
+    int first_player_id;
+    int player_count;
 } EventPayload_MatchStart;
 
 typedef struct
@@ -88,6 +142,28 @@ typedef struct
     char host_player_name[MAX_NAME_LEN];
 } EventPayload_HostUpdate;
 
+// EVENT_PING / EVENT_PONG: the pong echoes the ping unchanged
+typedef struct
+{
+    uint32_t sequence;
+    uint32_t sent_us; // Sender's monotonic clock, truncated to 32 bits
+} EventPayload_Heartbeat;
+
+typedef enum
+{
+    LOBBY_PHASE_WAITING = 0, // Waiting for the host to start a match
+    LOBBY_PHASE_IN_MATCH,
+    LOBBY_PHASE_GAME_OVER,
+} LobbyPhase;
+
+typedef struct
+{
+    int host_player_id;
+    LobbyPhase phase;
+    unsigned int active_mask; // Bit i set when slot i holds a player
+    char player_names[MAX_PLAYERS][MAX_NAME_LEN];
+} EventPayload_LobbySnapshot;
+
 typedef struct
 {
     int player_id;
@@ -119,9 +195,12 @@ typedef struct
         EventPayload_JoinAck join_ack;
         EventPayload_PlayerLifecycle player_event;
         EventPayload_TurnInfo turn;
+        EventPayload_TurnPrivate turn_private;
         EventPayload_UserAction action;
         EventPayload_MatchStart match_start;
         EventPayload_HostUpdate host_update;
+        EventPayload_LobbySnapshot lobby;
+        EventPayload_Heartbeat heartbeat;
         EventPayload_Threshold threshold;
         EventPayload_GameOver game_over;
         EventPayload_Error error;
@@ -0,0 +1,45 @@
+#ifndef NET_CODEC_H
+#define NET_CODEC_H
+
+#include "../common/events.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Wire format version carried in every frame header
+#define ARMADA_WIRE_VERSION 1
+
+/*
+ * Frame layout (all integers big-endian):
+ *
+ *   u16 body_length   number of bytes following this field
+ *   u8  version       ARMADA_WIRE_VERSION
+ *   u8  type          EventType
+ *   i8  sender_id     -1 for server, player slot otherwise
+ *   u32 timestamp     seconds since the Unix epoch (truncated)
+ *   ... payload       per-EventType encoding, see net_codec.c
+ *
+ * Strings are sent as a u8 length followed by the bytes, without a terminator.
+ */
+#define NET_FRAME_LENGTH_SIZE 2
+#define NET_FRAME_HEADER_SIZE 9
+#define NET_FRAME_MAX_SIZE 1024
+
+    // Encode an event into buf. Returns the frame size in bytes, or 0 if it does not fit in cap.
+    size_t net_encode_event(const GameEvent *event, unsigned char *buf, size_t cap);
+
+    // Decode one frame from the start of buf.
+    // Returns bytes consumed (> 0), 0 if buf holds only part of a frame, -1 if the frame is malformed.
+    int net_decode_event(const unsigned char *buf, size_t len, GameEvent *event);
+
+    // Size of the frame starting at buf, or 0 if the length prefix is not complete yet.
+    size_t net_frame_size(const unsigned char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_CODEC_H
@@ -0,0 +1,78 @@
+#ifndef NET_DIRECTORY_H
+#define NET_DIRECTORY_H
+
+#include "network.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Directory of servers across subnets, kept by a small UDP daemon
+// ("armada --directory"). Servers register with a heartbeat every
+// NET_BEACON_INTERVAL_MS and are dropped after NET_BEACON_TTL_MS of silence.
+//
+//   server -> directory  "ARMADA_DIR_REGISTER_V1 <port> <players> <max> <id> <phase> <version>"
+//   server -> directory  "ARMADA_DIR_LEAVE_V1 <port>"
+//   client -> directory  "ARMADA_DIR_QUERY_V1 <nonce> <cursor> <limit> <flags>", space-padded
+//                        to 1200 bytes so no page is larger than the query it answers
+//   directory -> client  "ARMADA_DIR_PAGE_V1 <nonce> <total> <next cursor> <count>\n"
+//                        then one "<address> <port> <players> <max> <id> <phase> <version>\n" per server
+//
+// Servers are listed by the address their heartbeats come from.
+#define ARMADA_DIRECTORY_PORT 8082
+#define ARMADA_DIRECTORY_REGISTER "ARMADA_DIR_REGISTER_V1"
+#define ARMADA_DIRECTORY_LEAVE "ARMADA_DIR_LEAVE_V1"
+#define ARMADA_DIRECTORY_QUERY "ARMADA_DIR_QUERY_V1"
+#define ARMADA_DIRECTORY_PAGE "ARMADA_DIR_PAGE_V1"
+
+#define NET_DIRECTORY_DEFAULT_CAPACITY 4096
+// Servers per reply, keeping each page in one unfragmented datagram
+#define NET_DIRECTORY_PAGE_SIZE 16
+
+// Query filters
+#define NET_DIRECTORY_JOINABLE 0x1u // Only servers net_lan_host_joinable accepts
+
+    /*
+     * Fixed-capacity table of registered servers.
+     *
+     * Servers are found through an open-addressing hash of address and port, and
+     * kept on a list ordered by their last heartbeat, so a heartbeat, a leave and
+     * each expiry cost O(1). Pages walk the slots in index order; a slot keeps its
+     * index while its server stays registered, so cursors stay valid between pages.
+     *
+     * Not thread-safe: the daemon owns it from one thread.
+     */
+    typedef struct NetDirectory NetDirectory;
+
+    NetDirectory *net_directory_create(int capacity);
+    void net_directory_destroy(NetDirectory *directory);
+
+    // Record a heartbeat. Returns 1 for a new server, 0 for a known one, -1 if the table is full.
+    int net_directory_update(NetDirectory *directory, const NetLanHost *host, uint64_t now_us);
+    // Returns 1 if the server was listed
+    int net_directory_remove(NetDirectory *directory, const char *address, int port);
+    // Drop servers whose last heartbeat is older than ttl_us. Returns how many went.
+    int net_directory_expire(NetDirectory *directory, uint64_t now_us, uint64_t ttl_us);
+    int net_directory_count(const NetDirectory *directory);
+    // Copy up to max_hosts servers passing flags, starting at cursor (0 for the first page).
+    // *out_next_cursor is 0 once the table is exhausted. Returns the number copied.
+    int net_directory_list(const NetDirectory *directory, unsigned int cursor, unsigned int flags,
+                           NetLanHost *out_hosts, int max_hosts, unsigned int *out_next_cursor);
+
+    // Run the daemon on port until *running drops to 0 (NULL runs forever).
+    // Returns 0 after a clean stop, -1 if the port could not be bound.
+    int net_directory_serve(int port, int capacity, volatile int *running);
+
+    // Resolve "host" or "host:port" (default ARMADA_DIRECTORY_PORT). Returns 0 on success.
+    int net_directory_resolve(const char *directory, struct sockaddr_in *out_addr);
+    // Read every page of the directory passing flags, up to max_hosts servers.
+    // Returns the number stored, -1 if the directory did not answer within timeout_ms.
+    int net_directory_fetch(const char *directory, unsigned int flags, NetLanHost *out_hosts, int max_hosts,
+                            int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_DIRECTORY_H
@@ -0,0 +1,130 @@
+#ifndef NET_LOCK_PROFILE_H
+#define NET_LOCK_PROFILE_H
+
+#include "net_platform.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+#include <source_location>
+
+extern "C"
+{
+#endif
+
+// Histogram buckets: under 256 ns, then one per power of two up to 1 s and over
+#define NET_LOCK_HISTOGRAM_BUCKETS 24
+// Call sites tracked per lock; later ones are counted together
+#define NET_LOCK_PROFILE_SITES 32
+
+    // Totals for one place that takes a lock
+    typedef struct
+    {
+        const char *file; // NULL for the shared overflow entry
+        int line;
+        unsigned long acquisitions;
+        unsigned long contended; // Acquisitions that had to wait
+        uint64_t wait_ns;
+        uint64_t hold_ns;
+        uint64_t max_hold_ns;
+    } NetLockSite;
+
+    /*
+     * A net_mutex_t that measures itself.
+     *
+     * While profiling is on, every acquisition records how long it waited and,
+     * at release, how long it was held, into per-lock histograms and per call
+     * site totals. A free lock is taken with a try-lock, so only contended
+     * acquisitions read the clock while waiting. The statistics are guarded by
+     * the lock itself, so recording costs no extra synchronisation.
+     *
+     * Profiling is off unless ARMADA_LOCK_PROFILE is set in the environment or
+     * net_lock_profile_enable is called; while off a lock and unlock cost one
+     * flag check over the plain mutex.
+     *
+     * Every initialised lock is registered by name so net_lock_profile_dump can
+     * report all of them at once.
+     */
+    typedef struct NetProfiledMutex
+    {
+        net_mutex_t mutex;
+        const char *name;
+        struct NetProfiledMutex *next_registered;
+
+        NetLockSite *volatile holder; // Site of the current timed hold, NULL otherwise
+        uint64_t acquired_ns;         // Start of the current timed hold
+
+        unsigned long acquisitions;
+        unsigned long contended;
+        uint64_t wait_ns;
+        uint64_t hold_ns;
+        uint64_t max_wait_ns;
+        uint64_t max_hold_ns;
+        unsigned long wait_histogram[NET_LOCK_HISTOGRAM_BUCKETS];
+        unsigned long hold_histogram[NET_LOCK_HISTOGRAM_BUCKETS];
+        NetLockSite sites[NET_LOCK_PROFILE_SITES];
+        int site_count;
+        NetLockSite other_sites;
+    } NetProfiledMutex;
+
+    // Same signature as ArmadaUiLogSink, so a dump can go straight to a UI log
+    typedef void (*NetLockProfileSink)(const char *line, void *userdata);
+
+    // name must outlive the lock (a string literal). Returns 0 on success.
+    int net_profiled_mutex_init(NetProfiledMutex *mutex, const char *name);
+    void net_profiled_mutex_destroy(NetProfiledMutex *mutex);
+    void net_profiled_mutex_lock_at(NetProfiledMutex *mutex, const char *file, int line);
+    void net_profiled_mutex_unlock(NetProfiledMutex *mutex);
+
+#define net_profiled_mutex_lock(mutex) \
+    net_profiled_mutex_lock_at((mutex), __FILE__, __LINE__)
+
+    int net_lock_profile_enabled(void);
+    void net_lock_profile_enable(int enabled);
+    // Clear the statistics of every registered lock
+    void net_lock_profile_reset(void);
+    // Report every registered lock, one line per call to sink
+    void net_lock_profile_dump(NetLockProfileSink sink, void *userdata);
+
+#ifdef __cplusplus
+}
+
+// NetProfiledMutex for C++ members and globals
+class NetProfiledLockable
+{
+public:
+    explicit NetProfiledLockable(const char *name) { net_profiled_mutex_init(&mutex_, name); }
+    ~NetProfiledLockable() { net_profiled_mutex_destroy(&mutex_); }
+    NetProfiledLockable(const NetProfiledLockable &) = delete;
+    NetProfiledLockable &operator=(const NetProfiledLockable &) = delete;
+
+    void lock(std::source_location site = std::source_location::current())
+    {
+        net_profiled_mutex_lock_at(&mutex_, site.file_name(), static_cast<int>(site.line()));
+    }
+    void unlock() { net_profiled_mutex_unlock(&mutex_); }
+
+private:
+    NetProfiledMutex mutex_;
+};
+
+// Scoped lock that charges the hold to the line constructing it
+// (std::lock_guard would charge every hold to <mutex>)
+class NetProfiledLock
+{
+public:
+    explicit NetProfiledLock(NetProfiledLockable &mutex,
+                             std::source_location site = std::source_location::current())
+        : mutex_(mutex)
+    {
+        mutex_.lock(site);
+    }
+    ~NetProfiledLock() { mutex_.unlock(); }
+    NetProfiledLock(const NetProfiledLock &) = delete;
+    NetProfiledLock &operator=(const NetProfiledLock &) = delete;
+
+private:
+    NetProfiledLockable &mutex_;
+};
+#endif
+
+#endif // NET_LOCK_PROFILE_H
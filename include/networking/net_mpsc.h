@@ -0,0 +1,38 @@
+#ifndef NET_MPSC_H
+#define NET_MPSC_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /*
+     * Bounded multi-producer, single-consumer queue of fixed-size items.
+     *
+     * Every cell carries a sequence number telling producers and the consumer
+     * whose turn it is, so a push claims a cell with one compare-and-swap and
+     * a pop takes no atomic read-modify-write at all. Nothing blocks: a push
+     * into a full queue fails and the producer decides whether to retry.
+     *
+     * Any thread may push; only one thread at a time may pop or check for items.
+     */
+    typedef struct NetMpscQueue NetMpscQueue;
+
+    // capacity is rounded up to a power of two. Returns NULL when out of memory.
+    NetMpscQueue *net_mpsc_create(size_t capacity, size_t item_size);
+    void net_mpsc_destroy(NetMpscQueue *queue);
+
+    // Copy an item in. Returns 1, or 0 if the queue is full.
+    int net_mpsc_push(NetMpscQueue *queue, const void *item);
+    // Consumer only: copy the oldest item out. Returns 1, or 0 if the queue is empty.
+    int net_mpsc_pop(NetMpscQueue *queue, void *out_item);
+    // Consumer only: 1 if a pop would find nothing
+    int net_mpsc_empty(NetMpscQueue *queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_MPSC_H
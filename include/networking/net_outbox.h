@@ -0,0 +1,59 @@
+#ifndef NET_OUTBOX_H
+#define NET_OUTBOX_H
+
+#include "net_platform.h"
+#include "net_codec.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Frames that may wait for one slow connection before the policy kicks in
+#define NET_OUTBOX_CAPACITY 32
+
+    // What to do when a connection's outbox is full
+    typedef enum
+    {
+        NET_OUTBOX_POLICY_DROP = 0,   // Drop the new frame
+        NET_OUTBOX_POLICY_COALESCE,   // Drop queued state frames, the next update is sent as a keyframe
+        NET_OUTBOX_POLICY_DISCONNECT, // Shut the connection down
+    } NetOutboxPolicy;
+
+    typedef struct
+    {
+        size_t length;
+        unsigned char data[NET_FRAME_MAX_SIZE];
+    } NetOutboxFrame;
+
+    // Bounded FIFO of encoded frames waiting to be written to one socket.
+    // Not thread-safe; the owner serialises access.
+    typedef struct
+    {
+        net_socket_t sock;
+        NetOutboxFrame frames[NET_OUTBOX_CAPACITY];
+        size_t head;        // Index of the oldest frame
+        size_t count;       // Frames queued, including a partially written head
+        size_t head_offset; // Bytes of the head frame already written
+        unsigned long dropped_frames;
+        unsigned long coalesced_frames;
+    } NetOutbox;
+
+    void net_outbox_reset(NetOutbox *outbox, net_socket_t sock);
+    // Returns 1 if the frame was queued, 0 if the outbox is full or detached
+    int net_outbox_push(NetOutbox *outbox, const unsigned char *frame, size_t len);
+    // Drops queued frames whose EventType bit is set in type_mask, except a partially written head.
+    // Returns the number of frames dropped.
+    size_t net_outbox_discard(NetOutbox *outbox, unsigned int type_mask);
+    // Writes as much as the socket accepts without blocking.
+    // Returns 1 when the outbox is empty, 0 if the socket would block, -1 on error.
+    int net_outbox_flush(NetOutbox *outbox);
+
+#define NET_OUTBOX_TYPE_BIT(type) (1u << (unsigned int)(type))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_OUTBOX_H
@@ -28,10 +28,13 @@ typedef SOCKET net_socket_t;
 #define NET_EINTR WSAEINTR
 #define NET_EBADF WSAEBADF
 #define NET_MSG_DONTWAIT 0x1000
+#define NET_MSG_NOSIGNAL 0
+#define NET_SHUT_RDWR SD_BOTH
 
 /* Threading abstraction for cross-platform compatibility */
 typedef HANDLE net_thread_t;
 typedef CRITICAL_SECTION net_mutex_t;
+typedef CONDITION_VARIABLE net_cond_t;
 
 #define net_thread_create(thread, func, arg)                                            \
     (*(thread) = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)(func), (arg), 0, NULL), \
@@ -40,14 +43,30 @@ typedef CRITICAL_SECTION net_mutex_t;
     (WaitForSingleObject((thread), INFINITE), CloseHandle((thread)), 0)
 #define net_thread_detach(thread) \
     CloseHandle(thread)
+#define net_thread_yield() \
+    SwitchToThread()
 #define net_mutex_init(mutex) \
     (InitializeCriticalSection(mutex), 0)
 #define net_mutex_destroy(mutex) \
     DeleteCriticalSection(mutex)
 #define net_mutex_lock(mutex) \
     EnterCriticalSection(mutex)
+#define net_mutex_trylock(mutex) \
+    (TryEnterCriticalSection(mutex) ? 0 : -1)
 #define net_mutex_unlock(mutex) \
     LeaveCriticalSection(mutex)
+#define net_cond_init(cond) \
+    (InitializeConditionVariable(cond), 0)
+#define net_cond_destroy(cond) \
+    ((void)(cond))
+#define net_cond_wait(cond, mutex) \
+    SleepConditionVariableCS((cond), (mutex), INFINITE)
+#define net_cond_timedwait(cond, mutex, timeout_ms) \
+    SleepConditionVariableCS((cond), (mutex), (DWORD)(timeout_ms))
+#define net_cond_signal(cond) \
+    WakeConditionVariable(cond)
+#define net_cond_broadcast(cond) \
+    WakeAllConditionVariable(cond)
 
 #else
 #include <unistd.h>
@@ -59,6 +78,8 @@ typedef CRITICAL_SECTION net_mutex_t;
 #include <netinet/in.h>
 #include <errno.h>
 #include <pthread.h>
+#include <sched.h>
+#include <time.h>
 
 typedef int net_socket_t;
 #define NET_INVALID_SOCKET (-1)
@@ -70,10 +91,17 @@ typedef int net_socket_t;
 #define NET_EINTR EINTR
 #define NET_EBADF EBADF
 #define NET_MSG_DONTWAIT MSG_DONTWAIT
+#ifdef MSG_NOSIGNAL
+#define NET_MSG_NOSIGNAL MSG_NOSIGNAL
+#else
+#define NET_MSG_NOSIGNAL 0
+#endif
+#define NET_SHUT_RDWR SHUT_RDWR
 
 /* Threading abstraction for POSIX systems */
 typedef pthread_t net_thread_t;
 typedef pthread_mutex_t net_mutex_t;
+typedef pthread_cond_t net_cond_t;
 
 #define net_thread_create(thread, func, arg) \
     pthread_create((thread), NULL, (func), (arg))
@@ -81,14 +109,43 @@ typedef pthread_mutex_t net_mutex_t;
     pthread_join((thread), NULL)
 #define net_thread_detach(thread) \
     pthread_detach(thread)
+#define net_thread_yield() \
+    sched_yield()
 #define net_mutex_init(mutex) \
     pthread_mutex_init((mutex), NULL)
 #define net_mutex_destroy(mutex) \
     pthread_mutex_destroy(mutex)
 #define net_mutex_lock(mutex) \
     pthread_mutex_lock(mutex)
+#define net_mutex_trylock(mutex) \
+    pthread_mutex_trylock(mutex)
 #define net_mutex_unlock(mutex) \
     pthread_mutex_unlock(mutex)
+#define net_cond_init(cond) \
+    pthread_cond_init((cond), NULL)
+#define net_cond_destroy(cond) \
+    pthread_cond_destroy(cond)
+#define net_cond_wait(cond, mutex) \
+    pthread_cond_wait((cond), (mutex))
+#define net_cond_signal(cond) \
+    pthread_cond_signal(cond)
+#define net_cond_broadcast(cond) \
+    pthread_cond_broadcast(cond)
+
+/* pthread_cond_timedwait takes an absolute deadline */
+static inline int net_cond_timedwait(net_cond_t *cond, net_mutex_t *mutex, int timeout_ms)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return pthread_cond_timedwait(cond, mutex, &deadline);
+}
 
 #endif
 
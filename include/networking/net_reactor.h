@@ -0,0 +1,81 @@
+#ifndef NET_REACTOR_H
+#define NET_REACTOR_H
+
+#include "net_platform.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Readiness bits used both for registration interest and reported events
+#define NET_REACTOR_READ 0x1u
+#define NET_REACTOR_WRITE 0x2u
+#define NET_REACTOR_HANGUP 0x4u   // Reported only: peer closed or socket error
+#define NET_REACTOR_ACCEPTED 0x8u // Reported only: accepted holds a new connection
+#define NET_REACTOR_DATA 0x10u    // Reported only: data/length hold received bytes
+
+    typedef struct
+    {
+        void *userdata;
+        unsigned int events;       // NET_REACTOR_* bits
+        net_socket_t accepted;     // NET_REACTOR_ACCEPTED
+        const unsigned char *data; // NET_REACTOR_DATA; valid until the next net_reactor_wait
+        size_t length;
+    } NetReactorEvent;
+
+    typedef enum
+    {
+        NET_REACTOR_BACKEND_DEFAULT = 0, // epoll on Linux, poll()/WSAPoll() elsewhere
+        NET_REACTOR_BACKEND_URING,       // io_uring (Linux 6.0+)
+    } NetReactorBackend;
+
+    /*
+     * Readiness notifier for many sockets.
+     *
+     * Linux uses edge-triggered epoll; other platforms fall back to poll()/WSAPoll().
+     * Handlers must therefore read and write until the call would block, and must
+     * not expect a socket to be reported again while it is still readable.
+     *
+     * add/modify/wake may be called from any thread. remove must be called by the
+     * thread that waits on the reactor.
+     *
+     * The io_uring backend can also take over accepting and receiving
+     * (net_reactor_accept/net_reactor_recv), reporting completed work instead of
+     * readiness. The other backends refuse those calls and the caller falls back
+     * to readiness plus accept()/recv().
+     */
+    typedef struct NetReactor NetReactor;
+
+    NetReactor *net_reactor_create(void);
+    // Returns NULL if the backend is unavailable on this system
+    NetReactor *net_reactor_create_backend(NetReactorBackend backend);
+    void net_reactor_destroy(NetReactor *reactor);
+
+    int net_reactor_add(NetReactor *reactor, net_socket_t sock, unsigned int interest, void *userdata);
+    int net_reactor_modify(NetReactor *reactor, net_socket_t sock, unsigned int interest, void *userdata);
+    int net_reactor_remove(NetReactor *reactor, net_socket_t sock);
+
+    // Report each accepted connection as NET_REACTOR_ACCEPTED. Returns -1 if unsupported.
+    int net_reactor_accept(NetReactor *reactor, net_socket_t listen_sock, void *userdata);
+    // Report received bytes as NET_REACTOR_DATA and EOF/errors as NET_REACTOR_HANGUP.
+    // Returns -1 if unsupported. modify() then only changes the WRITE interest.
+    int net_reactor_recv(NetReactor *reactor, net_socket_t sock, void *userdata);
+
+    // Wait for readiness (timeout_ms < 0 waits forever).
+    // Returns the number of events stored, 0 on timeout or wake-up, -1 on error.
+    int net_reactor_wait(NetReactor *reactor, NetReactorEvent *events, int max_events, int timeout_ms);
+    // Make a concurrent or the next net_reactor_wait return early
+    void net_reactor_wake(NetReactor *reactor);
+
+    // Name of the reactor's backend, for logs
+    const char *net_reactor_backend(const NetReactor *reactor);
+    // Parses "default", "epoll", "poll", "uring" or "io_uring". Returns 0 on success.
+    int net_reactor_backend_from_name(const char *name, NetReactorBackend *out_backend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_REACTOR_H
@@ -0,0 +1,28 @@
+#ifndef NET_SNAPSHOT_H
+#define NET_SNAPSHOT_H
+
+#include "../common/events.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Field differences between two snapshots, as SNAPSHOT_SELF_* / SNAPSHOT_ENTRY_* masks
+    unsigned int net_snapshot_diff_self(const PlayerState *base, const PlayerState *next);
+    unsigned int net_snapshot_diff_entry(const PlayerPublicInfo *base, const PlayerPublicInfo *next);
+
+    // Fill the public entries and masks with the changes from base to next.
+    // A NULL base produces a keyframe with every field present.
+    void net_snapshot_make_public_delta(const PlayerPublicInfo *base, const PlayerPublicInfo *next, EventPayload_TurnInfo *turn);
+    void net_snapshot_make_private_delta(const PlayerState *base, const PlayerState *next, EventPayload_TurnPrivate *update);
+
+    // Copy the fields present in the update's masks into the client's view
+    void net_snapshot_apply_public(PlayerPublicInfo *entries, const EventPayload_TurnInfo *turn);
+    void net_snapshot_apply_private(PlayerState *self, const EventPayload_TurnPrivate *update);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_SNAPSHOT_H
@@ -0,0 +1,39 @@
+#ifndef NET_URING_H
+#define NET_URING_H
+
+#include "net_reactor.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /*
+     * io_uring backend behind net_reactor (Linux 6.0+).
+     *
+     * Sockets can be watched for readiness like with the other backends, or
+     * handed to the ring for completion-style I/O: a multishot accept reports
+     * each new connection, and a multishot recv delivers bytes straight from a
+     * registered buffer ring. Only net_reactor.c should call these.
+     */
+    typedef struct NetUring NetUring;
+
+    // Returns NULL when the kernel (or a seccomp policy) does not offer what we need
+    NetUring *net_uring_create(void);
+    void net_uring_destroy(NetUring *uring);
+
+    // Start, change or stop readiness reporting for sock (interest 0 stops it)
+    int net_uring_watch(NetUring *uring, net_socket_t sock, unsigned int interest, void *userdata);
+    int net_uring_accept(NetUring *uring, net_socket_t listen_sock, void *userdata);
+    int net_uring_recv(NetUring *uring, net_socket_t sock, void *userdata);
+    // Cancel everything pending on sock; no event for it is reported afterwards
+    int net_uring_remove(NetUring *uring, net_socket_t sock);
+
+    int net_uring_wait(NetUring *uring, NetReactorEvent *events, int max_events, int timeout_ms);
+    void net_uring_wake(NetUring *uring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_URING_H
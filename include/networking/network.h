@@ -13,26 +13,271 @@ extern "C"
 #define DEFAULT_PORT 8080
 #define ARMADA_DISCOVERY_REQUEST "ARMADA_DISCOVER_V1"
 #define ARMADA_DISCOVERY_RESPONSE "ARMADA_SERVER_V1"
+// Servers announce themselves on this multicast group; clients just listen
+#define ARMADA_BEACON "ARMADA_BEACON_V1"
+#define ARMADA_BEACON_GROUP "239.255.41.80"
+#define ARMADA_BEACON_PORT 8081
+
+// Pending connections the kernel queues per listening socket by default (capped by somaxconn)
+#define NET_LISTEN_BACKLOG 1024
 
     // Basic socket operations
     net_socket_t net_create_server_socket(int port);
+    // reuse_port shares the port between several listeners (SO_REUSEPORT); fails where unsupported
+    net_socket_t net_create_listen_socket(int port, int backlog, int reuse_port);
+    // Accepted sockets come back nonblocking and close-on-exec
+    net_socket_t net_accept_nonblocking(net_socket_t listen_sock);
+    // Nonblocking datagram socket bound to port (0: any)
+    net_socket_t net_create_udp_socket(int port);
     net_socket_t net_connect_to_server(const char *host, int port);
     void net_close_socket(net_socket_t sock);
+    int net_set_nonblocking(net_socket_t sock);
+
+#define NET_CONNECT_TIMEOUT_MS 3000
+#define NET_CONNECT_MAX_ADDRESSES 4
+#define NET_CONNECT_EARLY_DATA_MAX 128
+
+    // Resolves host (a literal address or a name, cached for a minute) to at most
+    // max_addresses TCP endpoints. Returns how many were stored, 0 if none.
+    int net_resolve_host(const char *host, int port, struct sockaddr_storage *out_addresses, socklen_t *out_lengths,
+                         int max_addresses);
+
+    typedef struct NetResolveJob NetResolveJob;
+
+    // Nonblocking connect to every address a host resolves to at once; the first
+    // to complete wins and the rest are closed
+    typedef struct
+    {
+        net_socket_t sockets[NET_CONNECT_MAX_ADDRESSES]; // NET_INVALID_SOCKET once an attempt failed
+        int socket_count;
+        NetResolveJob *resolving; // Name lookup still running, NULL once the connects started
+        uint64_t deadline_us;
+        // Sent as soon as the connection is up, inside the SYN with TCP Fast Open where possible
+        unsigned char early_data[NET_CONNECT_EARLY_DATA_MAX];
+        size_t early_length;
+        size_t early_sent;
+    } NetConnectAttempt;
+
+    // Starts connecting without blocking: a name that is neither a literal address
+    // nor cached is looked up on a background thread and net_connect_poll starts
+    // the connects once it resolves. Returns 0 if the attempt is under way, -1 otherwise.
+    int net_connect_begin(NetConnectAttempt *attempt, const char *host, int port, int timeout_ms,
+                          const void *early_data, size_t early_length);
+    // Waits up to wait_ms (0 just checks) for an attempt to finish. Returns 1 with a
+    // connected, blocking socket in out_sock and the early data sent, 0 while still
+    // resolving or connecting, -1 once the name did not resolve, every attempt
+    // failed or the deadline passed.
+    int net_connect_poll(NetConnectAttempt *attempt, int wait_ms, net_socket_t *out_sock);
+    void net_connect_cancel(NetConnectAttempt *attempt);
+
+#define NET_RECV_BUFFER_SIZE 8192
+
+    // Per-connection receive buffer. Holds bytes read from the socket until
+    // they form complete frames; a partial tail is kept for the next read.
+    typedef struct
+    {
+        unsigned char data[NET_RECV_BUFFER_SIZE];
+        size_t start; // Offset of the first unconsumed byte
+        size_t end;   // Offset one past the last received byte
+    } NetRecvBuffer;
+
+    void net_recv_buffer_reset(NetRecvBuffer *buffer);
+    // Reads everything currently available in a single recv().
+    // Returns bytes read (> 0), 0 if nothing was available, -1 on error/disconnect
+    int net_recv_buffer_fill(net_socket_t sock, NetRecvBuffer *buffer);
+    // Appends bytes received by other means. Returns 0 on success, -1 if they do not fit
+    int net_recv_buffer_append(NetRecvBuffer *buffer, const unsigned char *data, size_t len);
+    // Pops the next complete event. Returns 1 on success, 0 if more bytes are needed, -1 on a malformed frame
+    int net_recv_buffer_pop(NetRecvBuffer *buffer, GameEvent *event);
 
-    // Data transmission
+    // Data transmission (events travel as variable-length frames, see net_codec.h)
     // Returns 1 on success, 0 on failure/disconnect
     int net_send_event(net_socket_t sock, const GameEvent *event);
-    int net_receive_event(net_socket_t sock, GameEvent *event);
-    int net_receive_event_flags(net_socket_t sock, GameEvent *event, int flags);
+    int net_send_frame(net_socket_t sock, const unsigned char *frame, size_t len);
+    // Sends the events back to back in as few system calls as possible
+    int net_send_events(net_socket_t sock, const GameEvent *events, size_t count);
+    int net_receive_event(net_socket_t sock, NetRecvBuffer *buffer, GameEvent *event);
+    int net_receive_event_flags(net_socket_t sock, NetRecvBuffer *buffer, GameEvent *event, int flags);
     // Returns 1 on success, 0 on timeout, -1 on error/disconnect
-    int net_receive_event_timeout(net_socket_t sock, GameEvent *event, int timeout_ms);
+    int net_receive_event_timeout(net_socket_t sock, NetRecvBuffer *buffer, GameEvent *event, int timeout_ms);
+
+#define NET_SENDV_MAX_SLICES 64
+
+    // One buffer of a gathered write
+    typedef struct
+    {
+        const void *data;
+        size_t length;
+    } NetIoSlice;
+
+    // Writes up to NET_SENDV_MAX_SLICES buffers with a single sendmsg()/WSASend().
+    // Returns bytes written or NET_SOCKET_ERROR (see NET_ERRNO()).
+    ssize_t net_sendv(net_socket_t sock, const NetIoSlice *slices, size_t count, int flags);
+    // Holds back partial TCP segments while enabled (TCP_CORK/TCP_NOPUSH).
+    // Returns -1 where the platform has no such option.
+    int net_set_cork(net_socket_t sock, int enabled);
+
+    // A UDP payload and where to send it
+    typedef struct
+    {
+        struct sockaddr_in addr;
+        const void *data;
+        size_t length;
+    } NetDatagram;
+
+    // Sends every datagram, with a single sendmmsg() where available.
+    // Returns the number of datagrams sent.
+    int net_send_datagrams(net_socket_t sock, const NetDatagram *datagrams, size_t count);
+
+    // Up IPv4 interfaces, as discovery sees them
+#define NET_MAX_INTERFACES 16
+#define NET_INTERFACE_BROADCAST 0x1u
+#define NET_INTERFACE_MULTICAST 0x2u
+#define NET_INTERFACE_LOOPBACK 0x4u
+    typedef struct
+    {
+        struct in_addr address;
+        struct in_addr broadcast; // Valid with NET_INTERFACE_BROADCAST
+        unsigned int flags;       // NET_INTERFACE_* bits
+    } NetInterface;
+
+    // Lists the IPv4 interfaces that are up. Returns how many were stored.
+    int net_list_interfaces(NetInterface *out_interfaces, int max_interfaces);
+
+    // A server heard from on the LAN
+    typedef struct
+    {
+        char address[64];
+        int port;
+        int player_count;
+        int max_players;
+        uint32_t server_id;         // Random per server run; tells apart one server seen on several interfaces
+        int phase;                  // LobbyPhase; servers that do not send it count as LOBBY_PHASE_WAITING
+        int protocol_version;       // ARMADA_WIRE_VERSION the server speaks
+        int rtt_us;                 // Probe round trip, -1 until measured
+        uint64_t last_seen_us;      // net_monotonic_us() of its latest beacon or reply
+        uint64_t next_rtt_probe_us; // Beacon listener: when net_beacon_measure_rtt probes it next, 0 at once
+        int rtt_misses;             // Beacon listener: probes in a row that went unanswered
+    } NetLanHost;
+
+    // Whether a join would be turned away: full, mid-match or another wire version
+    int net_lan_host_joinable(const NetLanHost *host);
+    // Parse "<prefix> <port> <players> <max> [<id> <phase> <version>]" sent from `from`.
+    // Returns 1 on success, 0 if payload does not start with prefix.
+    int net_parse_lan_host(const char *payload, const char *prefix, const struct sockaddr_in *from, NetLanHost *out_host);
+
+    // Called for each server as soon as its reply arrives. Return nonzero to stop early.
+    typedef int (*NetDiscoveryCallback)(const NetLanHost *host, void *userdata);
 
     // Discovery helpers
     int net_discover_lan_servers(char hosts[][64], int max_hosts, int port, int timeout_ms);
+    // Probes every interface's broadcast address and this machine at once, then
+    // reports replies as they come in until timeout_ms, each with its round trip.
+    // Returns the number reported.
+    int net_discover_lan_servers_stream(int port, int timeout_ms, NetDiscoveryCallback callback, void *userdata);
+
+#define NET_BEACON_INTERVAL_MS 1000
+// A host that missed this many beacons in a row is dropped from the table
+#define NET_BEACON_TTL_MS (3 * NET_BEACON_INTERVAL_MS + 500)
+#define NET_BEACON_MAX_HOSTS 32
+// Round-trip probes of beacon hosts: refresh interval for hosts that answer,
+// and the first retry and longest backoff for hosts that do not
+#define NET_BEACON_RTT_REFRESH_MS 10000
+#define NET_BEACON_RTT_RETRY_MS 1000
+#define NET_BEACON_RTT_BACKOFF_MAX_MS 60000
+
+    // Server side: prepare a UDP socket to send beacons to ARMADA_BEACON_GROUP
+    int net_beacon_configure_sender(net_socket_t sock);
+    // Send one beacon payload to the group on every multicast interface, and to
+    // this machine. Returns 0 if it left through at least one of them.
+    int net_beacon_send(net_socket_t sock, const char *payload, size_t length);
+
+    // Client side: live table of the servers whose beacons arrive, filled
+    // passively instead of probing the network
+    typedef struct
+    {
+        net_socket_t sock;
+        NetLanHost hosts[NET_BEACON_MAX_HOSTS];
+        int host_count;
+    } NetBeaconListener;
+
+    // Join the beacon group on every multicast interface. Returns 0 on success, -1 on failure.
+    int net_beacon_listen(NetBeaconListener *listener);
+    // Take in every beacon that arrives within wait_ms (0 only drains) and drop
+    // hosts that went quiet for NET_BEACON_TTL_MS.
+    // Returns 1 if the table changed, 0 if not, -1 on a socket error.
+    int net_beacon_poll(NetBeaconListener *listener, int wait_ms);
+    // Beacons travel one way, so probe the listed hosts to fill in rtt_us. Each
+    // due host gets one unicast probe: new hosts at once, answered ones every
+    // NET_BEACON_RTT_REFRESH_MS, silent ones with a doubling backoff. Cheap to
+    // call on every poll. Returns the number of hosts measured.
+    int net_beacon_measure_rtt(NetBeaconListener *listener, int port, int timeout_ms);
+    void net_beacon_close(NetBeaconListener *listener);
+
+// Default heartbeat cadence for both ends: ping every interval, drop a peer
+// that stayed silent for longer than the timeout
+#define NET_HEARTBEAT_INTERVAL_MS 1000
+#define NET_HEARTBEAT_TIMEOUT_MS 5000
+// How long a dropped player's slot stays reserved for a resume
+#define NET_RESUME_GRACE_MS 30000
+
+    // Microseconds from an arbitrary start, never going backwards
+    uint64_t net_monotonic_us(void);
+
+    // Smoothed round-trip time of one peer, fed from ping/pong samples.
+    // Uses the RFC 6298 weights: srtt moves 1/8 and jitter 1/4 towards each sample.
+    typedef struct
+    {
+        unsigned int srtt_us;
+        unsigned int jitter_us; // Mean deviation of the samples from srtt
+        unsigned int last_us;
+        unsigned long samples;
+    } NetRttStats;
+
+    void net_rtt_reset(NetRttStats *stats);
+    void net_rtt_sample(NetRttStats *stats, unsigned int rtt_us);
+
+    // Token bucket limit: rate_per_sec tokens a second, at most burst saved up.
+    // A rate of 0 lifts the limit.
+    typedef struct
+    {
+        unsigned int rate_per_sec;
+        unsigned int burst;
+    } NetRateLimit;
+
+    typedef struct
+    {
+        uint64_t tokens;     // In millionths of a token
+        uint64_t updated_us; // net_monotonic_us() of the last refill
+    } NetTokenBucket;
+
+    // Start full, so a new peer gets its whole burst
+    void net_token_bucket_reset(NetTokenBucket *bucket, const NetRateLimit *limit, uint64_t now_us);
+    // Spend one token. Returns 1 if there was one, 0 if the limit is exceeded.
+    int net_token_bucket_take(NetTokenBucket *bucket, const NetRateLimit *limit, uint64_t now_us);
 
     // Logging helpers
     void net_log_socket_error(const char *context);
 
+    // System calls made by the networking layer, for benchmarks
+    typedef enum
+    {
+        NET_IO_WAIT = 0, // Blocking for readiness or completions
+        NET_IO_READ,     // recv/recvfrom/accept and wake-up drains
+        NET_IO_WRITE,    // send/sendto
+        NET_IO_CONTROL,  // Registration changes, submissions and wake-ups
+        NET_IO_COUNTER_COUNT
+    } NetIoCounter;
+
+    typedef struct
+    {
+        unsigned long counts[NET_IO_COUNTER_COUNT];
+    } NetIoStats;
+
+    void net_io_count(NetIoCounter counter);
+    void net_io_stats_get(NetIoStats *out_stats);
+    void net_io_stats_reset(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,13 +2,72 @@
 #define SERVER_MAIN_H
 
 #include "../server/server_api.h"
+#include "../networking/net_reactor.h"
+#include "../networking/network.h"
+
+// Upper bound for server_set_io_threads
+#define SERVER_MAX_IO_THREADS 16
+// Readiness events handled per reactor wake-up
+#define SERVER_IO_BATCH 64
+// Commands the I/O threads can have in flight to the game thread
+#define SERVER_COMMAND_QUEUE_CAPACITY 1024
+// Commands the game thread runs between flushes of the outboxes
+#define SERVER_GAME_BATCH 64
+
+// One accepted TCP connection, owned by a single I/O thread
+typedef struct ServerConnection
+{
+    net_socket_t sock;
+    struct ServerIoThread *owner;
+    NetRecvBuffer recv_buffer;
+    int write_interest; // Registered for writability while its outbox is blocked
+    int streaming;      // The reactor delivers received bytes (io_uring multishot recv)
+    int closed;         // Closed by its I/O thread; freed by the game thread after SERVER_COMMAND_CLOSE
+    int detached;       // No outbox may be bound to it any more (roster_mutex)
+    int notify_close;   // The game thread must handle the disconnect of its player
+    int forfeit_resume; // Closed for flooding: its player is removed without a resume grace period
+    uint64_t last_heard_us; // net_monotonic_us() when bytes last arrived
+    uint64_t last_ping_us;
+    uint32_t ping_sequence;
+    NetTokenBucket total_bucket;                    // Every event from this connection
+    NetTokenBucket event_buckets[EVENT_TYPE_COUNT]; // One per event type
+    unsigned int flood_drops;                       // Events refused in a row by total_bucket
+    struct ServerConnection *prev;
+    struct ServerConnection *next;
+} ServerConnection;
+
+// Work handed from the I/O threads to the game thread. Commands about one
+// connection all come from its owner, so the game thread sees them in order.
+typedef enum
+{
+    SERVER_COMMAND_EVENT, // An admitted event from conn
+    SERVER_COMMAND_PING,  // Queue the heartbeat in event for conn's player
+    SERVER_COMMAND_CLOSE, // conn was closed: release its player and free it
+    SERVER_COMMAND_STOP   // Every I/O thread has exited; nothing follows
+} ServerCommandType;
 
-// Arguments passed to each client thread
 typedef struct
+{
+    ServerCommandType type;
+    ServerConnection *conn;
+    uint64_t received_us; // net_monotonic_us() when the bytes arrived
+    GameEvent event;
+} ServerCommand;
+
+// Event loop thread state
+typedef struct ServerIoThread
 {
     ServerContext *ctx;
-    net_socket_t socket_fd;
-} ClientThreadArgs;
+    int index;
+    NetReactor *reactor;
+    net_thread_t thread;
+    net_socket_t listen_socket;    // Own SO_REUSEPORT listener; NET_INVALID_SOCKET when thread 0 accepts for everyone
+    ServerConnection *connections; // Registered with this thread's reactor
+    ServerConnection *incoming;    // Handed over by thread 0, adopted on the next wake-up
+    ServerConnection *closed;      // Closed connections whose events may still be in the batch
+    uint64_t next_heartbeat_us;    // When this thread next pings and checks for silent peers
+    net_mutex_t incoming_mutex;
+} ServerIoThread;
 
 // Server callback functions
 int server_on_init(ServerContext *ctx);
@@ -16,29 +75,82 @@ void server_on_initialized(ServerContext *ctx, int max_players);
 void server_on_starting(ServerContext *ctx, int port);
 void server_on_start_failed(ServerContext *ctx, const char *message);
 void server_on_started(ServerContext *ctx, int port);
-void server_on_accept_thread_started(ServerContext *ctx);
-void server_on_accept_thread_failed(ServerContext *ctx, const char *message);
+void server_on_io_threads_started(ServerContext *ctx, int thread_count, const char *backend);
+void server_on_io_threads_failed(ServerContext *ctx, const char *message);
 void server_on_stopping(ServerContext *ctx);
 void server_on_client_connected(ServerContext *ctx, net_socket_t socket_fd);
+void server_on_connection_rejected(ServerContext *ctx, const char *reason);
 void server_on_client_disconnected(ServerContext *ctx, net_socket_t socket_fd);
 void server_on_unhandled_event(ServerContext *ctx, EventType type);
 void server_on_unknown_action(ServerContext *ctx, UserActionType action, int player_id);
+void server_on_slow_consumer(ServerContext *ctx, int player_id, NetOutboxPolicy policy);
+void server_on_heartbeat_timeout(ServerContext *ctx, net_socket_t socket_fd, int silent_ms);
+void server_on_flood_disconnect(ServerContext *ctx, net_socket_t socket_fd, unsigned int dropped);
+void server_on_player_away(ServerContext *ctx, int player_id, const char *player_name, int grace_ms);
+void server_on_player_resumed(ServerContext *ctx, int player_id, const char *player_name, int replayed_frames);
+
+// Event loop
+static void *server_io_thread(void *arg);
+static void server_watch_listener(ServerIoThread *io, net_socket_t listen_sock, void *userdata);
+static void server_open_acceptors(ServerContext *ctx);
+static void server_accept_connections(ServerIoThread *io, net_socket_t listen_sock);
+static int server_is_full(ServerContext *ctx);
+static void server_reject_connection(ServerContext *ctx, net_socket_t sock);
+static void server_take_connection(ServerIoThread *acceptor, net_socket_t new_socket);
+static void server_adopt_connections(ServerIoThread *io);
+static void server_read_connection(ServerIoThread *io, ServerConnection *conn);
+static void server_receive_data(ServerIoThread *io, ServerConnection *conn, const unsigned char *data, size_t length);
+static void server_close_connection(ServerIoThread *io, ServerConnection *conn, int notify);
+static void server_flush_outboxes(ServerContext *ctx);
+static void server_flush_outbox_locked(ServerContext *ctx, int player_id);
+static void server_default_rate_limits(ServerContext *ctx);
+static LobbyPhase server_lobby_phase(ServerContext *ctx);
+static size_t server_format_announcement(ServerContext *ctx, const char *prefix, int player_count, LobbyPhase phase, char *out, size_t out_size);
+static void server_announce_change(ServerContext *ctx);
+static void server_send_beacon(ServerContext *ctx, uint64_t now_us);
+static void server_count(volatile long *counter);
+static int server_admit_event(ServerIoThread *io, ServerConnection *conn, const GameEvent *event);
+static void server_check_heartbeats(ServerIoThread *io, uint64_t now_us);
+static uint64_t server_io_deadline_us(ServerIoThread *io);
+static int server_wait_ms(uint64_t deadline_us);
 
-// Thread entry points
-static void *server_accept_thread(void *arg);
-static void *server_client_thread(void *arg);
+// Game thread
+static int server_start_game_thread(ServerContext *ctx);
+static void server_stop_game_thread(ServerContext *ctx);
+static void *server_game_thread(void *arg);
+static void server_full_fence(void);
+static void server_set_flag(volatile long *flag, long value);
+static long server_take_flag(volatile long *flag);
+static void server_publish_snapshot(ServerContext *ctx);
+static void server_submit_command(ServerContext *ctx, const ServerCommand *command);
+static void server_game_wait(ServerContext *ctx);
+static void server_run_command(ServerContext *ctx, const ServerCommand *command);
+static void server_release_connection(ServerContext *ctx, ServerConnection *conn);
 
 // Event handlers
-static void server_handle_event(ServerContext *ctx, net_socket_t sender_socket, const GameEvent *event);
-static void server_handle_player_join(ServerContext *ctx, net_socket_t sender_socket, const EventPayload_PlayerJoin *payload);
+static void server_handle_event(ServerContext *ctx, net_socket_t sender_socket, const GameEvent *event, uint64_t received_us);
+static void server_handle_player_join(ServerContext *ctx, ServerConnection *conn, const EventPayload_PlayerJoin *payload);
 static void server_handle_user_action(ServerContext *ctx, const EventPayload_UserAction *payload);
 static void server_handle_match_start_request(ServerContext *ctx, int requester_id);
+static void server_handle_resync_request(ServerContext *ctx, int requester_id);
 static void server_handle_disconnect(ServerContext *ctx, net_socket_t socket_fd);
+static int server_handle_resume(ServerContext *ctx, ServerConnection *conn, const EventPayload_PlayerJoin *payload);
+static void server_handle_leave(ServerContext *ctx, int player_id);
+static void server_remove_player(ServerContext *ctx, int player_id);
+static void server_expire_away_players(ServerContext *ctx, uint64_t now_us);
+static void server_handle_ping(ServerContext *ctx, int player_id, const EventPayload_Heartbeat *ping);
+static void server_handle_pong(ServerContext *ctx, int player_id, const EventPayload_Heartbeat *pong, uint64_t received_us);
 void server_on_turn_action(ServerContext *ctx, const EventPayload_UserAction *action);
 
 // Event sending helpers
 static void server_broadcast_event(ServerContext *ctx, const GameEvent *event);
 static void server_send_event_to(ServerContext *ctx, int player_id, const GameEvent *event);
+static void server_send_events_to(ServerContext *ctx, int player_id, const GameEvent *events, int count);
+static void server_queue_frame(ServerContext *ctx, int player_id, const unsigned char *frame, size_t len);
+static void server_queue_event(ServerContext *ctx, int player_id, const GameEvent *event);
+static void server_detach_outbox(ServerContext *ctx, ServerConnection *conn);
+static void server_keep_missed_locked(ServerContext *ctx, int player_id, const unsigned char *frame, size_t len);
+static void server_salvage_outbox_locked(ServerContext *ctx, int player_id);
 static void server_broadcast_current_turn(ServerContext *ctx, int is_match_start, const EventPayload_UserAction *last_action);
 
 // Player management helpers
@@ -47,10 +159,16 @@ static int server_find_open_slot(ServerContext *ctx);
 static int server_find_player_by_socket(ServerContext *ctx, net_socket_t socket_fd);
 static void server_reset_player(PlayerState *player, int player_id, const char *name);
 static void server_refresh_player_count(ServerContext *ctx);
+static void server_build_lobby_snapshot(ServerContext *ctx, EventPayload_LobbySnapshot *lobby);
+static uint64_t server_new_resume_token(ServerContext *ctx);
 
 // Game state helpers
 static void server_start_match(ServerContext *ctx);
-static void server_emit_turn_event(ServerContext *ctx, EventType type, int turn_number, int current_id, int next_id, int is_match_start, const EventPayload_UserAction *last_action, int threshold_player_id);
+static void server_emit_turn_event(ServerContext *ctx, EventType type, int turn_number, int current_id, int next_id, int is_match_start, const EventPayload_UserAction *last_action, int threshold_player_id, int target_viewer);
+static unsigned int server_next_snapshot_version(unsigned int version);
+static void server_advance_public_view(ServerContext *ctx, const PlayerPublicInfo *view, EventPayload_TurnInfo *turn);
+static void server_build_private_state(ServerContext *ctx, int viewer_id, int valid_actions, int keyframe, NetOutboxFrame *out_frame);
+static void server_build_turn(ServerContext *ctx, ServerTurnBuffer *build, GameEvent *event, int current_id, int target_viewer);
 static void server_advance_turn(ServerContext *ctx, const EventPayload_UserAction *last_action);
 static int server_next_active_player(ServerContext *ctx, int start_after);
 static int server_compute_valid_actions(ServerContext *ctx, int player_id, int current_player_id);
@@ -75,13 +193,12 @@ extern "C"
 
 // Misc helpers
 static void server_emit_host_update(ServerContext *ctx, int host_id, const char *host_name);
-static int server_collect_active_players(ServerContext *ctx, int *out_ids, int max_ids);
-static int server_build_player_snapshot(ServerContext *ctx, int viewer_id, PlayerGameState *out_state);
+static void server_build_public_view(ServerContext *ctx, PlayerPublicInfo *out_view);
 static int to_coarse_percent(int current, int max);
-static int server_select_host_locked(ServerContext *ctx);
+static int server_select_host(ServerContext *ctx);
 static void server_send_error_event(ServerContext *ctx, int player_id, int error_code, const char *message);
 static int server_start_discovery_service(ServerContext *ctx);
 static void server_stop_discovery_service(ServerContext *ctx);
-static void *server_discovery_thread(void *arg);
+static void server_answer_discovery(ServerContext *ctx);
 
 #endif // SERVER_MAIN_H
@@ -4,6 +4,73 @@
 #include "../common/events.h"
 #include "../common/game_types.h"
 #include "../networking/net_platform.h"
+#include "../networking/net_lock_profile.h"
+#include "../networking/net_mpsc.h"
+#include "../networking/net_outbox.h"
+#include "../networking/net_reactor.h"
+#include "../networking/network.h"
+
+// Last private state sent to one player slot, the base for its next delta
+typedef struct
+{
+    PlayerState sent_self;
+    int sent_valid_actions;
+    unsigned int version; // 0 until the first private update is sent
+    int needs_keyframe;   // Set on join, match start and resync requests
+} ServerViewerSnapshot;
+
+// Everything one turn event sends, built in a single pass by the game thread and
+// queued once complete. Kept in ServerContext so no turn allocates.
+typedef struct
+{
+    int viewer_count;
+    int viewer_ids[MAX_PLAYERS];
+    int valid_actions[MAX_PLAYERS];
+    int public_keyframe[MAX_PLAYERS];           // Gets keyframe_frame rather than delta_frame
+    NetOutboxFrame private_frames[MAX_PLAYERS]; // Empty when the viewer's own state did not change
+    NetOutboxFrame delta_frame;
+    NetOutboxFrame keyframe_frame;
+    int host_changed; // The host was reselected while building
+    int host_id;
+    char host_name[MAX_NAME_LEN];
+} ServerTurnBuffer;
+
+// Frames kept for a player whose connection dropped, replayed when it resumes
+#define SERVER_RESUME_REPLAY_FRAMES 16
+
+// Lets a player whose connection dropped reclaim its slot with the token from its join ack
+typedef struct
+{
+    uint64_t token;       // 0 when the slot cannot be resumed (empty, or left on purpose)
+    uint64_t deadline_us; // net_monotonic_us() at which an away player is removed, 0 while connected
+    // Frames the player missed, oldest first. Turn updates are not kept; a
+    // resumed player gets a keyframe instead. Guarded by the slot's player mutex.
+    NetOutboxFrame missed[SERVER_RESUME_REPLAY_FRAMES];
+    int missed_count;
+    int missed_overflow; // Frames were lost: resume with a lobby snapshot instead of the replay
+} ServerResumeSlot;
+
+// Events turned away by admission control, for monitoring
+typedef struct
+{
+    unsigned long throttled[EVENT_TYPE_COUNT]; // Over the limit for their event type, discarded
+    unsigned long dropped;                     // Over a connection's overall limit, discarded
+    unsigned long disconnected;                // Connections closed for flooding
+} ServerAdmissionStats;
+
+// What threads other than the game thread may read about a running server:
+// a consistent copy published after every batch of changes (server_read_snapshot)
+typedef struct
+{
+    GameState game_state;
+    NetRttStats peer_rtt[MAX_PLAYERS];
+    int max_players;
+    LobbyPhase phase;     // As shown to browsing clients
+    int has_away_players; // Some slot is held for a player who may resume
+} ServerSnapshot;
+
+struct ServerIoThread;
+struct ServerConnection;
 
 typedef struct ServerContext
 {
@@ -14,9 +81,91 @@ typedef struct ServerContext
     net_socket_t server_socket;
     net_socket_t player_sockets[MAX_PLAYERS];
     net_socket_t discovery_socket;
-    net_mutex_t state_mutex;
-    net_thread_t accept_thread;
-    net_thread_t discovery_thread;
+    ServerViewerSnapshot viewer_snapshots[MAX_PLAYERS];
+    PlayerPublicInfo public_view[MAX_PLAYERS]; // Last broadcast public view, shared by every viewer
+    unsigned int public_version;               // Version of public_view, 0 until the first broadcast
+    ServerTurnBuffer turn_buffer;              // Used by the game thread for each turn event
+
+    // Event loop threads. Thread 0 also owns the listening and discovery sockets;
+    // accepted connections are spread over all threads, or each thread accepts
+    // its own on a shared port when SO_REUSEPORT is available.
+    struct ServerIoThread *io_threads;
+    int io_thread_count;
+    int next_io_thread;
+    int acceptor_count; // Listening sockets: 1, or one per thread sharing the port via SO_REUSEPORT
+    int listen_backlog;
+    NetReactorBackend io_backend; // Requested backend; falls back to the default if unavailable
+
+    // Game thread: the only writer of game_state. I/O threads admit and decode
+    // events, then hand them over as ServerCommands (server/main.h) through a
+    // lock-free queue rather than running game logic themselves.
+    NetMpscQueue *commands;
+    net_thread_t game_thread;
+    volatile long game_sleeping; // Set while the game thread waits on game_wake
+    net_mutex_t game_wake_mutex;
+    net_cond_t game_wake;
+
+    // Published copy for every other reader (beacons, discovery, admission and
+    // the host UI), behind a seqlock so they never touch game_state or see a
+    // half-written state: snapshot_sequence is odd while the copy is rewritten.
+    ServerSnapshot snapshot;
+    volatile long snapshot_sequence;
+
+    // Outbound frames per player slot, queued by the game thread and written by
+    // it and the I/O threads. Each slot's outbox, connection and missed frames
+    // have their own player mutex, so work on different players never waits.
+    // roster_mutex covers binding connections to slots (joins, resumes and
+    // closes). Lock order: roster_mutex, then player mutexes in ascending slot
+    // order. Player state itself has no per-player lock, so an attack never
+    // takes two of them: the game thread is its only writer.
+    NetOutbox outboxes[MAX_PLAYERS];
+    struct ServerConnection *slot_connections[MAX_PLAYERS]; // Connection that owns each slot's socket
+    NetOutboxPolicy slow_consumer_policy;
+    NetProfiledMutex roster_mutex;
+    NetProfiledMutex player_mutexes[MAX_PLAYERS];
+
+    // Heartbeats: joined connections are pinged every interval and any connection
+    // silent for longer than the timeout is closed. 0 disables either.
+    int heartbeat_interval_ms;
+    int heartbeat_timeout_ms;
+    NetRttStats peer_rtt[MAX_PLAYERS]; // Round trip per player slot, kept by the game thread
+
+    // Session resume: a player whose connection drops stays in the game, skipped
+    // in the turn order, for resume_grace_ms (0 removes it right away). The
+    // grace is atomic so it can be changed while the game thread runs.
+    volatile long resume_grace_ms;
+    uint64_t resume_seed;
+    ServerResumeSlot resume_slots[MAX_PLAYERS]; // token and deadline belong to the game thread
+    uint64_t away_deadline_us;                  // Earliest away deadline, 0 when nobody is away. Set by the game thread.
+
+    // LAN beacon sent by thread 0 every NET_BEACON_INTERVAL_MS, and at once when
+    // the player count or phase changes: the game thread raises beacon_due once
+    // the change is published. The schedule and cached text belong to thread 0.
+    int beacon_enabled;
+    int announce_pending;      // A change awaits the next publication (game thread)
+    volatile long beacon_due;
+    uint64_t next_beacon_us;
+    uint32_t server_id; // Sent with beacons and probe replies so clients merge copies from several interfaces
+    int beacon_multicast; // 0 if the group cannot be reached; directory heartbeats still go out
+    int beacon_player_count;
+    int beacon_phase;
+    char beacon[64];
+    size_t beacon_length;
+
+    // Directory (net_directory.h) that receives a heartbeat with every beacon, if set
+    int has_directory;
+    struct sockaddr_in directory_addr;
+    char heartbeat[64];
+    size_t heartbeat_length;
+
+    // Admission control: every connection gets a token bucket for all its events
+    // and one per event type, checked by its I/O thread before the event reaches
+    // the game thread. Fixed while the server runs.
+    NetRateLimit connection_limit;
+    NetRateLimit event_limits[EVENT_TYPE_COUNT];
+    volatile long throttled_events[EVENT_TYPE_COUNT]; // Updated atomically by the I/O threads
+    volatile long dropped_events;
+    volatile long flood_disconnects;
 } ServerContext;
 
 #ifdef __cplusplus
@@ -30,6 +179,32 @@ extern "C"
     int server_init(ServerContext *ctx, int max_players);
     void server_start(ServerContext *ctx);
     void server_stop(ServerContext *ctx);
+    // Choose what happens to a client whose outbox fills up (default: coalesce)
+    void server_set_slow_consumer_policy(ServerContext *ctx, NetOutboxPolicy policy);
+    // Number of event loop threads used by the next server_start (default 1)
+    void server_set_io_threads(ServerContext *ctx, int count);
+    // Reactor backend used by the next server_start (default: ARMADA_IO_BACKEND, else epoll/poll)
+    void server_set_io_backend(ServerContext *ctx, NetReactorBackend backend);
+    // Ping interval and silence timeout used by the next server_start (defaults: NET_HEARTBEAT_*)
+    void server_set_heartbeat(ServerContext *ctx, int interval_ms, int timeout_ms);
+    // How long a dropped player's slot stays reserved for a resume (default NET_RESUME_GRACE_MS, 0 disables)
+    void server_set_resume_grace(ServerContext *ctx, int grace_ms);
+    // Pending connection queue length per listener (default NET_LISTEN_BACKLOG)
+    void server_set_listen_backlog(ServerContext *ctx, int backlog);
+    // Register with the directory at "host[:port]" while running (default: ARMADA_DIRECTORY).
+    // NULL or "" stops registering. Returns -1 if the address does not resolve.
+    int server_set_directory(ServerContext *ctx, const char *directory);
+    // Token bucket limit per connection for one event type, used by the next server_start.
+    // EVENT_UNKNOWN sets the limit on all of a connection's events together. A rate of 0 lifts it.
+    void server_set_rate_limit(ServerContext *ctx, EventType type, unsigned int rate_per_sec, unsigned int burst);
+    // Counts of events refused by the rate limits since server_create
+    void server_get_admission_stats(ServerContext *ctx, ServerAdmissionStats *out_stats);
+    // Copy the state last published by the game thread, from any thread
+    void server_read_snapshot(ServerContext *ctx, ServerSnapshot *out_snapshot);
+    // Copies a player's round-trip estimate. Returns 0 on success, -1 for an empty slot.
+    int server_get_peer_rtt(ServerContext *ctx, int player_id, NetRttStats *out_stats);
+    // Backend the running server actually uses ("epoll", "poll" or "io_uring"), NULL when stopped
+    const char *server_get_io_backend_name(const ServerContext *ctx);
 
 #ifdef __cplusplus
 }
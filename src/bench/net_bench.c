@@ -0,0 +1,381 @@
+/*
+ * Loopback benchmark for the server's I/O backends.
+ *
+ * Starts an in-process server, connects bot players over 127.0.0.1 and plays
+ * END_TURN actions as fast as the server answers. For each backend it reports
+ * the server's networking system calls per turn and the turn latency (time from
+ * sending the action until every bot has received the next EVENT_TURN_STARTED).
+ *
+ * The bots talk to their sockets with plain send()/recv(), so the networking
+ * layer's counters (net_io_stats_get) only see the server's calls.
+ *
+ * Usage: armada_net_bench [--backend default|uring|both] [--turns N] [--players N] [--io-threads N]
+ */
+#include "../../include/server/server_api.h"
+#include "../../include/networking/network.h"
+#include "../../include/networking/net_codec.h"
+#include "../../include/networking/net_reactor.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_WARMUP_TURNS 50
+#define BENCH_TIMEOUT_MS 2000
+
+typedef struct
+{
+    net_socket_t sock;
+    NetRecvBuffer buffer;
+    int player_id;
+    int current_player_id;
+    unsigned long turn_events; // EVENT_TURN_STARTED frames received
+    int game_over;
+} BenchBot;
+
+typedef struct
+{
+    const char *backend;
+    unsigned long turns;
+    NetIoStats stats;
+    double p50_us;
+    double p99_us;
+    double max_us;
+} BenchResult;
+
+static double bench_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static int bench_send(BenchBot *bot, const GameEvent *event)
+{
+    unsigned char frame[NET_FRAME_MAX_SIZE];
+    size_t len = net_encode_event(event, frame, sizeof(frame));
+    size_t offset = 0;
+    while (offset < len)
+    {
+        ssize_t sent = send(bot->sock, (const char *)frame + offset, len - offset, NET_MSG_NOSIGNAL);
+        if (sent <= 0)
+            return -1;
+        offset += (size_t)sent;
+    }
+    return 0;
+}
+
+// Read what is available (waiting up to timeout_ms) and apply every complete event
+static int bench_pump(BenchBot *bot, int timeout_ms)
+{
+    struct pollfd pfd;
+    pfd.fd = bot->sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, timeout_ms) <= 0)
+        return 0;
+
+    unsigned char chunk[4096];
+    ssize_t received = recv(bot->sock, (char *)chunk, sizeof(chunk), 0);
+    if (received <= 0 || net_recv_buffer_append(&bot->buffer, chunk, (size_t)received) != 0)
+        return -1;
+
+    GameEvent event;
+    int popped;
+    while ((popped = net_recv_buffer_pop(&bot->buffer, &event)) > 0)
+    {
+        switch (event.type)
+        {
+        case EVENT_PLAYER_JOIN_ACK:
+            bot->player_id = event.data.join_ack.success ? event.data.join_ack.player_id : -2;
+            break;
+        case EVENT_TURN_STARTED:
+            bot->current_player_id = event.data.turn.current_player_id;
+            bot->turn_events++;
+            break;
+        case EVENT_GAME_OVER:
+            bot->game_over = 1;
+            break;
+        default:
+            break;
+        }
+    }
+    return popped < 0 ? -1 : 0;
+}
+
+// Pump every bot until each has seen a turn after its baseline, or a game over
+static int bench_wait_turn(BenchBot *bots, int count, const unsigned long *baseline)
+{
+    double deadline = bench_now_us() + BENCH_TIMEOUT_MS * 1000.0;
+    for (int i = 0; i < count; ++i)
+    {
+        while (bots[i].turn_events == baseline[i] && !bots[i].game_over)
+        {
+            if (bench_now_us() > deadline || bench_pump(&bots[i], 10) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static int bench_compare_double(const void *a, const void *b)
+{
+    double lhs = *(const double *)a;
+    double rhs = *(const double *)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+static int bench_join(BenchBot *bots, int players, int *connected)
+{
+    for (int i = 0; i < players; ++i)
+    {
+        memset(&bots[i], 0, sizeof(bots[i]));
+        net_recv_buffer_reset(&bots[i].buffer);
+        bots[i].player_id = -1;
+        bots[i].sock = net_connect_to_server("127.0.0.1", DEFAULT_PORT);
+        if (bots[i].sock == NET_INVALID_SOCKET)
+            return -1;
+        (*connected)++;
+
+        GameEvent join;
+        memset(&join, 0, sizeof(join));
+        join.type = EVENT_PLAYER_JOIN_REQUEST;
+        snprintf(join.data.join_req.player_name, sizeof(join.data.join_req.player_name), "bot%d", i);
+        if (bench_send(&bots[i], &join) != 0)
+            return -1;
+        double deadline = bench_now_us() + BENCH_TIMEOUT_MS * 1000.0;
+        while (bots[i].player_id == -1)
+        {
+            if (bench_now_us() > deadline || bench_pump(&bots[i], 10) < 0)
+                return -1;
+        }
+        if (bots[i].player_id < 0)
+            return -1;
+    }
+
+    unsigned long baseline[MAX_PLAYERS];
+    for (int i = 0; i < players; ++i)
+        baseline[i] = bots[i].turn_events;
+
+    GameEvent request;
+    memset(&request, 0, sizeof(request));
+    request.type = EVENT_MATCH_START_REQUEST;
+    request.sender_id = bots[0].player_id;
+    if (bench_send(&bots[0], &request) != 0)
+        return -1;
+    return bench_wait_turn(bots, players, baseline);
+}
+
+static void bench_add_stats(NetIoStats *total, const NetIoStats *before, const NetIoStats *after)
+{
+    for (int i = 0; i < NET_IO_COUNTER_COUNT; ++i)
+        total->counts[i] += after->counts[i] - before->counts[i];
+}
+
+/*
+ * Plays one match on a fresh server until it ends or enough turns were measured.
+ * Matches always end (income alone reaches the star goal) and the server keeps
+ * stars across matches, so every match gets its own server. Only turns after the
+ * warm-up are timed and only their system calls are added to the result.
+ */
+static int bench_play_match(NetReactorBackend backend, int players, int io_threads,
+                            double *latencies, int turns, int *measured, int *warmup, BenchResult *result)
+{
+    ServerContext *server = server_create();
+    if (!server || server_init(server, players) != 0)
+        return -1;
+    server_set_io_backend(server, backend);
+    server_set_io_threads(server, io_threads);
+    server_set_heartbeat(server, 0, 0); // Bots do not answer pings; keep them out of the counts
+    // Bots play thousands of turns a second, far past the limits meant for people
+    for (int type = 0; type < EVENT_TYPE_COUNT; ++type)
+        server_set_rate_limit(server, (EventType)type, 0, 0);
+    server_start(server);
+    if (!server->running)
+    {
+        server_destroy(server);
+        return -1;
+    }
+    result->backend = server_get_io_backend_name(server);
+
+    BenchBot bots[MAX_PLAYERS];
+    int connected = 0;
+    int status = bench_join(bots, players, &connected);
+
+    NetIoStats before;
+    net_io_stats_get(&before);
+    while (status == 0 && *measured < turns && !bots[0].game_over)
+    {
+        BenchBot *actor = NULL;
+        for (int i = 0; i < players; ++i)
+        {
+            if (bots[i].player_id == bots[0].current_player_id)
+                actor = &bots[i];
+        }
+        if (!actor)
+        {
+            status = -1;
+            break;
+        }
+
+        unsigned long baseline[MAX_PLAYERS];
+        for (int i = 0; i < players; ++i)
+            baseline[i] = bots[i].turn_events;
+
+        GameEvent action;
+        memset(&action, 0, sizeof(action));
+        action.type = EVENT_USER_ACTION;
+        action.sender_id = actor->player_id;
+        action.data.action.player_id = actor->player_id;
+        action.data.action.action_type = USER_ACTION_END_TURN;
+        action.data.action.target_player_id = -1;
+
+        double started = bench_now_us();
+        if (bench_send(actor, &action) != 0 || bench_wait_turn(bots, players, baseline) != 0)
+        {
+            status = -1;
+            break;
+        }
+        double elapsed = bench_now_us() - started;
+
+        if (*warmup > 0)
+        {
+            if (--(*warmup) == 0)
+                net_io_stats_get(&before);
+            continue;
+        }
+        if (!bots[0].game_over)
+        {
+            latencies[(*measured)++] = elapsed;
+            result->turns++;
+        }
+    }
+    NetIoStats after;
+    net_io_stats_get(&after);
+    if (*warmup == 0)
+        bench_add_stats(&result->stats, &before, &after);
+
+    for (int i = 0; i < connected; ++i)
+        net_close_socket(bots[i].sock);
+    server_stop(server);
+    server_destroy(server);
+    return status;
+}
+
+static int bench_run(NetReactorBackend backend, int players, int turns, int io_threads, BenchResult *result)
+{
+    double *latencies = (double *)calloc((size_t)turns, sizeof(double));
+    if (!latencies)
+        return -1;
+
+    int measured = 0;
+    int warmup = BENCH_WARMUP_TURNS;
+    int status = 0;
+    while (status == 0 && measured < turns)
+        status = bench_play_match(backend, players, io_threads, latencies, turns, &measured, &warmup, result);
+
+    if (status == 0 && measured > 0)
+    {
+        qsort(latencies, (size_t)measured, sizeof(double), bench_compare_double);
+        result->p50_us = latencies[measured / 2];
+        result->p99_us = latencies[(size_t)((measured - 1) * 0.99)];
+        result->max_us = latencies[measured - 1];
+    }
+    free(latencies);
+    return status;
+}
+
+static void bench_print(const BenchResult *result)
+{
+    double turns = result->turns ? (double)result->turns : 1.0;
+    unsigned long total = 0;
+    for (int i = 0; i < NET_IO_COUNTER_COUNT; ++i)
+        total += result->stats.counts[i];
+    printf("%-9s %7lu %9.2f %6.2f %6.2f %6.2f %6.2f %9.1f %9.1f %9.1f\n",
+           result->backend,
+           result->turns,
+           total / turns,
+           result->stats.counts[NET_IO_WAIT] / turns,
+           result->stats.counts[NET_IO_READ] / turns,
+           result->stats.counts[NET_IO_WRITE] / turns,
+           result->stats.counts[NET_IO_CONTROL] / turns,
+           result->p50_us,
+           result->p99_us,
+           result->max_us);
+}
+
+static void bench_usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [--backend default|uring|both] [--turns N] [--players N] [--io-threads N]\n", argv0);
+}
+
+int main(int argc, char **argv)
+{
+    const char *backend_arg = "both";
+    int turns = 2000;
+    int players = MAX_PLAYERS;
+    int io_threads = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc)
+            backend_arg = argv[++i];
+        else if (strcmp(argv[i], "--turns") == 0 && i + 1 < argc)
+            turns = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--players") == 0 && i + 1 < argc)
+            players = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--io-threads") == 0 && i + 1 < argc)
+            io_threads = atoi(argv[++i]);
+        else
+        {
+            bench_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (turns <= 0 || players < MIN_PLAYERS || players > MAX_PLAYERS)
+    {
+        bench_usage(argv[0]);
+        return 2;
+    }
+
+    NetReactorBackend backends[2];
+    int backend_count = 0;
+    if (strcmp(backend_arg, "both") == 0)
+    {
+        backends[backend_count++] = NET_REACTOR_BACKEND_DEFAULT;
+        backends[backend_count++] = NET_REACTOR_BACKEND_URING;
+    }
+    else if (net_reactor_backend_from_name(backend_arg, &backends[0]) == 0)
+    {
+        backend_count = 1;
+    }
+    else
+    {
+        bench_usage(argv[0]);
+        return 2;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    printf("%d players, %d measured turns after %d warm-up turns, %d I/O thread(s)\n",
+           players, turns, BENCH_WARMUP_TURNS, io_threads);
+    printf("%-9s %7s %9s %6s %6s %6s %6s %9s %9s %9s\n",
+           "backend", "turns", "sys/turn", "wait", "read", "write", "ctl", "p50 us", "p99 us", "max us");
+
+    int failed = 0;
+    for (int i = 0; i < backend_count; ++i)
+    {
+        BenchResult result;
+        memset(&result, 0, sizeof(result));
+        if (bench_run(backends[i], players, turns, io_threads, &result) != 0)
+        {
+            fprintf(stderr, "Benchmark run failed (%s)\n", result.backend ? result.backend : "server did not start");
+            failed = 1;
+            continue;
+        }
+        bench_print(&result);
+    }
+    return failed;
+}
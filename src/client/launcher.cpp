@@ -3,6 +3,9 @@
 #include "../../include/client/ui_notifications.h"
 #include "../../include/common/events.h"
 #include "../../include/networking/network.h"
+#include "../../include/networking/net_codec.h"
+#include "../../include/networking/net_directory.h"
+#include "../../include/networking/net_lock_profile.h"
 #include "../../include/server/server_api.h"
 #include "../../include/server/main.h"
 #include <ftxui/component/component.hpp>
@@ -14,6 +17,7 @@
 #include <chrono>
 #include <deque>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <memory>
@@ -66,6 +70,14 @@ namespace
     using ftxui::window;
     using ftxui::yframe;
 
+    // "12.3 ms (jitter 1.2)" from a smoothed round-trip estimate
+    std::string format_rtt(const NetRttStats &rtt)
+    {
+        char buffer[48];
+        std::snprintf(buffer, sizeof(buffer), "%.1f ms (jitter %.1f)", rtt.srtt_us / 1000.0, rtt.jitter_us / 1000.0);
+        return buffer;
+    }
+
     // Parse ANSI color codes and convert to FTXUI elements
     Element parse_ansi_line(const std::string &line)
     {
@@ -305,8 +317,13 @@ namespace
                                                    { return !hosting_; });
             auto stop_visible = stop_btn | Maybe([&]
                                                  { return hosting_; });
+            // Only offered when ARMADA_LOCK_PROFILE is recording
+            auto profile_btn = SimpleButton("Lock Profile", [&]
+                                            { dump_lock_profile(); });
+            auto profile_visible = profile_btn | Maybe([]
+                                                       { return net_lock_profile_enabled() != 0; });
 
-            auto controls = Container::Horizontal({start_visible, stop_visible});
+            auto controls = Container::Horizontal({start_visible, stop_visible, profile_visible});
 
             // Wrap to auto-focus start button when not hosting
             return Renderer(controls, [this, controls, start_btn]
@@ -326,11 +343,24 @@ namespace
 
             if (hosting_ && host_server_)
             {
-                GameState &gs = host_server_->game_state;
+                // The game thread keeps playing while we draw; work from one published copy
+                ServerSnapshot snapshot;
+                server_read_snapshot(host_server_.get(), &snapshot);
+                const GameState &gs = snapshot.game_state;
 
-                stats_elements.push_back(text("Players: " + std::to_string(gs.player_count) + "/" + std::to_string(host_server_->max_players)));
+                stats_elements.push_back(text("Players: " + std::to_string(gs.player_count) + "/" + std::to_string(snapshot.max_players)));
                 stats_elements.push_back(text("Match Started: " + std::string(gs.match_started ? "Yes" : "No")));
 
+                ServerAdmissionStats admission;
+                server_get_admission_stats(host_server_.get(), &admission);
+                unsigned long throttled = 0;
+                for (int type = 0; type < EVENT_TYPE_COUNT; ++type)
+                    throttled += admission.throttled[type];
+                if (throttled > 0 || admission.dropped > 0)
+                {
+                    stats_elements.push_back(text("Rate Limited: " + std::to_string(throttled + admission.dropped) + " events, " + std::to_string(admission.disconnected) + " clients closed") | color(Color::Yellow));
+                }
+
                 if (gs.match_started)
                 {
                     stats_elements.push_back(text("Turn: " + std::to_string(gs.turn.turn_number)));
@@ -353,6 +383,8 @@ namespace
                         if (gs.match_started && gs.turn.current_player_id == i)
                             status_str += " <- Turn";
                         std::string player_line = "  " + std::to_string(i) + ": " + gs.players[i].name + status_str;
+                        if (snapshot.peer_rtt[i].samples > 0)
+                            player_line += " | RTT: " + format_rtt(snapshot.peer_rtt[i]);
                         if (gs.match_started)
                         {
                             player_line += " | Stars: " + std::to_string(gs.players[i].stars);
@@ -448,10 +480,18 @@ namespace
         {
             name_input_component_ = Input(&player_name_, "Voyager");
             manual_input_component_ = Input(&manual_ip_, "192.168.0.42");
+            if (const char *directory = std::getenv("ARMADA_DIRECTORY"))
+                directory_address_ = directory;
+            directory_input_component_ = Input(&directory_address_, "directory.example:8082");
+            auto browse_option = MenuOption::Toggle();
+            browse_option.on_change = [&]
+            { start_join_scan(); };
+            browse_mode_component_ = Menu(&browse_modes_, &browse_mode_index_, browse_option);
             host_list_component_ = Radiobox(&lan_hosts_display_, &selected_host_index_);
 
             auto join_controls = build_join_controls();
-            auto join_stack = Container::Vertical({name_input_component_, manual_input_component_, host_list_component_, join_controls});
+            auto join_stack = Container::Vertical({name_input_component_, manual_input_component_, directory_input_component_,
+                                                   browse_mode_component_, host_list_component_, join_controls});
 
             join_component_ = Renderer(join_stack, [this, join_controls]
                                        { return vbox({
@@ -459,10 +499,15 @@ namespace
                                                     separator(),
                                                     hbox({text("Player Name: ") | size(WIDTH, ftxui::EQUAL, 14), name_input_component_->Render() | flex}),
                                                     hbox({text("Manual IP: ") | size(WIDTH, ftxui::EQUAL, 14), manual_input_component_->Render() | flex}),
+                                                    hbox({text("Directory: ") | size(WIDTH, ftxui::EQUAL, 14), directory_input_component_->Render() | flex}),
                                                     separator(),
-                                                    text("Discovered LAN Servers:") | bold,
+                                                    hbox({text("Browse: ") | size(WIDTH, ftxui::EQUAL, 14), browse_mode_component_->Render()}),
+                                                    text(browsing_directory() ? "Directory Servers:" : "Discovered LAN Servers:") | bold,
                                                     host_list_component_->Render() | flex | border,
-                                                    text("Auto-scanning every 10s. Press 'Search Now' to refresh.") | dim,
+                                                    text(browsing_directory()
+                                                             ? "Refreshed every 5s. 'Search Now' also picks up a new directory address."
+                                                             : "Servers appear as they announce themselves. Press 'Search Now' to refresh.") |
+                                                        dim,
                                                     separator(),
                                                     join_controls->Render(),
                                                 }) |
@@ -482,7 +527,7 @@ namespace
                 { send_start_request(); },
                 [&]
                 {
-                    std::lock_guard<std::mutex> lock(client_mutex_);
+                    NetProfiledLock lock(client_mutex_);
                     return client_ && client_->is_host;
                 });
 
@@ -492,7 +537,7 @@ namespace
         void show_attack_dialog(const std::vector<int> &planet_ids)
         {
             (void)planet_ids;
-            std::lock_guard<std::mutex> lock(client_mutex_);
+            NetProfiledLock lock(client_mutex_);
             if (!client_ || !client_->connected || !(client_->valid_actions & VALID_ACTION_ATTACK_PLANET))
                 return;
 
@@ -524,7 +569,7 @@ namespace
             auto attack_btn = StyledButton("⚔ Attack", [&]
                                            { show_attack_dialog(target_player_ids_); }, [&]
                                            {
-                std::lock_guard<std::mutex> lock(client_mutex_);
+                NetProfiledLock lock(client_mutex_);
                 return client_ && client_->connected &&
                    client_->current_turn_player_id == client_->player_id &&
                    (client_->valid_actions & VALID_ACTION_ATTACK_PLANET); });
@@ -532,7 +577,7 @@ namespace
             auto repair_btn = StyledButton("🔧 Repair", [&]
                                            { client_send_action(client_.get(), USER_ACTION_REPAIR_PLANET, -1, 0, 0); }, [&]
                                            {
-                std::lock_guard<std::mutex> lock(client_mutex_);
+                NetProfiledLock lock(client_mutex_);
                 return client_ && client_->connected &&
                    client_->current_turn_player_id == client_->player_id &&
                    (client_->valid_actions & VALID_ACTION_REPAIR_PLANET); });
@@ -540,7 +585,7 @@ namespace
             auto upgrade_planet_btn = StyledButton("🪐 Upgrade Planet", [&]
                                                    { client_send_action(client_.get(), USER_ACTION_UPGRADE_PLANET, -1, 0, 0); }, [&]
                                                    {
-                std::lock_guard<std::mutex> lock(client_mutex_);
+                NetProfiledLock lock(client_mutex_);
                 return client_ && client_->connected &&
                    client_->current_turn_player_id == client_->player_id &&
                    (client_->valid_actions & VALID_ACTION_UPGRADE_PLANET); });
@@ -548,7 +593,7 @@ namespace
             auto upgrade_ship_btn = StyledButton("🚀 Upgrade Ship", [&]
                                                  { client_send_action(client_.get(), USER_ACTION_UPGRADE_SHIP, -1, 0, 0); }, [&]
                                                  {
-                std::lock_guard<std::mutex> lock(client_mutex_);
+                NetProfiledLock lock(client_mutex_);
                 return client_ && client_->connected &&
                    client_->current_turn_player_id == client_->player_id &&
                    (client_->valid_actions & VALID_ACTION_UPGRADE_SHIP); });
@@ -556,7 +601,7 @@ namespace
             auto skip_btn = StyledButton("⏭ Skip Turn", [&]
                                          { client_send_action(client_.get(), USER_ACTION_END_TURN, -1, 0, 0); }, [&]
                                          {
-                std::lock_guard<std::mutex> lock(client_mutex_);
+                NetProfiledLock lock(client_mutex_);
                 return client_ && client_->connected &&
                    client_->current_turn_player_id == client_->player_id; });
 
@@ -614,7 +659,7 @@ namespace
         Element render_other_players()
         {
             // Lock the mutex to ensure the pump thread isn't writing while we read
-            std::lock_guard<std::mutex> lock(client_mutex_);
+            NetProfiledLock lock(client_mutex_);
 
             // Check if client exists before dereferencing
             if (!client_ || !client_->connected)
@@ -657,7 +702,7 @@ namespace
         Element render_self_info()
         {
             // Lock the mutex to ensure the pump thread isn't writing while we read
-            std::lock_guard<std::mutex> lock(client_mutex_);
+            NetProfiledLock lock(client_mutex_);
 
             if (!client_ || !client_->connected)
                 return vbox();
@@ -710,7 +755,7 @@ namespace
             std::string current_player_name;
 
             {
-                std::lock_guard<std::mutex> lock(client_mutex_);
+                NetProfiledLock lock(client_mutex_);
                 if (client_)
                 {
                     match_started = client_->match_started;
@@ -745,12 +790,12 @@ namespace
             // Use Maybe to show prematch or game controls based on match state
             auto prematch_visible = prematch_controls | Maybe([&]
                                                               {
-                std::lock_guard<std::mutex> lock(client_mutex_);
+                NetProfiledLock lock(client_mutex_);
                 return !client_ || !client_->match_started; });
 
             auto game_controls_visible = game_actions_button | Maybe([&]
                                                                      {
-            std::lock_guard<std::mutex> lock(client_mutex_);
+            NetProfiledLock lock(client_mutex_);
              return client_ && client_->match_started; });
 
             auto base_controls = Container::Vertical({prematch_visible, game_controls_visible});
@@ -762,9 +807,16 @@ namespace
                 bool is_host = false;
 
                 {
-                    std::lock_guard<std::mutex> lock(client_mutex_);
-                    status = (client_ && client_->connected) ? "Connected" : "Disconnected";
+                    NetProfiledLock lock(client_mutex_);
+                    if (client_ && client_->connected)
+                        status = "Connected";
+                    else if (client_ && client_->connecting)
+                        status = "Connecting...";
+                    else
+                        status = "Disconnected";
                     is_host = client_ && client_->is_host;
+                    if (client_ && client_->connected && client_->rtt.samples > 0)
+                        status += " | RTT: " + format_rtt(client_->rtt);
                 }
 
                 auto other_players_panel = window(text("Opponents"), render_other_players());
@@ -798,23 +850,107 @@ namespace
 
         // SCANNING
 
+        bool browsing_directory() const
+        {
+            return browse_mode_index_ == kBrowseDirectory;
+        }
+
         void start_join_scan()
         {
             stop_join_scan();
             scanning_ = true;
+            scan_now_requested_ = false;
+            if (browsing_directory())
+            {
+                std::string directory = directory_address_;
+                scan_thread_ = std::thread([this, directory]()
+                                           { poll_directory(directory); });
+                return;
+            }
             scan_thread_ = std::thread([this]()
                                        {
-                constexpr auto kScanSleepChunk = 100ms;
-                constexpr int kChunksPerRefresh = static_cast<int>(std::chrono::seconds(10) / kScanSleepChunk);
-                while (scanning_)
+                if (!listen_for_beacons())
+                    probe_for_hosts(); });
+        }
+
+        // Directory mode: list the joinable servers the directory knows, across subnets
+        void poll_directory(const std::string &directory)
+        {
+            constexpr auto kScanSleepChunk = 100ms;
+            constexpr int kChunksPerRefresh = static_cast<int>(std::chrono::seconds(5) / kScanSleepChunk);
+            constexpr int kFetchTimeoutMs = 600; // Also bounds how long stop_join_scan waits
+            if (directory.empty())
+            {
+                append_log("Enter a directory address to browse it.");
+                refresh_lan_hosts({});
+                return;
+            }
+
+            std::vector<NetLanHost> hosts(ARMADA_DIRECTORY_MAX_RESULTS);
+            bool reachable = true;
+            while (scanning_)
+            {
+                int found = net_directory_fetch(directory.c_str(), NET_DIRECTORY_JOINABLE, hosts.data(),
+                                                static_cast<int>(hosts.size()), kFetchTimeoutMs);
+                if (found < 0 && reachable)
+                    append_log("Directory " + directory + " is not answering.");
+                reachable = found >= 0;
+                refresh_lan_hosts(std::vector<NetLanHost>(hosts.begin(), hosts.begin() + std::max(found, 0)));
+
+                for (int tick = 0; tick < kChunksPerRefresh && scanning_ && !scan_now_requested_; ++tick)
                 {
-                    perform_lan_scan();
-                    for (int tick = 0; tick < kChunksPerRefresh && scanning_ && !scan_now_requested_; ++tick)
-                    {
-                        std::this_thread::sleep_for(kScanSleepChunk);
-                    }
-                    scan_now_requested_ = false;
-                } });
+                    std::this_thread::sleep_for(kScanSleepChunk);
+                }
+                scan_now_requested_ = false;
+            }
+        }
+
+        // Keep the host list in step with the servers' multicast beacons.
+        // Returns false if beacons cannot be received here.
+        bool listen_for_beacons()
+        {
+            // Bounds how long stop_join_scan waits for this thread
+            constexpr int kBeaconWaitMs = 250;
+            constexpr int kRttProbeMs = 200;
+            NetBeaconListener listener;
+            if (net_beacon_listen(&listener) != 0)
+                return false;
+
+            bool ok = true;
+            while (scanning_)
+            {
+                int changed = net_beacon_poll(&listener, kBeaconWaitMs);
+                if (changed < 0)
+                {
+                    ok = false;
+                    break;
+                }
+
+                // Beacons carry no timing; only hosts due for a probe get one
+                if (net_beacon_measure_rtt(&listener, DEFAULT_PORT, kRttProbeMs) > 0)
+                    changed = 1;
+
+                if (changed > 0 || scan_now_requested_.exchange(false))
+                    refresh_lan_hosts(std::vector<NetLanHost>(listener.hosts, listener.hosts + listener.host_count));
+            }
+            net_beacon_close(&listener);
+            return ok;
+        }
+
+        // Fallback for networks without multicast: broadcast a probe every 10 seconds
+        void probe_for_hosts()
+        {
+            constexpr auto kScanSleepChunk = 100ms;
+            constexpr int kChunksPerRefresh = static_cast<int>(std::chrono::seconds(10) / kScanSleepChunk);
+            while (scanning_)
+            {
+                perform_lan_scan();
+                for (int tick = 0; tick < kChunksPerRefresh && scanning_ && !scan_now_requested_; ++tick)
+                {
+                    std::this_thread::sleep_for(kScanSleepChunk);
+                }
+                scan_now_requested_ = false;
+            }
         }
 
         void stop_join_scan()
@@ -827,27 +963,78 @@ namespace
 
         void trigger_scan_now()
         {
-            scan_now_requested_ = true;
+            if (browsing_directory())
+                start_join_scan(); // The address may have been edited
+            else
+                scan_now_requested_ = true;
         }
 
+        struct LanScan
+        {
+            ArmadaApp *app;
+            std::vector<NetLanHost> hosts;
+        };
+
+        // Show each server as its reply arrives instead of after the whole window
         void perform_lan_scan()
         {
-            char hosts_raw[ARMADA_DISCOVERY_MAX_RESULTS][64] = {};
-            int found = net_discover_lan_servers(hosts_raw, ARMADA_DISCOVERY_MAX_RESULTS, DEFAULT_PORT, 200);
-            std::vector<std::string> hosts;
-            if (found > 0)
+            LanScan scan{this, {}};
+            net_discover_lan_servers_stream(DEFAULT_PORT, 200, &ArmadaApp::lan_host_thunk, &scan);
+            if (scan.hosts.empty())
+                refresh_lan_hosts(scan.hosts);
+        }
+
+        static int lan_host_thunk(const NetLanHost *host, void *userdata)
+        {
+            auto *scan = static_cast<LanScan *>(userdata);
+            scan->hosts.push_back(*host);
+            scan->app->refresh_lan_hosts(scan->hosts);
+            return !scan->app->scanning_ || static_cast<int>(scan->hosts.size()) >= ARMADA_DISCOVERY_MAX_RESULTS;
+        }
+
+        // Joinable servers first, each group by round trip, unmeasured ones last
+        static bool lan_host_before(const NetLanHost &a, const NetLanHost &b)
+        {
+            bool a_joinable = net_lan_host_joinable(&a) != 0;
+            bool b_joinable = net_lan_host_joinable(&b) != 0;
+            if (a_joinable != b_joinable)
+                return a_joinable;
+            if ((a.rtt_us < 0) != (b.rtt_us < 0))
+                return b.rtt_us < 0;
+            return a.rtt_us < b.rtt_us;
+        }
+
+        static std::wstring describe_lan_host(const NetLanHost &host)
+        {
+            std::ostringstream line;
+            line << host.address << "  " << host.player_count << "/" << host.max_players << " players";
+            if (host.rtt_us >= 0)
             {
-                hosts.reserve(found);
-                for (int i = 0; i < found; ++i)
-                    hosts.emplace_back(hosts_raw[i]);
+                char rtt[32];
+                std::snprintf(rtt, sizeof(rtt), "  %.1f ms", host.rtt_us / 1000.0);
+                line << rtt;
             }
-            refresh_lan_hosts(hosts);
+            if (host.protocol_version != ARMADA_WIRE_VERSION)
+                line << "  [incompatible v" << host.protocol_version << "]";
+            else if (host.phase == LOBBY_PHASE_IN_MATCH)
+                line << "  [in match]";
+            else if (host.max_players > 0 && host.player_count >= host.max_players)
+                line << "  [full]";
+            std::string text = line.str();
+            return std::wstring(text.begin(), text.end());
         }
 
-        void refresh_lan_hosts(const std::vector<std::string> &hosts)
+        void refresh_lan_hosts(std::vector<NetLanHost> hosts)
         {
+            std::stable_sort(hosts.begin(), hosts.end(), lan_host_before);
+
             std::lock_guard<std::mutex> lock(host_mutex_);
-            lan_hosts_ = hosts;
+            // Keep the same server selected while the list reorders
+            std::string selected;
+            if (selected_host_index_ >= 0 && static_cast<std::size_t>(selected_host_index_) < lan_hosts_.size())
+                selected = lan_hosts_[selected_host_index_].address;
+
+            lan_hosts_ = std::move(hosts);
             lan_hosts_display_.clear();
             if (lan_hosts_.empty())
             {
@@ -856,8 +1043,12 @@ namespace
             }
             else
             {
-                for (const auto &host : lan_hosts_)
-                    lan_hosts_display_.push_back(std::wstring(host.begin(), host.end()));
+                for (std::size_t i = 0; i < lan_hosts_.size(); ++i)
+                {
+                    lan_hosts_display_.push_back(describe_lan_host(lan_hosts_[i]));
+                    if (!selected.empty() && selected == lan_hosts_[i].address)
+                        selected_host_index_ = static_cast<int>(i);
+                }
                 if (selected_host_index_ < 0)
                     selected_host_index_ = 0;
                 selected_host_index_ = std::min<int>(selected_host_index_, static_cast<int>(lan_hosts_.size() - 1));
@@ -873,7 +1064,7 @@ namespace
             {
                 std::lock_guard<std::mutex> lock(host_mutex_);
                 if (selected_host_index_ >= 0 && static_cast<std::size_t>(selected_host_index_) < lan_hosts_.size())
-                    address = lan_hosts_[selected_host_index_];
+                    address = lan_hosts_[selected_host_index_].address;
             }
 
             if (address.empty())
@@ -900,14 +1091,17 @@ namespace
                 player_name_ = "Voyager";
 
             {
-                std::lock_guard<std::mutex> lock(client_mutex_);
-                if (client_ && client_->connected)
+                NetProfiledLock lock(client_mutex_);
+                if (client_ && (client_->connected || client_->connecting))
                 {
                     append_log("Already connected. Disconnect first.");
                     return;
                 }
             }
 
+            // The last session's pump thread may still be retrying a resume
+            join_pump_thread();
+
             ClientContext *raw = client_create(player_name_.c_str());
             if (!raw)
             {
@@ -919,7 +1113,7 @@ namespace
             active_address_ = address;
 
             {
-                std::lock_guard<std::mutex> lock(client_mutex_);
+                NetProfiledLock lock(client_mutex_);
                 if (client_connect(client_.get(), address.c_str()) != 0)
                 {
                     append_log("Unable to connect to " + address + ".");
@@ -935,16 +1129,27 @@ namespace
             stop_join_scan();
         }
 
-        void stop_client_session()
+        // Stops the pump thread, waking it if it sleeps in client_wait
+        void join_pump_thread()
         {
             pumping_ = false;
+            {
+                NetProfiledLock lock(client_mutex_);
+                if (client_)
+                    client_wake(client_.get());
+            }
             if (pump_thread_.joinable())
                 pump_thread_.join();
+        }
+
+        void stop_client_session()
+        {
+            join_pump_thread();
 
-            std::lock_guard<std::mutex> lock(client_mutex_);
+            NetProfiledLock lock(client_mutex_);
             if (client_)
             {
-                if (client_->connected)
+                if (client_->connected || client_->connecting)
                     client_disconnect(client_.get());
                 client_.reset();
             }
@@ -958,21 +1163,62 @@ namespace
             }
         }
 
+        // After a dropped connection, retry the resume once a second for as long as
+        // the server holds our slot. Returns false once there is nothing left to try.
+        bool try_resume(std::chrono::steady_clock::time_point &give_up_at, std::chrono::steady_clock::time_point &next_attempt)
+        {
+            if (client_->resume_token == 0)
+                return false;
+
+            auto now = std::chrono::steady_clock::now();
+            if (give_up_at == std::chrono::steady_clock::time_point{})
+            {
+                give_up_at = now + std::chrono::milliseconds(NET_RESUME_GRACE_MS);
+                next_attempt = now;
+            }
+            if (now >= give_up_at)
+                return false;
+            if (now >= next_attempt)
+            {
+                next_attempt = now + 1s;
+                client_resume(client_.get());
+            }
+            return true;
+        }
+
+        // Sleeps in client_wait until the server sends something, then handles the
+        // whole batch under one lock and posts a single redraw for it
         void pump_loop()
         {
+            std::chrono::steady_clock::time_point give_up_at{};
+            std::chrono::steady_clock::time_point next_attempt{};
+            int last_state = -1;
             while (pumping_)
             {
+                ClientContext *client = nullptr;
+                bool changed = false;
                 {
-                    std::lock_guard<std::mutex> lock(client_mutex_);
+                    NetProfiledLock lock(client_mutex_);
                     if (client_)
                     {
-                        client_pump(client_.get());
-                        if (!client_->connected)
+                        client = client_.get();
+                        changed = client_pump(client) > 0;
+                        if (client->connected)
+                            give_up_at = std::chrono::steady_clock::time_point{};
+                        else if (!client->connecting && !try_resume(give_up_at, next_attempt))
                             pumping_ = false;
+
+                        int state = (client->connected ? 1 : 0) | (client->connecting ? 2 : 0);
+                        changed = changed || state != last_state;
+                        last_state = state;
                     }
                 }
-                request_redraw();
-                std::this_thread::sleep_for(50ms);
+                if (changed)
+                    request_redraw();
+                if (!client || !pumping_)
+                    break;
+                // Bounded so a pending resume is retried on time
+                client_wait(client, 1000);
             }
             request_redraw();
         }
@@ -987,14 +1233,14 @@ namespace
         // GAME ACTIONS
         void send_start_request()
         {
-            std::lock_guard<std::mutex> lock(client_mutex_);
+            NetProfiledLock lock(client_mutex_);
             if (client_ && client_->connected && client_->is_host)
                 client_request_match_start(client_.get());
         }
 
         void show_attack_dialog()
         {
-            std::lock_guard<std::mutex> lock(client_mutex_);
+            NetProfiledLock lock(client_mutex_);
             if (!client_ || !client_->connected || !(client_->valid_actions & VALID_ACTION_ATTACK_PLANET))
                 return;
 
@@ -1026,7 +1272,7 @@ namespace
             if (dialog_mode_ != DialogMode::Attack)
                 return;
 
-            std::lock_guard<std::mutex> lock(client_mutex_);
+            NetProfiledLock lock(client_mutex_);
             if (!client_ || !client_->connected || !(client_->valid_actions & VALID_ACTION_ATTACK_PLANET))
             {
                 dialog_mode_ = DialogMode::None;
@@ -1048,21 +1294,21 @@ namespace
 
         void send_repair()
         {
-            std::lock_guard<std::mutex> lock(client_mutex_);
+            NetProfiledLock lock(client_mutex_);
             if (client_ && client_->connected && (client_->valid_actions & VALID_ACTION_REPAIR_PLANET))
                 client_send_action(client_.get(), USER_ACTION_REPAIR_PLANET, -1, 20, 0);
         }
 
         void send_upgrade_planet()
         {
-            std::lock_guard<std::mutex> lock(client_mutex_);
+            NetProfiledLock lock(client_mutex_);
             if (client_ && client_->connected && (client_->valid_actions & VALID_ACTION_UPGRADE_PLANET))
                 client_send_action(client_.get(), USER_ACTION_UPGRADE_PLANET, -1, 0, 0);
         }
 
         void send_upgrade_ship()
         {
-            std::lock_guard<std::mutex> lock(client_mutex_);
+            NetProfiledLock lock(client_mutex_);
             if (client_ && client_->connected && (client_->valid_actions & VALID_ACTION_UPGRADE_SHIP))
                 client_send_action(client_.get(), USER_ACTION_UPGRADE_SHIP, -1, 0, 0);
         }
@@ -1090,6 +1336,12 @@ namespace
                 return;
             }
 
+            // The Join tab's directory field decides, overriding ARMADA_DIRECTORY
+            if (server_set_directory(server.get(), directory_address_.c_str()) != 0)
+                append_server_log("Cannot resolve directory " + directory_address_ + "; LAN discovery only.");
+            else if (!directory_address_.empty())
+                append_server_log("Registering with directory " + directory_address_ + ".");
+
             server_start(server.get());
             if (!server->running)
             {
@@ -1118,6 +1370,12 @@ namespace
             request_redraw();
         }
 
+        // Wait and hold statistics for every profiled lock, into the server log
+        void dump_lock_profile()
+        {
+            net_lock_profile_dump(&ArmadaApp::server_log_thunk, this);
+        }
+
         // LOGGING
         static void log_thunk(const char *line, void *userdata)
         {
@@ -1176,16 +1434,23 @@ namespace
         Component session_component_;
         Component name_input_component_;
         Component manual_input_component_;
+        Component directory_input_component_;
+        Component browse_mode_component_;
         Component host_list_component_;
         Component target_list_component_;
 
         // Join state
         std::string player_name_ = "Voyager";
         std::string manual_ip_;
-        std::vector<std::string> lan_hosts_;
+        std::vector<NetLanHost> lan_hosts_;
         std::vector<std::wstring> lan_hosts_display_;
         int selected_host_index_ = 0;
         std::mutex host_mutex_;
+        // Where the list comes from: this network's beacons, or a directory daemon
+        static constexpr int kBrowseDirectory = 1;
+        std::vector<std::string> browse_modes_ = {"LAN", "Directory"};
+        int browse_mode_index_ = 0;
+        std::string directory_address_; // Also used to register a hosted server
 
         // Scanning
         std::thread scan_thread_;
@@ -1194,7 +1459,7 @@ namespace
 
         // Client connection
         ClientPtr client_{nullptr, &client_destroy};
-        std::mutex client_mutex_;
+        NetProfiledLockable client_mutex_{"client_mutex_"};
         std::thread pump_thread_;
         std::atomic<bool> pumping_{false};
         std::string active_address_;
@@ -1338,7 +1603,11 @@ extern "C" void client_on_join_ack(ClientContext *ctx, const EventPayload_JoinAc
 {
     if (!payload)
         return;
-    if (payload->success)
+    if (payload->success && payload->resumed)
+    {
+        armada_ui_logf(CLR_GREEN "[%s]" CLR_RESET " Session resumed as ID " CLR_BOLD "%d" CLR_RESET ".", ctx->player_name, payload->player_id);
+    }
+    else if (payload->success)
     {
         armada_ui_logf(CLR_GREEN "[%s]" CLR_RESET " Joined successfully! Assigned ID " CLR_BOLD "%d" CLR_RESET ".", ctx->player_name, payload->player_id);
         if (payload->is_host)
@@ -1367,6 +1636,27 @@ extern "C" void client_on_player_joined(ClientContext *ctx, const EventPayload_P
                    payload->player_name);
 }
 
+extern "C" void client_on_lobby_snapshot(ClientContext *ctx, const EventPayload_LobbySnapshot *payload)
+{
+    if (!payload || !ctx)
+        return;
+
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        if (i == ctx->player_id || !(payload->active_mask & (1u << i)))
+            continue;
+        armada_ui_logf("%s[P%d %s]" CLR_RESET " is in the lobby%s.",
+                       get_player_color(i),
+                       i,
+                       payload->player_names[i],
+                       i == payload->host_player_id ? " (host)" : "");
+    }
+    if (payload->phase == LOBBY_PHASE_IN_MATCH)
+    {
+        armada_ui_logf(CLR_SERVER "[Server]" CLR_RESET " A match is already in progress.");
+    }
+}
+
 extern "C" void client_on_host_update(ClientContext *ctx, const EventPayload_HostUpdate *payload)
 {
     if (!payload)
@@ -1406,23 +1696,24 @@ extern "C" void client_on_match_start(ClientContext *ctx, const EventPayload_Mat
     if (!payload || !ctx)
         return;
 
-    ctx->host_player_id = payload->state.host_player_id;
+    ctx->host_player_id = payload->host_player_id;
     ctx->is_host = (ctx->player_id >= 0 && ctx->player_id == ctx->host_player_id);
-    ctx->has_state_snapshot = 0;
-    memset(&ctx->player_game_state, 0, sizeof(PlayerGameState));
 
-    int first_player_id = payload->state.turn.current_player_id;
+    // Log before the roster is cleared; the first turn keyframe repopulates it
+    int first_player_id = payload->first_player_id;
     const char *first_clr = get_player_color(first_player_id);
-    const char *first_name = (first_player_id >= 0 && first_player_id < MAX_PLAYERS)
-                                 ? payload->state.players[first_player_id].name
-                                 : "Unknown";
+    const char *first_name = get_player_name_by_id(ctx, first_player_id);
 
     armada_ui_logf(CLR_GREEN CLR_BOLD "=== MATCH STARTED ===" CLR_RESET);
     armada_ui_logf(CLR_SERVER "[Server]" CLR_RESET " %d players in match. First turn: %s[P%d %s]" CLR_RESET ".",
-                   payload->state.player_count,
+                   payload->player_count,
                    first_clr,
                    first_player_id,
                    first_name);
+
+    ctx->has_state_snapshot = 0;
+    ctx->private_version = 0;
+    memset(&ctx->player_game_state, 0, sizeof(PlayerGameState));
 }
 
 extern "C" void client_on_match_stop(ClientContext *ctx, const EventPayload_Error *payload)
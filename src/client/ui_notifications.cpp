@@ -1,17 +1,17 @@
 #include "../../include/client/ui_notifications.h"
+#include "../../include/networking/net_lock_profile.h"
 
 #include <cstddef>
 #include <cstdarg>
 #include <cstdio>
-#include <mutex>
 
 namespace
 {
-    std::mutex g_log_mutex;
+    NetProfiledLockable g_log_mutex("g_log_mutex");
     ArmadaUiLogSink g_log_sink = nullptr;
     void *g_log_userdata = nullptr;
 
-    std::mutex g_server_log_mutex;
+    NetProfiledLockable g_server_log_mutex("g_server_log_mutex");
     ArmadaUiLogSink g_server_log_sink = nullptr;
     void *g_server_log_userdata = nullptr;
 
@@ -20,14 +20,14 @@ namespace
 
 extern "C" void armada_ui_set_log_sink(ArmadaUiLogSink sink, void *userdata)
 {
-    std::lock_guard<std::mutex> lock(g_log_mutex);
+    NetProfiledLock lock(g_log_mutex);
     g_log_sink = sink;
     g_log_userdata = userdata;
 }
 
 extern "C" void armada_ui_log(const char *line)
 {
-    std::lock_guard<std::mutex> lock(g_log_mutex);
+    NetProfiledLock lock(g_log_mutex);
     if (!g_log_sink)
     {
         return;
@@ -58,14 +58,14 @@ extern "C" void armada_ui_logf(const char *fmt, ...)
 // Server log sink functions
 extern "C" void armada_server_set_log_sink(ArmadaUiLogSink sink, void *userdata)
 {
-    std::lock_guard<std::mutex> lock(g_server_log_mutex);
+    NetProfiledLock lock(g_server_log_mutex);
     g_server_log_sink = sink;
     g_server_log_userdata = userdata;
 }
 
 extern "C" void armada_server_log(const char *line)
 {
-    std::lock_guard<std::mutex> lock(g_server_log_mutex);
+    NetProfiledLock lock(g_server_log_mutex);
     if (!g_server_log_sink)
     {
         return;
@@ -1,6 +1,21 @@
 #include "../include/client/tui_bridge.h"
+#include "../include/networking/net_directory.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-int main()
+int main(int argc, char **argv)
 {
+    // "armada --directory [port]" runs the server directory instead of the game
+    if (argc > 1 && std::strcmp(argv[1], "--directory") == 0)
+    {
+        int port = argc > 2 ? std::atoi(argv[2]) : ARMADA_DIRECTORY_PORT;
+        if (port <= 0 || port > 65535)
+        {
+            std::fprintf(stderr, "usage: %s --directory [port]\n", argv[0]);
+            return 2;
+        }
+        return net_directory_serve(port, NET_DIRECTORY_DEFAULT_CAPACITY, nullptr) == 0 ? 0 : 1;
+    }
     return armada_tui_run();
 }
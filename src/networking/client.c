@@ -1,5 +1,7 @@
 #include "../../include/client/client_api.h"
 #include "../../include/networking/network.h"
+#include "../../include/networking/net_codec.h"
+#include "../../include/networking/net_snapshot.h"
 #include "../../include/client/main.h"
 #include "../../include/client/ui_notifications.h"
 #include <stdio.h>
@@ -7,8 +9,13 @@
 #include <string.h>
 #include <time.h>
 
+// How often client_wait checks on a connect in progress
+#define CLIENT_CONNECT_CHECK_MS 20
+
 // Handles incoming game events for the client
 static void client_handle_event(ClientContext *ctx, const GameEvent *event);
+static void client_apply_public_snapshot(ClientContext *ctx, const EventPayload_TurnInfo *turn);
+static void client_apply_private_snapshot(ClientContext *ctx, const EventPayload_TurnPrivate *update);
 
 // Creates and initializes a new client context
 ClientContext *client_create(const char *name)
@@ -18,6 +25,12 @@ ClientContext *client_create(const char *name)
         return NULL;
 
     memset(ctx, 0, sizeof(ClientContext));
+    ctx->reactor = net_reactor_create();
+    if (!ctx->reactor)
+    {
+        free(ctx);
+        return NULL;
+    }
     client_init(ctx, name ? name : "Player");
     return ctx;
 }
@@ -27,10 +40,11 @@ void client_destroy(ClientContext *ctx)
 {
     if (!ctx)
         return;
-    if (ctx->connected)
+    if (ctx->connected || ctx->connecting)
     {
         client_disconnect(ctx);
     }
+    net_reactor_destroy(ctx->reactor);
     free(ctx);
 }
 
@@ -53,51 +67,106 @@ int client_init(ClientContext *ctx, const char *player_name)
 
     ctx->player_id = -1;
     ctx->connected = 0;
+    ctx->connecting = 0;
     ctx->host_player_id = -1;
     ctx->is_host = 0;
     ctx->socket_fd = NET_INVALID_SOCKET;
     ctx->has_state_snapshot = 0;
+    ctx->snapshot_version = 0;
+    ctx->private_version = 0;
+    ctx->resync_pending = 0;
     ctx->match_started = 0;
     ctx->current_turn_player_id = -1;
     ctx->turn_number = 0;
     ctx->valid_actions = 0;
+    ctx->heartbeat_interval_ms = NET_HEARTBEAT_INTERVAL_MS;
+    ctx->heartbeat_timeout_ms = NET_HEARTBEAT_TIMEOUT_MS;
+    ctx->ping_sequence = 0;
+    net_rtt_reset(&ctx->rtt);
+    ctx->resume_token = 0;
     memset(&ctx->player_game_state, 0, sizeof(PlayerGameState));
 
     return client_on_init(ctx, ctx->player_name);
 }
 
-// Connects the client to the server at the given address
-int client_connect(ClientContext *ctx, const char *server_addr)
+// Starts connecting in the background with the join request as early data,
+// resuming the session when resume_token is set. client_pump finishes the connect.
+static int client_open_session(ClientContext *ctx, const char *addr, uint64_t resume_token)
 {
-    if (!ctx)
-        return -1;
-
-    const char *addr = server_addr ? server_addr : "127.0.0.1";
     client_on_connecting(ctx, addr, DEFAULT_PORT);
 
-    ctx->socket_fd = net_connect_to_server(addr, DEFAULT_PORT);
-    if (ctx->socket_fd == NET_INVALID_SOCKET)
-    {
-        client_on_connection_failed(ctx, addr, DEFAULT_PORT);
-        return -1;
-    }
-
-    ctx->connected = 1;
-    client_on_connected(ctx);
-
-    // Send join request event to server
     GameEvent join_event;
     memset(&join_event, 0, sizeof(GameEvent));
     join_event.type = EVENT_PLAYER_JOIN_REQUEST;
     join_event.sender_id = 0;
     join_event.timestamp = time(NULL);
     strncpy(join_event.data.join_req.player_name, ctx->player_name, sizeof(join_event.data.join_req.player_name) - 1);
+    join_event.data.join_req.resume_token = resume_token;
 
+    unsigned char frame[NET_CONNECT_EARLY_DATA_MAX];
+    size_t frame_size = net_encode_event(&join_event, frame, sizeof(frame));
+    if (frame_size == 0 || net_connect_begin(&ctx->connect_attempt, addr, DEFAULT_PORT, NET_CONNECT_TIMEOUT_MS, frame, frame_size) != 0)
+    {
+        client_on_connection_failed(ctx, addr, DEFAULT_PORT);
+        return -1;
+    }
+
+    ctx->connecting = 1;
     client_on_join_request(ctx);
-    net_send_event(ctx->socket_fd, &join_event);
     return 0;
 }
 
+// Checks on a connect in progress without blocking
+static void client_poll_connect(ClientContext *ctx)
+{
+    net_socket_t sock = NET_INVALID_SOCKET;
+    int result = net_connect_poll(&ctx->connect_attempt, 0, &sock);
+    if (result == 0)
+        return;
+
+    ctx->connecting = 0;
+    if (result < 0)
+    {
+        client_on_connection_failed(ctx, ctx->server_addr, DEFAULT_PORT);
+        return;
+    }
+
+    // The join request already went out with the handshake
+    net_recv_buffer_reset(&ctx->recv_buffer);
+    ctx->socket_fd = sock;
+    net_reactor_add(ctx->reactor, sock, NET_REACTOR_READ, ctx);
+    ctx->connected = 1;
+    ctx->last_heard_us = net_monotonic_us();
+    ctx->last_ping_us = ctx->last_heard_us;
+    net_rtt_reset(&ctx->rtt);
+    client_on_connected(ctx);
+}
+
+// Connects the client to the server at the given address
+int client_connect(ClientContext *ctx, const char *server_addr)
+{
+    if (!ctx)
+        return -1;
+
+    const char *addr = server_addr ? server_addr : "127.0.0.1";
+    strncpy(ctx->server_addr, addr, sizeof(ctx->server_addr) - 1);
+    ctx->server_addr[sizeof(ctx->server_addr) - 1] = '\0';
+    ctx->resume_token = 0;
+    return client_open_session(ctx, ctx->server_addr, 0);
+}
+
+// Reconnects after a dropped connection, keeping our slot and game state
+int client_resume(ClientContext *ctx)
+{
+    if (!ctx || ctx->connected || ctx->resume_token == 0 || ctx->server_addr[0] == '\0')
+        return -1;
+    if (ctx->connecting)
+        return 0;
+
+    armada_ui_logf("[Client %s] Resuming session as player %d...", ctx->player_name, ctx->player_id);
+    return client_open_session(ctx, ctx->server_addr, ctx->resume_token);
+}
+
 // Disconnects the client from the server
 void client_disconnect(ClientContext *ctx)
 {
@@ -106,13 +175,31 @@ void client_disconnect(ClientContext *ctx)
 
     if (ctx->connected)
     {
+        // Tell the server not to hold our slot for a resume
+        if (ctx->player_id >= 0)
+        {
+            GameEvent leave;
+            memset(&leave, 0, sizeof(GameEvent));
+            leave.type = EVENT_PLAYER_LEFT;
+            leave.sender_id = ctx->player_id;
+            leave.timestamp = time(NULL);
+            leave.data.player_event.player_id = ctx->player_id;
+            net_send_event(ctx->socket_fd, &leave);
+        }
         client_on_disconnected(ctx);
     }
+    if (ctx->connecting)
+    {
+        net_connect_cancel(&ctx->connect_attempt);
+        ctx->connecting = 0;
+    }
     ctx->connected = 0;
+    ctx->resume_token = 0;
     ctx->is_host = 0;
     ctx->host_player_id = -1;
     if (ctx->socket_fd != NET_INVALID_SOCKET)
     {
+        net_reactor_remove(ctx->reactor, ctx->socket_fd);
         net_close_socket(ctx->socket_fd);
         ctx->socket_fd = NET_INVALID_SOCKET;
     }
@@ -155,33 +242,190 @@ void client_request_match_start(ClientContext *ctx)
     net_send_event(ctx->socket_fd, &request);
 }
 
-// Polls for incoming events and handles them
-void client_pump(ClientContext *ctx)
+// Sets the ping interval and silence timeout
+void client_set_heartbeat(ClientContext *ctx, int interval_ms, int timeout_ms)
 {
-    if (!ctx || !ctx->connected)
+    if (!ctx)
         return;
+    ctx->heartbeat_interval_ms = interval_ms > 0 ? interval_ms : 0;
+    ctx->heartbeat_timeout_ms = timeout_ms > 0 ? timeout_ms : 0;
+}
 
-    GameEvent event;
-    int result = net_receive_event_flags(ctx->socket_fd, &event, NET_MSG_DONTWAIT);
+// Drops the connection after the server went away
+static void client_lost_connection(ClientContext *ctx)
+{
+    ctx->connected = 0;
+    client_on_disconnected(ctx);
+    if (ctx->socket_fd != NET_INVALID_SOCKET)
+    {
+        net_reactor_remove(ctx->reactor, ctx->socket_fd);
+        net_close_socket(ctx->socket_fd);
+        ctx->socket_fd = NET_INVALID_SOCKET;
+    }
+}
 
-    if (result == 0)
+// Pings the server when due and gives up on one that stopped talking
+static void client_check_heartbeat(ClientContext *ctx)
+{
+    uint64_t now_us = net_monotonic_us();
+    uint64_t silent_us = now_us - ctx->last_heard_us;
+    if (ctx->heartbeat_timeout_ms > 0 && silent_us > (uint64_t)ctx->heartbeat_timeout_ms * 1000ULL)
     {
+        armada_ui_logf("[Client %s] Server silent for %d ms, disconnecting.", ctx->player_name, (int)(silent_us / 1000ULL));
+        client_lost_connection(ctx);
         return;
     }
 
+    if (ctx->heartbeat_interval_ms > 0 && ctx->player_id >= 0 &&
+        now_us - ctx->last_ping_us >= (uint64_t)ctx->heartbeat_interval_ms * 1000ULL)
+    {
+        GameEvent ping;
+        memset(&ping, 0, sizeof(GameEvent));
+        ping.type = EVENT_PING;
+        ping.sender_id = ctx->player_id;
+        ping.data.heartbeat.sequence = ++ctx->ping_sequence;
+        ping.data.heartbeat.sent_us = (uint32_t)now_us;
+        ctx->last_ping_us = now_us;
+        net_send_event(ctx->socket_fd, &ping);
+    }
+}
+
+// Handles every complete event that has arrived, reading until the socket would block
+int client_pump(ClientContext *ctx)
+{
+    if (ctx && ctx->connecting)
+        client_poll_connect(ctx);
+    if (!ctx || !ctx->connected)
+        return 0;
+
+    GameEvent event;
+    int result;
+    int handled = 0;
+    while ((result = net_receive_event_flags(ctx->socket_fd, &ctx->recv_buffer, &event, NET_MSG_DONTWAIT)) > 0)
+    {
+        ctx->last_heard_us = net_monotonic_us();
+        client_handle_event(ctx, &event);
+        ++handled;
+        if (!ctx->connected)
+            return handled;
+    }
+
     if (result < 0)
     {
-        ctx->connected = 0;
-        client_on_disconnected(ctx);
-        if (ctx->socket_fd != NET_INVALID_SOCKET)
-        {
-            net_close_socket(ctx->socket_fd);
-            ctx->socket_fd = NET_INVALID_SOCKET;
-        }
+        client_lost_connection(ctx);
+        return handled;
+    }
+    client_check_heartbeat(ctx);
+    return handled;
+}
+
+// Milliseconds until client_check_heartbeat has work to do, -1 if never
+static int client_heartbeat_wait_ms(const ClientContext *ctx)
+{
+    if (!ctx->connected)
+        return -1;
+
+    uint64_t due_us = UINT64_MAX;
+    if (ctx->heartbeat_interval_ms > 0 && ctx->player_id >= 0)
+        due_us = ctx->last_ping_us + (uint64_t)ctx->heartbeat_interval_ms * 1000ULL;
+    if (ctx->heartbeat_timeout_ms > 0)
+    {
+        uint64_t silent_due_us = ctx->last_heard_us + (uint64_t)ctx->heartbeat_timeout_ms * 1000ULL + 1000ULL;
+        if (silent_due_us < due_us)
+            due_us = silent_due_us;
+    }
+    if (due_us == UINT64_MAX)
+        return -1;
+
+    uint64_t now_us = net_monotonic_us();
+    return due_us <= now_us ? 0 : (int)((due_us - now_us + 999ULL) / 1000ULL);
+}
+
+// Sleeps until there is something for client_pump to do
+int client_wait(ClientContext *ctx, int timeout_ms)
+{
+    if (!ctx)
+        return 0;
+
+    int wait_ms = timeout_ms;
+    // A connect in flight is checked on a short cadence; its sockets are not in the reactor
+    int due_ms = ctx->connecting ? CLIENT_CONNECT_CHECK_MS : client_heartbeat_wait_ms(ctx);
+    if (due_ms >= 0 && (wait_ms < 0 || due_ms < wait_ms))
+        wait_ms = due_ms;
+
+    NetReactorEvent events[1];
+    return net_reactor_wait(ctx->reactor, events, 1, wait_ms) > 0 ? 1 : 0;
+}
+
+void client_wake(ClientContext *ctx)
+{
+    if (ctx)
+        net_reactor_wake(ctx->reactor);
+}
+
+// Asks the server for keyframes after a delta arrived whose base we do not hold
+static void client_request_resync(ClientContext *ctx)
+{
+    if (ctx->resync_pending)
+        return;
+
+    GameEvent request;
+    memset(&request, 0, sizeof(GameEvent));
+    request.type = EVENT_STATE_RESYNC_REQUEST;
+    request.sender_id = ctx->player_id;
+    request.timestamp = time(NULL);
+    ctx->resync_pending = 1;
+    net_send_event(ctx->socket_fd, &request);
+}
+
+// The public broadcast only carries the coarse view of everyone, so our own
+// entry is rebuilt from the private state the server sent us
+static void client_refresh_own_entry(ClientContext *ctx)
+{
+    if (ctx->player_id < 0 || ctx->player_id >= MAX_PLAYERS || ctx->private_version == 0)
+        return;
+
+    const PlayerState *self = &ctx->player_game_state.self;
+    PlayerPublicInfo *entry = &ctx->player_game_state.entries[ctx->player_id];
+    if (!entry->is_active)
+        return;
+    entry->show_stars = 1;
+    entry->coarse_planet_health = (self->planet.max_health == 0) ? 0 : (self->planet.current_health * 100) / self->planet.max_health;
+}
+
+// Patches the public entries with a turn broadcast, asking for a keyframe if the delta's base is missing
+static void client_apply_public_snapshot(ClientContext *ctx, const EventPayload_TurnInfo *turn)
+{
+    int is_keyframe = (turn->base_version == 0);
+    if (!is_keyframe && (!ctx->has_state_snapshot || turn->base_version != ctx->snapshot_version))
+    {
+        client_request_resync(ctx);
+        return;
+    }
+
+    net_snapshot_apply_public(ctx->player_game_state.entries, turn);
+    ctx->snapshot_version = turn->snapshot_version;
+    ctx->has_state_snapshot = 1;
+    ctx->resync_pending = 0;
+    client_refresh_own_entry(ctx);
+}
+
+// Patches our own PlayerState with a private update
+static void client_apply_private_snapshot(ClientContext *ctx, const EventPayload_TurnPrivate *update)
+{
+    ctx->valid_actions = update->valid_actions;
+
+    int is_keyframe = (update->base_version == 0);
+    if (!is_keyframe && update->base_version != ctx->private_version)
+    {
+        client_request_resync(ctx);
         return;
     }
 
-    client_handle_event(ctx, &event);
+    ctx->player_game_state.viewer_id = update->player_id;
+    net_snapshot_apply_private(&ctx->player_game_state.self, update);
+    ctx->private_version = update->snapshot_version;
+    client_refresh_own_entry(ctx);
 }
 
 // Handles a single game event received from the server
@@ -195,6 +439,19 @@ static void client_handle_event(ClientContext *ctx, const GameEvent *event)
     case EVENT_PLAYER_JOIN_ACK:
         if (event->data.join_ack.success)
         {
+            if (!event->data.join_ack.resumed)
+            {
+                // A fresh slot: nothing we knew about the old one still applies
+                ctx->has_state_snapshot = 0;
+                ctx->snapshot_version = 0;
+                ctx->private_version = 0;
+                ctx->match_started = 0;
+                ctx->current_turn_player_id = -1;
+                ctx->valid_actions = 0;
+                memset(&ctx->player_game_state, 0, sizeof(PlayerGameState));
+            }
+            ctx->resync_pending = 0;
+            ctx->resume_token = event->data.join_ack.resume_token;
             ctx->player_id = event->data.join_ack.player_id;
             ctx->host_player_id = event->data.join_ack.host_player_id;
             ctx->is_host = event->data.join_ack.is_host;
@@ -226,6 +483,27 @@ static void client_handle_event(ClientContext *ctx, const GameEvent *event)
         client_on_player_joined(ctx, pl);
         break;
     }
+    case EVENT_LOBBY_SNAPSHOT:
+    {
+        // Rebuild the whole roster from one message instead of one PLAYER_JOINED each
+        const EventPayload_LobbySnapshot *lobby = &event->data.lobby;
+        for (int i = 0; i < MAX_PLAYERS; ++i)
+        {
+            PlayerPublicInfo *entry = &ctx->player_game_state.entries[i];
+            entry->player_id = i;
+            entry->is_active = (lobby->active_mask & (1u << i)) != 0;
+            if (entry->is_active)
+            {
+                strncpy(entry->name, lobby->player_names[i], sizeof(entry->name) - 1);
+                entry->name[MAX_NAME_LEN - 1] = '\0';
+            }
+        }
+        ctx->host_player_id = lobby->host_player_id;
+        ctx->is_host = (ctx->player_id >= 0 && ctx->player_id == ctx->host_player_id);
+        ctx->match_started = (lobby->phase == LOBBY_PHASE_IN_MATCH);
+        client_on_lobby_snapshot(ctx, lobby);
+        break;
+    }
     case EVENT_PLAYER_LEFT:
     {
         const EventPayload_PlayerLifecycle *pl = &event->data.player_event;
@@ -246,12 +524,13 @@ static void client_handle_event(ClientContext *ctx, const GameEvent *event)
         ctx->match_started = 1;
         client_on_match_start(ctx, &event->data.match_start);
         break;
+    case EVENT_TURN_PRIVATE:
+        client_apply_private_snapshot(ctx, &event->data.turn_private);
+        break;
     case EVENT_TURN_STARTED:
-        ctx->player_game_state = event->data.turn.game;
-        ctx->has_state_snapshot = 1;
+        client_apply_public_snapshot(ctx, &event->data.turn);
         ctx->current_turn_player_id = event->data.turn.current_player_id;
         ctx->turn_number = event->data.turn.turn_number;
-        ctx->valid_actions = event->data.turn.valid_actions;
         client_on_turn_event(ctx, event->type, &event->data.turn);
         break;
     case EVENT_STAR_THRESHOLD_REACHED:
@@ -265,6 +544,17 @@ static void client_handle_event(ClientContext *ctx, const GameEvent *event)
     case EVENT_ERROR:
         client_on_match_stop(ctx, &event->data.error);
         break;
+    case EVENT_PING:
+    {
+        GameEvent pong = *event;
+        pong.type = EVENT_PONG;
+        pong.sender_id = ctx->player_id;
+        net_send_event(ctx->socket_fd, &pong);
+        break;
+    }
+    case EVENT_PONG:
+        net_rtt_sample(&ctx->rtt, (uint32_t)net_monotonic_us() - event->data.heartbeat.sent_us);
+        break;
     default:
         break;
     }
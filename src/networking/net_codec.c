@@ -0,0 +1,554 @@
+#include "../../include/networking/net_codec.h"
+#include <string.h>
+
+// Bounded big-endian writer; sets overflow instead of writing past cap
+typedef struct
+{
+    unsigned char *buf;
+    size_t cap;
+    size_t pos;
+    int overflow;
+} NetWriter;
+
+// Bounded big-endian reader; sets error instead of reading past len
+typedef struct
+{
+    const unsigned char *buf;
+    size_t len;
+    size_t pos;
+    int error;
+} NetReader;
+
+static void net_put_u8(NetWriter *w, unsigned int value)
+{
+    if (w->pos + 1 > w->cap)
+    {
+        w->overflow = 1;
+        return;
+    }
+    w->buf[w->pos++] = (unsigned char)(value & 0xFF);
+}
+
+static void net_put_u16(NetWriter *w, unsigned int value)
+{
+    net_put_u8(w, value >> 8);
+    net_put_u8(w, value);
+}
+
+static void net_put_u32(NetWriter *w, uint32_t value)
+{
+    net_put_u16(w, (unsigned int)(value >> 16));
+    net_put_u16(w, (unsigned int)(value & 0xFFFF));
+}
+
+static void net_put_u64(NetWriter *w, uint64_t value)
+{
+    net_put_u32(w, (uint32_t)(value >> 32));
+    net_put_u32(w, (uint32_t)(value & 0xFFFFFFFFu));
+}
+
+static void net_put_i8(NetWriter *w, int value)
+{
+    net_put_u8(w, (unsigned int)(unsigned char)(signed char)value);
+}
+
+static void net_put_i32(NetWriter *w, int value)
+{
+    net_put_u32(w, (uint32_t)value);
+}
+
+static void net_put_str(NetWriter *w, const char *str, size_t max_len)
+{
+    size_t len = 0;
+    while (len < max_len && len < 255 && str[len] != '\0')
+    {
+        ++len;
+    }
+    net_put_u8(w, (unsigned int)len);
+    if (w->pos + len > w->cap)
+    {
+        w->overflow = 1;
+        return;
+    }
+    memcpy(w->buf + w->pos, str, len);
+    w->pos += len;
+}
+
+static unsigned int net_get_u8(NetReader *r)
+{
+    if (r->pos + 1 > r->len)
+    {
+        r->error = 1;
+        return 0;
+    }
+    return r->buf[r->pos++];
+}
+
+static unsigned int net_get_u16(NetReader *r)
+{
+    unsigned int hi = net_get_u8(r);
+    unsigned int lo = net_get_u8(r);
+    return (hi << 8) | lo;
+}
+
+static uint32_t net_get_u32(NetReader *r)
+{
+    uint32_t hi = net_get_u16(r);
+    uint32_t lo = net_get_u16(r);
+    return (hi << 16) | lo;
+}
+
+static uint64_t net_get_u64(NetReader *r)
+{
+    uint64_t hi = net_get_u32(r);
+    uint64_t lo = net_get_u32(r);
+    return (hi << 32) | lo;
+}
+
+static int net_get_i8(NetReader *r)
+{
+    return (int)(signed char)(unsigned char)net_get_u8(r);
+}
+
+static int net_get_i32(NetReader *r)
+{
+    return (int)net_get_u32(r);
+}
+
+// Reads a length-prefixed string into dst (always null-terminated, truncated to dst_size)
+static void net_get_str(NetReader *r, char *dst, size_t dst_size)
+{
+    size_t len = net_get_u8(r);
+    if (r->pos + len > r->len)
+    {
+        r->error = 1;
+        dst[0] = '\0';
+        return;
+    }
+    size_t copy = len < dst_size - 1 ? len : dst_size - 1;
+    memcpy(dst, r->buf + r->pos, copy);
+    dst[copy] = '\0';
+    r->pos += len;
+}
+
+// PAYLOAD ENCODERS
+
+static void net_put_action(NetWriter *w, const EventPayload_UserAction *action)
+{
+    net_put_i8(w, action->player_id);
+    net_put_u8(w, (unsigned int)action->action_type);
+    net_put_i8(w, action->target_player_id);
+    net_put_i32(w, action->value);
+    net_put_i32(w, action->metadata);
+}
+
+static void net_get_action(NetReader *r, EventPayload_UserAction *action)
+{
+    action->player_id = net_get_i8(r);
+    action->action_type = (UserActionType)net_get_u8(r);
+    action->target_player_id = net_get_i8(r);
+    action->value = net_get_i32(r);
+    action->metadata = net_get_i32(r);
+}
+
+// Writes the PlayerState fields selected by mask (SNAPSHOT_SELF_*), in bit order
+static void net_put_player_state(NetWriter *w, const PlayerState *player, unsigned int mask)
+{
+    if (mask & SNAPSHOT_SELF_ID)
+        net_put_i8(w, player->player_id);
+    if (mask & SNAPSHOT_SELF_NAME)
+        net_put_str(w, player->name, MAX_NAME_LEN);
+    if (mask & SNAPSHOT_SELF_FLAGS)
+        net_put_u8(w, (player->is_active ? 0x1u : 0u) | (player->is_connected ? 0x2u : 0u) | (player->has_crossed_threshold ? 0x4u : 0u));
+    if (mask & SNAPSHOT_SELF_STARS)
+        net_put_i32(w, player->stars);
+    if (mask & SNAPSHOT_SELF_PLANET_LEVEL)
+        net_put_i32(w, player->planet.level);
+    if (mask & SNAPSHOT_SELF_PLANET_MAX_HEALTH)
+        net_put_i32(w, player->planet.max_health);
+    if (mask & SNAPSHOT_SELF_PLANET_HEALTH)
+        net_put_i32(w, player->planet.current_health);
+    if (mask & SNAPSHOT_SELF_PLANET_INCOME)
+        net_put_i32(w, player->planet.base_income);
+    if (mask & SNAPSHOT_SELF_SHIP_LEVEL)
+        net_put_i32(w, player->ship.level);
+    if (mask & SNAPSHOT_SELF_SHIP_DAMAGE)
+        net_put_i32(w, player->ship.base_damage);
+}
+
+static void net_get_player_state(NetReader *r, PlayerState *player, unsigned int mask)
+{
+    if (mask & SNAPSHOT_SELF_ID)
+        player->player_id = net_get_i8(r);
+    if (mask & SNAPSHOT_SELF_NAME)
+        net_get_str(r, player->name, sizeof(player->name));
+    if (mask & SNAPSHOT_SELF_FLAGS)
+    {
+        unsigned int flags = net_get_u8(r);
+        player->is_active = (flags & 0x1u) != 0;
+        player->is_connected = (flags & 0x2u) != 0;
+        player->has_crossed_threshold = (flags & 0x4u) != 0;
+    }
+    if (mask & SNAPSHOT_SELF_STARS)
+        player->stars = net_get_i32(r);
+    if (mask & SNAPSHOT_SELF_PLANET_LEVEL)
+        player->planet.level = net_get_i32(r);
+    if (mask & SNAPSHOT_SELF_PLANET_MAX_HEALTH)
+        player->planet.max_health = net_get_i32(r);
+    if (mask & SNAPSHOT_SELF_PLANET_HEALTH)
+        player->planet.current_health = net_get_i32(r);
+    if (mask & SNAPSHOT_SELF_PLANET_INCOME)
+        player->planet.base_income = net_get_i32(r);
+    if (mask & SNAPSHOT_SELF_SHIP_LEVEL)
+        player->ship.level = net_get_i32(r);
+    if (mask & SNAPSHOT_SELF_SHIP_DAMAGE)
+        player->ship.base_damage = net_get_i32(r);
+}
+
+// Writes the PlayerPublicInfo fields selected by mask (SNAPSHOT_ENTRY_*), in bit order
+static void net_put_public_info(NetWriter *w, const PlayerPublicInfo *info, unsigned int mask)
+{
+    if (mask & SNAPSHOT_ENTRY_ID)
+        net_put_i8(w, info->player_id);
+    if (mask & SNAPSHOT_ENTRY_FLAGS)
+        net_put_u8(w, (info->is_active ? 0x1u : 0u) | (info->show_stars ? 0x2u : 0u));
+    if (mask & SNAPSHOT_ENTRY_NAME)
+        net_put_str(w, info->name, MAX_NAME_LEN);
+    if (mask & SNAPSHOT_ENTRY_HEALTH)
+        net_put_u8(w, (unsigned int)info->coarse_planet_health);
+    if (mask & SNAPSHOT_ENTRY_SHIP_LEVEL)
+        net_put_i32(w, info->ship_level);
+    if (mask & SNAPSHOT_ENTRY_PLANET_LEVEL)
+        net_put_i32(w, info->planet_level);
+    if (mask & SNAPSHOT_ENTRY_SHIP_DAMAGE)
+        net_put_i32(w, info->ship_base_damage);
+}
+
+static void net_get_public_info(NetReader *r, PlayerPublicInfo *info, unsigned int mask)
+{
+    if (mask & SNAPSHOT_ENTRY_ID)
+        info->player_id = net_get_i8(r);
+    if (mask & SNAPSHOT_ENTRY_FLAGS)
+    {
+        unsigned int flags = net_get_u8(r);
+        info->is_active = (flags & 0x1u) != 0;
+        info->show_stars = (flags & 0x2u) != 0;
+    }
+    if (mask & SNAPSHOT_ENTRY_NAME)
+        net_get_str(r, info->name, sizeof(info->name));
+    if (mask & SNAPSHOT_ENTRY_HEALTH)
+        info->coarse_planet_health = (int)net_get_u8(r);
+    if (mask & SNAPSHOT_ENTRY_SHIP_LEVEL)
+        info->ship_level = net_get_i32(r);
+    if (mask & SNAPSHOT_ENTRY_PLANET_LEVEL)
+        info->planet_level = net_get_i32(r);
+    if (mask & SNAPSHOT_ENTRY_SHIP_DAMAGE)
+        info->ship_base_damage = net_get_i32(r);
+}
+
+// Turn snapshots carry only the fields named in entry_masks / self_mask
+static void net_put_turn(NetWriter *w, const EventPayload_TurnInfo *turn)
+{
+    net_put_i8(w, turn->current_player_id);
+    net_put_i8(w, turn->next_player_id);
+    net_put_i32(w, turn->turn_number);
+    net_put_u8(w, turn->is_match_start ? 1u : 0u);
+    net_put_i8(w, turn->threshold_player_id);
+    net_put_action(w, &turn->last_action);
+    net_put_u32(w, turn->snapshot_version);
+    net_put_u32(w, turn->base_version);
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        unsigned int mask = turn->entry_masks[i] & SNAPSHOT_ENTRY_ALL;
+        net_put_u8(w, mask);
+        net_put_public_info(w, &turn->entries[i], mask);
+    }
+}
+
+static void net_get_turn(NetReader *r, EventPayload_TurnInfo *turn)
+{
+    turn->current_player_id = net_get_i8(r);
+    turn->next_player_id = net_get_i8(r);
+    turn->turn_number = net_get_i32(r);
+    turn->is_match_start = (int)net_get_u8(r);
+    turn->threshold_player_id = net_get_i8(r);
+    net_get_action(r, &turn->last_action);
+    turn->snapshot_version = net_get_u32(r);
+    turn->base_version = net_get_u32(r);
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        turn->entry_masks[i] = net_get_u8(r) & SNAPSHOT_ENTRY_ALL;
+        net_get_public_info(r, &turn->entries[i], turn->entry_masks[i]);
+    }
+}
+
+static void net_put_turn_private(NetWriter *w, const EventPayload_TurnPrivate *update)
+{
+    net_put_i8(w, update->player_id);
+    net_put_u8(w, (unsigned int)update->valid_actions);
+    net_put_u32(w, update->snapshot_version);
+    net_put_u32(w, update->base_version);
+    net_put_u16(w, update->self_mask & SNAPSHOT_SELF_ALL);
+    net_put_player_state(w, &update->self, update->self_mask);
+}
+
+static void net_get_turn_private(NetReader *r, EventPayload_TurnPrivate *update)
+{
+    update->player_id = net_get_i8(r);
+    update->valid_actions = (int)net_get_u8(r);
+    update->snapshot_version = net_get_u32(r);
+    update->base_version = net_get_u32(r);
+    update->self_mask = net_get_u16(r) & SNAPSHOT_SELF_ALL;
+    net_get_player_state(r, &update->self, update->self_mask);
+}
+
+// Only occupied slots carry a name
+static void net_put_lobby(NetWriter *w, const EventPayload_LobbySnapshot *lobby)
+{
+    unsigned int mask = lobby->active_mask & ((1u << MAX_PLAYERS) - 1u);
+    net_put_i8(w, lobby->host_player_id);
+    net_put_u8(w, (unsigned int)lobby->phase);
+    net_put_u8(w, mask);
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        if (mask & (1u << i))
+            net_put_str(w, lobby->player_names[i], MAX_NAME_LEN);
+    }
+}
+
+static void net_get_lobby(NetReader *r, EventPayload_LobbySnapshot *lobby)
+{
+    lobby->host_player_id = net_get_i8(r);
+    lobby->phase = (LobbyPhase)net_get_u8(r);
+    lobby->active_mask = net_get_u8(r) & ((1u << MAX_PLAYERS) - 1u);
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        if (lobby->active_mask & (1u << i))
+            net_get_str(r, lobby->player_names[i], sizeof(lobby->player_names[i]));
+    }
+}
+
+static void net_put_payload(NetWriter *w, const GameEvent *event)
+{
+    switch (event->type)
+    {
+    case EVENT_PLAYER_JOIN_REQUEST:
+        net_put_str(w, event->data.join_req.player_name, sizeof(event->data.join_req.player_name));
+        net_put_u64(w, event->data.join_req.resume_token);
+        break;
+    case EVENT_PLAYER_JOIN_ACK:
+        net_put_i8(w, event->data.join_ack.player_id);
+        net_put_u8(w, (event->data.join_ack.success ? 0x1u : 0u) | (event->data.join_ack.is_host ? 0x2u : 0u) |
+                          (event->data.join_ack.resumed ? 0x4u : 0u));
+        net_put_i8(w, event->data.join_ack.host_player_id);
+        net_put_str(w, event->data.join_ack.message, sizeof(event->data.join_ack.message));
+        net_put_u64(w, event->data.join_ack.resume_token);
+        break;
+    case EVENT_PLAYER_JOINED:
+    case EVENT_PLAYER_LEFT:
+        net_put_i8(w, event->data.player_event.player_id);
+        net_put_i32(w, event->data.player_event.reason_code);
+        net_put_str(w, event->data.player_event.player_name, sizeof(event->data.player_event.player_name));
+        break;
+    case EVENT_HOST_UPDATED:
+        net_put_i8(w, event->data.host_update.host_player_id);
+        net_put_str(w, event->data.host_update.host_player_name, sizeof(event->data.host_update.host_player_name));
+        break;
+    case EVENT_LOBBY_SNAPSHOT:
+        net_put_lobby(w, &event->data.lobby);
+        break;
+    case EVENT_PING:
+    case EVENT_PONG:
+        net_put_u32(w, event->data.heartbeat.sequence);
+        net_put_u32(w, event->data.heartbeat.sent_us);
+        break;
+    case EVENT_MATCH_START:
+        net_put_i8(w, event->data.match_start.host_player_id);
+        net_put_i8(w, event->data.match_start.first_player_id);
+        net_put_u8(w, (unsigned int)event->data.match_start.player_count);
+        break;
+    case EVENT_TURN_STARTED:
+        net_put_turn(w, &event->data.turn);
+        break;
+    case EVENT_TURN_PRIVATE:
+        net_put_turn_private(w, &event->data.turn_private);
+        break;
+    case EVENT_USER_ACTION:
+        net_put_action(w, &event->data.action);
+        break;
+    case EVENT_STAR_THRESHOLD_REACHED:
+        net_put_i8(w, event->data.threshold.player_id);
+        net_put_i32(w, event->data.threshold.threshold);
+        break;
+    case EVENT_GAME_OVER:
+        net_put_i8(w, event->data.game_over.winner_id);
+        net_put_str(w, event->data.game_over.reason, sizeof(event->data.game_over.reason));
+        break;
+    case EVENT_ERROR:
+        net_put_i32(w, event->data.error.error_code);
+        net_put_str(w, event->data.error.message, sizeof(event->data.error.message));
+        break;
+    case EVENT_MATCH_START_REQUEST:
+    case EVENT_STATE_RESYNC_REQUEST:
+    default:
+        break;
+    }
+}
+
+static void net_get_payload(NetReader *r, GameEvent *event)
+{
+    switch (event->type)
+    {
+    case EVENT_PLAYER_JOIN_REQUEST:
+        net_get_str(r, event->data.join_req.player_name, sizeof(event->data.join_req.player_name));
+        event->data.join_req.resume_token = net_get_u64(r);
+        break;
+    case EVENT_PLAYER_JOIN_ACK:
+    {
+        event->data.join_ack.player_id = net_get_i8(r);
+        unsigned int flags = net_get_u8(r);
+        event->data.join_ack.success = (flags & 0x1u) != 0;
+        event->data.join_ack.is_host = (flags & 0x2u) != 0;
+        event->data.join_ack.resumed = (flags & 0x4u) != 0;
+        event->data.join_ack.host_player_id = net_get_i8(r);
+        net_get_str(r, event->data.join_ack.message, sizeof(event->data.join_ack.message));
+        event->data.join_ack.resume_token = net_get_u64(r);
+        break;
+    }
+    case EVENT_PLAYER_JOINED:
+    case EVENT_PLAYER_LEFT:
+        event->data.player_event.player_id = net_get_i8(r);
+        event->data.player_event.reason_code = net_get_i32(r);
+        net_get_str(r, event->data.player_event.player_name, sizeof(event->data.player_event.player_name));
+        break;
+    case EVENT_HOST_UPDATED:
+        event->data.host_update.host_player_id = net_get_i8(r);
+        net_get_str(r, event->data.host_update.host_player_name, sizeof(event->data.host_update.host_player_name));
+        break;
+    case EVENT_LOBBY_SNAPSHOT:
+        net_get_lobby(r, &event->data.lobby);
+        break;
+    case EVENT_PING:
+    case EVENT_PONG:
+        event->data.heartbeat.sequence = net_get_u32(r);
+        event->data.heartbeat.sent_us = net_get_u32(r);
+        break;
+    case EVENT_MATCH_START:
+        event->data.match_start.host_player_id = net_get_i8(r);
+        event->data.match_start.first_player_id = net_get_i8(r);
+        event->data.match_start.player_count = (int)net_get_u8(r);
+        break;
+    case EVENT_TURN_STARTED:
+        net_get_turn(r, &event->data.turn);
+        break;
+    case EVENT_TURN_PRIVATE:
+        net_get_turn_private(r, &event->data.turn_private);
+        break;
+    case EVENT_USER_ACTION:
+        net_get_action(r, &event->data.action);
+        break;
+    case EVENT_STAR_THRESHOLD_REACHED:
+        event->data.threshold.player_id = net_get_i8(r);
+        event->data.threshold.threshold = net_get_i32(r);
+        break;
+    case EVENT_GAME_OVER:
+        event->data.game_over.winner_id = net_get_i8(r);
+        net_get_str(r, event->data.game_over.reason, sizeof(event->data.game_over.reason));
+        break;
+    case EVENT_ERROR:
+        event->data.error.error_code = net_get_i32(r);
+        net_get_str(r, event->data.error.message, sizeof(event->data.error.message));
+        break;
+    case EVENT_MATCH_START_REQUEST:
+    case EVENT_STATE_RESYNC_REQUEST:
+    default:
+        break;
+    }
+}
+
+/**
+ * Encode a GameEvent into a length-prefixed frame.
+ * Returns the number of bytes written, or 0 if the frame does not fit.
+ */
+size_t net_encode_event(const GameEvent *event, unsigned char *buf, size_t cap)
+{
+    if (!event || !buf || cap < NET_FRAME_HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    NetWriter w = {buf, cap, 0, 0};
+    net_put_u16(&w, 0); // Patched below once the body size is known
+    net_put_u8(&w, ARMADA_WIRE_VERSION);
+    net_put_u8(&w, (unsigned int)event->type);
+    net_put_i8(&w, event->sender_id);
+    net_put_u32(&w, (uint32_t)event->timestamp);
+    net_put_payload(&w, event);
+
+    size_t body = w.pos - NET_FRAME_LENGTH_SIZE;
+    if (w.overflow || body > 0xFFFF)
+    {
+        return 0;
+    }
+    buf[0] = (unsigned char)(body >> 8);
+    buf[1] = (unsigned char)(body & 0xFF);
+    return w.pos;
+}
+
+/**
+ * Return the total size of the frame at the start of buf,
+ * or 0 if fewer than NET_FRAME_LENGTH_SIZE bytes are available.
+ */
+size_t net_frame_size(const unsigned char *buf, size_t len)
+{
+    if (!buf || len < NET_FRAME_LENGTH_SIZE)
+    {
+        return 0;
+    }
+    return NET_FRAME_LENGTH_SIZE + (((size_t)buf[0] << 8) | buf[1]);
+}
+
+/**
+ * Decode a single frame from buf into event.
+ * Returns bytes consumed, 0 if the frame is incomplete, -1 if it is malformed.
+ */
+int net_decode_event(const unsigned char *buf, size_t len, GameEvent *event)
+{
+    if (!buf || !event)
+    {
+        return -1;
+    }
+
+    size_t frame_size = net_frame_size(buf, len);
+    if (frame_size == 0)
+    {
+        return 0;
+    }
+    // Judge the length prefix as soon as it arrives, so a bogus one is not buffered
+    if (frame_size < NET_FRAME_HEADER_SIZE || frame_size > NET_FRAME_MAX_SIZE)
+    {
+        return -1;
+    }
+    if (len < frame_size)
+    {
+        return 0;
+    }
+
+    NetReader r = {buf, frame_size, NET_FRAME_LENGTH_SIZE, 0};
+    if (net_get_u8(&r) != ARMADA_WIRE_VERSION)
+    {
+        return -1;
+    }
+
+    memset(event, 0, sizeof(GameEvent));
+    event->type = (EventType)net_get_u8(&r);
+    event->sender_id = net_get_i8(&r);
+    event->timestamp = (time_t)net_get_u32(&r);
+    net_get_payload(&r, event);
+
+    if (r.error)
+    {
+        return -1;
+    }
+    return (int)frame_size;
+}
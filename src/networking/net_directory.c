@@ -0,0 +1,553 @@
+#include "../../include/networking/net_directory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NET_DIRECTORY_NONE -1
+// Page datagrams stay below the smallest common path MTU
+#define NET_DIRECTORY_DATAGRAM_MAX 1200
+// A query without a reply is sent again after this long
+#define NET_DIRECTORY_RETRY_MS 200
+
+typedef struct
+{
+    NetLanHost host;
+    uint32_t key_address; // IPv4, network order
+    int key_port;
+    int used;
+    int older; // Heartbeat order, NET_DIRECTORY_NONE at either end
+    int newer;
+} NetDirectoryEntry;
+
+struct NetDirectory
+{
+    NetDirectoryEntry *entries;
+    int capacity;
+    int count;
+    int *free_slots; // Stack of unused entry indices, lowest on top
+    int free_count;
+    int *buckets; // Entry index per bucket or NET_DIRECTORY_NONE; at most half full
+    unsigned int bucket_mask;
+    int oldest;
+    int newest;
+    int high_water; // One past the highest index ever used; pages stop here
+};
+
+static unsigned int net_directory_hash(uint32_t address, int port)
+{
+    uint32_t hash = address ^ ((uint32_t)port * 0x9E3779B1u);
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+/**
+ * Allocate a table for capacity servers (<= 0 uses the default).
+ * Returns NULL if out of memory.
+ */
+NetDirectory *net_directory_create(int capacity)
+{
+    if (capacity <= 0)
+        capacity = NET_DIRECTORY_DEFAULT_CAPACITY;
+
+    unsigned int bucket_count = 16;
+    while (bucket_count < (unsigned int)capacity * 2)
+        bucket_count <<= 1;
+
+    NetDirectory *directory = (NetDirectory *)calloc(1, sizeof(NetDirectory));
+    if (!directory)
+        return NULL;
+    directory->entries = (NetDirectoryEntry *)calloc((size_t)capacity, sizeof(NetDirectoryEntry));
+    directory->free_slots = (int *)malloc((size_t)capacity * sizeof(int));
+    directory->buckets = (int *)malloc((size_t)bucket_count * sizeof(int));
+    if (!directory->entries || !directory->free_slots || !directory->buckets)
+    {
+        net_directory_destroy(directory);
+        return NULL;
+    }
+
+    directory->capacity = capacity;
+    for (int i = 0; i < capacity; ++i)
+        directory->free_slots[i] = capacity - 1 - i;
+    directory->free_count = capacity;
+    for (unsigned int i = 0; i < bucket_count; ++i)
+        directory->buckets[i] = NET_DIRECTORY_NONE;
+    directory->bucket_mask = bucket_count - 1;
+    directory->oldest = NET_DIRECTORY_NONE;
+    directory->newest = NET_DIRECTORY_NONE;
+    return directory;
+}
+
+void net_directory_destroy(NetDirectory *directory)
+{
+    if (!directory)
+        return;
+    free(directory->entries);
+    free(directory->free_slots);
+    free(directory->buckets);
+    free(directory);
+}
+
+// Bucket holding the server, or the empty bucket where it would go
+static unsigned int net_directory_find(const NetDirectory *directory, uint32_t address, int port)
+{
+    unsigned int bucket = net_directory_hash(address, port) & directory->bucket_mask;
+    for (;;)
+    {
+        int index = directory->buckets[bucket];
+        if (index == NET_DIRECTORY_NONE)
+            return bucket;
+        const NetDirectoryEntry *entry = &directory->entries[index];
+        if (entry->key_address == address && entry->key_port == port)
+            return bucket;
+        bucket = (bucket + 1) & directory->bucket_mask;
+    }
+}
+
+// Empty a bucket and pull later entries of the same probe run back into the hole
+static void net_directory_unbucket(NetDirectory *directory, unsigned int bucket)
+{
+    unsigned int mask = directory->bucket_mask;
+    unsigned int hole = bucket;
+    unsigned int next = (hole + 1) & mask;
+    while (directory->buckets[next] != NET_DIRECTORY_NONE)
+    {
+        const NetDirectoryEntry *entry = &directory->entries[directory->buckets[next]];
+        unsigned int home = net_directory_hash(entry->key_address, entry->key_port) & mask;
+        // Movable unless its home bucket lies between the hole and its bucket
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            directory->buckets[hole] = directory->buckets[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    directory->buckets[hole] = NET_DIRECTORY_NONE;
+}
+
+static void net_directory_unlink(NetDirectory *directory, int index)
+{
+    NetDirectoryEntry *entry = &directory->entries[index];
+    if (entry->older != NET_DIRECTORY_NONE)
+        directory->entries[entry->older].newer = entry->newer;
+    else
+        directory->oldest = entry->newer;
+    if (entry->newer != NET_DIRECTORY_NONE)
+        directory->entries[entry->newer].older = entry->older;
+    else
+        directory->newest = entry->older;
+    entry->older = NET_DIRECTORY_NONE;
+    entry->newer = NET_DIRECTORY_NONE;
+}
+
+static void net_directory_link_newest(NetDirectory *directory, int index)
+{
+    NetDirectoryEntry *entry = &directory->entries[index];
+    entry->older = directory->newest;
+    entry->newer = NET_DIRECTORY_NONE;
+    if (directory->newest != NET_DIRECTORY_NONE)
+        directory->entries[directory->newest].newer = index;
+    else
+        directory->oldest = index;
+    directory->newest = index;
+}
+
+static void net_directory_drop(NetDirectory *directory, unsigned int bucket)
+{
+    int index = directory->buckets[bucket];
+    net_directory_unbucket(directory, bucket);
+    net_directory_unlink(directory, index);
+    directory->entries[index].used = 0;
+    directory->free_slots[directory->free_count++] = index;
+    directory->count -= 1;
+}
+
+int net_directory_update(NetDirectory *directory, const NetLanHost *host, uint64_t now_us)
+{
+    struct in_addr address;
+    if (!directory || !host || inet_pton(AF_INET, host->address, &address) != 1)
+        return -1;
+
+    unsigned int bucket = net_directory_find(directory, address.s_addr, host->port);
+    int index = directory->buckets[bucket];
+    int added = 0;
+    if (index == NET_DIRECTORY_NONE)
+    {
+        if (directory->free_count == 0)
+            return -1;
+        index = directory->free_slots[--directory->free_count];
+        NetDirectoryEntry *entry = &directory->entries[index];
+        entry->key_address = address.s_addr;
+        entry->key_port = host->port;
+        entry->used = 1;
+        directory->buckets[bucket] = index;
+        directory->count += 1;
+        if (index >= directory->high_water)
+            directory->high_water = index + 1;
+        added = 1;
+    }
+    else
+    {
+        net_directory_unlink(directory, index);
+    }
+
+    NetDirectoryEntry *entry = &directory->entries[index];
+    entry->host = *host;
+    entry->host.rtt_us = -1;
+    entry->host.last_seen_us = now_us;
+    net_directory_link_newest(directory, index);
+    return added;
+}
+
+int net_directory_remove(NetDirectory *directory, const char *address, int port)
+{
+    struct in_addr parsed;
+    if (!directory || !address || inet_pton(AF_INET, address, &parsed) != 1)
+        return 0;
+    unsigned int bucket = net_directory_find(directory, parsed.s_addr, port);
+    if (directory->buckets[bucket] == NET_DIRECTORY_NONE)
+        return 0;
+    net_directory_drop(directory, bucket);
+    return 1;
+}
+
+int net_directory_expire(NetDirectory *directory, uint64_t now_us, uint64_t ttl_us)
+{
+    if (!directory)
+        return 0;
+    int expired = 0;
+    while (directory->oldest != NET_DIRECTORY_NONE)
+    {
+        const NetDirectoryEntry *entry = &directory->entries[directory->oldest];
+        if (now_us - entry->host.last_seen_us <= ttl_us)
+            break;
+        net_directory_drop(directory, net_directory_find(directory, entry->key_address, entry->key_port));
+        ++expired;
+    }
+    return expired;
+}
+
+int net_directory_count(const NetDirectory *directory)
+{
+    return directory ? directory->count : 0;
+}
+
+static int net_directory_passes(const NetDirectoryEntry *entry, unsigned int flags)
+{
+    if (!entry->used)
+        return 0;
+    return !(flags & NET_DIRECTORY_JOINABLE) || net_lan_host_joinable(&entry->host);
+}
+
+int net_directory_list(const NetDirectory *directory, unsigned int cursor, unsigned int flags,
+                       NetLanHost *out_hosts, int max_hosts, unsigned int *out_next_cursor)
+{
+    if (out_next_cursor)
+        *out_next_cursor = 0;
+    if (!directory || !out_hosts || max_hosts <= 0)
+        return 0;
+
+    unsigned int end = (unsigned int)directory->high_water;
+    unsigned int index = cursor;
+    int copied = 0;
+    for (; index < end && copied < max_hosts; ++index)
+    {
+        if (net_directory_passes(&directory->entries[index], flags))
+            out_hosts[copied++] = directory->entries[index].host;
+    }
+    // Point the cursor at the next match, so the last page says it is the last
+    for (; index < end; ++index)
+    {
+        if (net_directory_passes(&directory->entries[index], flags))
+        {
+            if (out_next_cursor)
+                *out_next_cursor = index;
+            break;
+        }
+    }
+    return copied;
+}
+
+static int net_directory_wait_readable(net_socket_t sock, int wait_ms)
+{
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(sock, &readfds);
+    struct timeval wait;
+    wait.tv_sec = wait_ms / 1000;
+    wait.tv_usec = (wait_ms % 1000) * 1000;
+    net_io_count(NET_IO_WAIT);
+#if defined(_WIN32)
+    return select(0, &readfds, NULL, NULL, &wait);
+#else
+    return select((int)(sock + 1), &readfds, NULL, NULL, &wait);
+#endif
+}
+
+// Queries must be padded to the largest page, so a forged source address
+// never gets back more bytes than the sender spent
+static void net_directory_answer_query(NetDirectory *directory, net_socket_t sock, const struct sockaddr_in *from,
+                                       const char *arguments, size_t query_size)
+{
+    if (query_size < NET_DIRECTORY_DATAGRAM_MAX)
+        return;
+
+    unsigned int nonce = 0;
+    unsigned int cursor = 0;
+    int limit = 0;
+    unsigned int flags = 0;
+    if (sscanf(arguments, "%u %u %d %u", &nonce, &cursor, &limit, &flags) < 3)
+        return;
+    if (limit <= 0 || limit > NET_DIRECTORY_PAGE_SIZE)
+        limit = NET_DIRECTORY_PAGE_SIZE;
+
+    NetLanHost page[NET_DIRECTORY_PAGE_SIZE];
+    unsigned int next_cursor = 0;
+    int count = net_directory_list(directory, cursor, flags, page, limit, &next_cursor);
+
+    char reply[NET_DIRECTORY_DATAGRAM_MAX];
+    int length = snprintf(reply, sizeof(reply), "%s %u %d %u %d\n", ARMADA_DIRECTORY_PAGE, nonce,
+                          directory->count, next_cursor, count);
+    for (int i = 0; i < count && length > 0 && (size_t)length < sizeof(reply); ++i)
+    {
+        const NetLanHost *host = &page[i];
+        length += snprintf(reply + length, sizeof(reply) - (size_t)length, "%s %d %d %d %u %d %d\n", host->address,
+                           host->port, host->player_count, host->max_players, (unsigned int)host->server_id,
+                           host->phase, host->protocol_version);
+    }
+    if (length <= 0 || (size_t)length >= sizeof(reply))
+        return; // Cannot happen with page-sized replies; never send a truncated page
+
+    net_io_count(NET_IO_WRITE);
+    sendto(sock, reply, length, 0, (const struct sockaddr *)from, sizeof(*from));
+}
+
+static void net_directory_handle(NetDirectory *directory, net_socket_t sock, const struct sockaddr_in *from,
+                                 const char *payload, size_t payload_size, uint64_t now_us)
+{
+    size_t register_length = strlen(ARMADA_DIRECTORY_REGISTER);
+    size_t leave_length = strlen(ARMADA_DIRECTORY_LEAVE);
+    size_t query_length = strlen(ARMADA_DIRECTORY_QUERY);
+
+    if (strncmp(payload, ARMADA_DIRECTORY_REGISTER, register_length) == 0)
+    {
+        NetLanHost host;
+        if (!net_parse_lan_host(payload, ARMADA_DIRECTORY_REGISTER, from, &host) || host.port <= 0)
+            return;
+        int added = net_directory_update(directory, &host, now_us);
+        if (added > 0)
+            printf("[Directory] + %s:%d (%d listed)\n", host.address, host.port, directory->count);
+        else if (added < 0)
+            printf("[Directory] Full, ignoring %s:%d\n", host.address, host.port);
+    }
+    else if (strncmp(payload, ARMADA_DIRECTORY_LEAVE, leave_length) == 0)
+    {
+        int port = 0;
+        char address[64];
+        if (sscanf(payload + leave_length, "%d", &port) != 1 ||
+            !inet_ntop(AF_INET, &from->sin_addr, address, sizeof(address)))
+            return;
+        if (net_directory_remove(directory, address, port))
+            printf("[Directory] - %s:%d (%d listed)\n", address, port, directory->count);
+    }
+    else if (strncmp(payload, ARMADA_DIRECTORY_QUERY, query_length) == 0)
+    {
+        net_directory_answer_query(directory, sock, from, payload + query_length, payload_size);
+    }
+}
+
+/**
+ * Serve registrations and queries on one UDP socket. Each datagram is
+ * handled on arrival; expiry runs after every wait, so a stop request
+ * or a silent server is noticed within a quarter second.
+ */
+int net_directory_serve(int port, int capacity, volatile int *running)
+{
+    NetDirectory *directory = net_directory_create(capacity);
+    if (!directory)
+        return -1;
+
+    net_socket_t sock = net_create_udp_socket(port);
+    if (sock == NET_INVALID_SOCKET)
+    {
+        net_directory_destroy(directory);
+        return -1;
+    }
+    printf("[Directory] Listening on UDP port %d for up to %d servers\n", port, directory->capacity);
+    fflush(stdout);
+
+    uint64_t ttl_us = (uint64_t)NET_BEACON_TTL_MS * 1000ULL;
+    while (!running || *running)
+    {
+        int ready = net_directory_wait_readable(sock, 250);
+        if (ready < 0 && NET_ERRNO() != NET_EINTR)
+            break;
+
+        uint64_t now_us = net_monotonic_us();
+        for (;;)
+        {
+            struct sockaddr_in from;
+            socklen_t from_len = sizeof(from);
+            char buffer[NET_DIRECTORY_DATAGRAM_MAX + 1];
+            net_io_count(NET_IO_READ);
+            ssize_t len = recvfrom(sock, buffer, sizeof(buffer) - 1, 0, (struct sockaddr *)&from, &from_len);
+            if (len < 0)
+            {
+                if (NET_ERRNO() == NET_EINTR)
+                    continue;
+                break; // Drained
+            }
+            buffer[len] = '\0';
+            net_directory_handle(directory, sock, &from, buffer, (size_t)len, now_us);
+        }
+
+        int expired = net_directory_expire(directory, now_us, ttl_us);
+        if (expired > 0)
+            printf("[Directory] %d expired (%d listed)\n", expired, directory->count);
+        fflush(stdout);
+    }
+
+    net_close_socket(sock);
+    net_directory_destroy(directory);
+    return 0;
+}
+
+int net_directory_resolve(const char *directory, struct sockaddr_in *out_addr)
+{
+    if (!directory || !out_addr)
+        return -1;
+
+    char host[128];
+    int port = ARMADA_DIRECTORY_PORT;
+    strncpy(host, directory, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    char *colon = strrchr(host, ':');
+    if (colon)
+    {
+        *colon = '\0';
+        port = atoi(colon + 1);
+        if (port <= 0 || port > 65535)
+            return -1;
+    }
+
+    struct sockaddr_storage addresses[NET_CONNECT_MAX_ADDRESSES];
+    socklen_t lengths[NET_CONNECT_MAX_ADDRESSES];
+    int count = net_resolve_host(host, port, addresses, lengths, NET_CONNECT_MAX_ADDRESSES);
+    for (int i = 0; i < count; ++i)
+    {
+        if (addresses[i].ss_family == AF_INET)
+        {
+            memcpy(out_addr, &addresses[i], sizeof(*out_addr));
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Parse one page reply. Returns the number of hosts stored, -1 if it is not the awaited page.
+static int net_directory_parse_page(const char *reply, unsigned int nonce, NetLanHost *out_hosts, int max_hosts,
+                                    unsigned int *out_next_cursor, uint64_t now_us)
+{
+    size_t prefix_length = strlen(ARMADA_DIRECTORY_PAGE);
+    if (strncmp(reply, ARMADA_DIRECTORY_PAGE, prefix_length) != 0)
+        return -1;
+
+    unsigned int reply_nonce = 0;
+    int total = 0;
+    int count = 0;
+    if (sscanf(reply + prefix_length, "%u %d %u %d", &reply_nonce, &total, out_next_cursor, &count) != 4 ||
+        reply_nonce != nonce)
+        return -1;
+
+    int stored = 0;
+    const char *line = strchr(reply, '\n');
+    while (line && stored < count && stored < max_hosts)
+    {
+        ++line;
+        NetLanHost *host = &out_hosts[stored];
+        memset(host, 0, sizeof(*host));
+        unsigned int server_id = 0;
+        if (sscanf(line, "%63s %d %d %d %u %d %d", host->address, &host->port, &host->player_count,
+                   &host->max_players, &server_id, &host->phase, &host->protocol_version) == 7)
+        {
+            host->server_id = server_id;
+            host->rtt_us = -1;
+            host->last_seen_us = now_us;
+            ++stored;
+        }
+        line = strchr(line, '\n');
+    }
+    return stored;
+}
+
+int net_directory_fetch(const char *directory, unsigned int flags, NetLanHost *out_hosts, int max_hosts,
+                        int timeout_ms)
+{
+    struct sockaddr_in addr;
+    if (!out_hosts || max_hosts <= 0 || net_directory_resolve(directory, &addr) != 0)
+        return -1;
+    if (timeout_ms <= 0)
+        timeout_ms = 1000;
+
+    net_socket_t sock = net_create_udp_socket(0);
+    if (sock == NET_INVALID_SOCKET)
+        return -1;
+
+    uint64_t deadline_us = net_monotonic_us() + (uint64_t)timeout_ms * 1000ULL;
+    unsigned int nonce = (unsigned int)net_monotonic_us();
+    unsigned int cursor = 0;
+    int found = 0;
+    int answered = 0;
+    while (found < max_hosts)
+    {
+        ++nonce;
+        int limit = max_hosts - found < NET_DIRECTORY_PAGE_SIZE ? max_hosts - found : NET_DIRECTORY_PAGE_SIZE;
+        char query[NET_DIRECTORY_DATAGRAM_MAX];
+        int query_length = snprintf(query, sizeof(query), "%s %u %u %d %u", ARMADA_DIRECTORY_QUERY, nonce, cursor,
+                                    limit, flags);
+        // Pad to a full page; the directory ignores shorter queries
+        memset(query + query_length, ' ', sizeof(query) - (size_t)query_length);
+        query_length = (int)sizeof(query);
+
+        int page = -1;
+        unsigned int next_cursor = 0;
+        uint64_t now_us = net_monotonic_us();
+        uint64_t resend_us = now_us;
+        while (page < 0 && now_us < deadline_us)
+        {
+            if (now_us >= resend_us)
+            {
+                net_io_count(NET_IO_WRITE);
+                sendto(sock, query, query_length, 0, (const struct sockaddr *)&addr, sizeof(addr));
+                resend_us = now_us + (uint64_t)NET_DIRECTORY_RETRY_MS * 1000ULL;
+            }
+            uint64_t until_us = resend_us < deadline_us ? resend_us : deadline_us;
+            net_directory_wait_readable(sock, (int)((until_us - now_us + 999) / 1000));
+
+            char reply[NET_DIRECTORY_DATAGRAM_MAX + 1];
+            net_io_count(NET_IO_READ);
+            ssize_t len;
+            while (page < 0 && (len = recvfrom(sock, reply, sizeof(reply) - 1, 0, NULL, NULL)) >= 0)
+            {
+                reply[len] = '\0';
+                page = net_directory_parse_page(reply, nonce, &out_hosts[found], max_hosts - found, &next_cursor,
+                                                net_monotonic_us());
+            }
+            now_us = net_monotonic_us();
+        }
+        if (page < 0)
+            break; // Out of time: keep the pages that did arrive
+
+        answered = 1;
+        found += page;
+        if (next_cursor == 0)
+            break;
+        cursor = next_cursor;
+    }
+
+    net_close_socket(sock);
+    return answered ? found : -1;
+}
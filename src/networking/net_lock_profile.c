@@ -0,0 +1,373 @@
+#include "../../include/networking/net_lock_profile.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Bucket 0 holds everything under 1 << NET_LOCK_HISTOGRAM_SHIFT ns
+#define NET_LOCK_HISTOGRAM_SHIFT 8
+// A dump gives up on a lock after this many busy try-locks
+#define NET_LOCK_DUMP_ATTEMPTS 1000
+
+#if defined(_WIN32)
+static SRWLOCK net_lock_registry_lock = SRWLOCK_INIT;
+#define NET_LOCK_REGISTRY_LOCK() AcquireSRWLockExclusive(&net_lock_registry_lock)
+#define NET_LOCK_REGISTRY_UNLOCK() ReleaseSRWLockExclusive(&net_lock_registry_lock)
+#else
+static pthread_mutex_t net_lock_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+#define NET_LOCK_REGISTRY_LOCK() pthread_mutex_lock(&net_lock_registry_lock)
+#define NET_LOCK_REGISTRY_UNLOCK() pthread_mutex_unlock(&net_lock_registry_lock)
+#endif
+
+static NetProfiledMutex *net_lock_registry = NULL;
+static volatile long net_lock_profile_state = -1; // -1 until ARMADA_LOCK_PROFILE is read
+
+static long net_lock_load(volatile long *value)
+{
+#if defined(_MSC_VER)
+    return InterlockedCompareExchange(value, 0, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+#endif
+}
+
+static void net_lock_store(volatile long *value, long next)
+{
+#if defined(_MSC_VER)
+    InterlockedExchange(value, next);
+#else
+    __atomic_store_n(value, next, __ATOMIC_RELAXED);
+#endif
+}
+
+// The holder is published for dumps that find the lock busy
+static NetLockSite *net_lock_holder(NetProfiledMutex *mutex)
+{
+#if defined(_MSC_VER)
+    return (NetLockSite *)InterlockedCompareExchangePointer((PVOID volatile *)&mutex->holder, NULL, NULL);
+#else
+    return __atomic_load_n(&mutex->holder, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void net_lock_set_holder(NetProfiledMutex *mutex, NetLockSite *site)
+{
+#if defined(_MSC_VER)
+    InterlockedExchangePointer((PVOID volatile *)&mutex->holder, site);
+#else
+    __atomic_store_n(&mutex->holder, site, __ATOMIC_RELEASE);
+#endif
+}
+
+static uint64_t net_lock_now_ns(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000ULL +
+           (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000ULL / (uint64_t)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static int net_lock_bucket(uint64_t ns)
+{
+    int bucket = 0;
+    ns >>= NET_LOCK_HISTOGRAM_SHIFT;
+    while (ns != 0 && bucket < NET_LOCK_HISTOGRAM_BUCKETS - 1)
+    {
+        ns >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+// Called with the lock held
+static NetLockSite *net_lock_site(NetProfiledMutex *mutex, const char *file, int line)
+{
+    for (int i = 0; i < mutex->site_count; ++i)
+    {
+        NetLockSite *site = &mutex->sites[i];
+        if (site->line == line && site->file == file)
+            return site;
+    }
+    if (mutex->site_count == NET_LOCK_PROFILE_SITES)
+        return &mutex->other_sites;
+    NetLockSite *site = &mutex->sites[mutex->site_count++];
+    site->file = file;
+    site->line = line;
+    return site;
+}
+
+static void net_lock_clear(NetProfiledMutex *mutex)
+{
+    size_t offset = offsetof(NetProfiledMutex, acquisitions);
+    memset((unsigned char *)mutex + offset, 0, sizeof(*mutex) - offset);
+}
+
+int net_lock_profile_enabled(void)
+{
+    long state = net_lock_load(&net_lock_profile_state);
+    if (state < 0)
+    {
+        const char *setting = getenv("ARMADA_LOCK_PROFILE");
+        state = setting && *setting && strcmp(setting, "0") != 0;
+        net_lock_store(&net_lock_profile_state, state);
+    }
+    return (int)state;
+}
+
+void net_lock_profile_enable(int enabled)
+{
+    net_lock_store(&net_lock_profile_state, enabled ? 1 : 0);
+}
+
+/**
+ * Initialise the mutex and register it under name for dumps.
+ */
+int net_profiled_mutex_init(NetProfiledMutex *mutex, const char *name)
+{
+    if (!mutex)
+        return -1;
+    memset(mutex, 0, sizeof(*mutex));
+    if (net_mutex_init(&mutex->mutex) != 0)
+        return -1;
+    mutex->name = name ? name : "unnamed";
+
+    NET_LOCK_REGISTRY_LOCK();
+    mutex->next_registered = net_lock_registry;
+    net_lock_registry = mutex;
+    NET_LOCK_REGISTRY_UNLOCK();
+    return 0;
+}
+
+void net_profiled_mutex_destroy(NetProfiledMutex *mutex)
+{
+    if (!mutex)
+        return;
+    NET_LOCK_REGISTRY_LOCK();
+    NetProfiledMutex **link = &net_lock_registry;
+    while (*link && *link != mutex)
+        link = &(*link)->next_registered;
+    if (*link)
+        *link = mutex->next_registered;
+    NET_LOCK_REGISTRY_UNLOCK();
+    net_mutex_destroy(&mutex->mutex);
+}
+
+/**
+ * Take the lock on behalf of file:line. The wait is charged once the lock
+ * is ours, so every statistic is written by the holder alone.
+ */
+void net_profiled_mutex_lock_at(NetProfiledMutex *mutex, const char *file, int line)
+{
+    if (!net_lock_profile_enabled())
+    {
+        net_mutex_lock(&mutex->mutex);
+        return;
+    }
+
+    uint64_t wait_ns = 0;
+    int contended = 0;
+    if (net_mutex_trylock(&mutex->mutex) != 0)
+    {
+        uint64_t start_ns = net_lock_now_ns();
+        net_mutex_lock(&mutex->mutex);
+        wait_ns = net_lock_now_ns() - start_ns;
+        contended = 1;
+    }
+
+    NetLockSite *site = net_lock_site(mutex, file, line);
+    mutex->acquisitions += 1;
+    mutex->contended += (unsigned long)contended;
+    mutex->wait_ns += wait_ns;
+    if (wait_ns > mutex->max_wait_ns)
+        mutex->max_wait_ns = wait_ns;
+    mutex->wait_histogram[net_lock_bucket(wait_ns)] += 1;
+    site->acquisitions += 1;
+    site->contended += (unsigned long)contended;
+    site->wait_ns += wait_ns;
+
+    mutex->acquired_ns = net_lock_now_ns();
+    net_lock_set_holder(mutex, site);
+}
+
+/**
+ * Charge the hold to the site that took the lock, then release it. Holds
+ * taken while profiling was off are not charged.
+ */
+void net_profiled_mutex_unlock(NetProfiledMutex *mutex)
+{
+    NetLockSite *site = mutex->holder;
+    if (site)
+    {
+        uint64_t hold_ns = net_lock_now_ns() - mutex->acquired_ns;
+        mutex->hold_ns += hold_ns;
+        if (hold_ns > mutex->max_hold_ns)
+            mutex->max_hold_ns = hold_ns;
+        mutex->hold_histogram[net_lock_bucket(hold_ns)] += 1;
+        site->hold_ns += hold_ns;
+        if (hold_ns > site->max_hold_ns)
+            site->max_hold_ns = hold_ns;
+        net_lock_set_holder(mutex, NULL);
+    }
+    net_mutex_unlock(&mutex->mutex);
+}
+
+void net_lock_profile_reset(void)
+{
+    NET_LOCK_REGISTRY_LOCK();
+    for (NetProfiledMutex *mutex = net_lock_registry; mutex; mutex = mutex->next_registered)
+    {
+        net_mutex_lock(&mutex->mutex);
+        net_lock_clear(mutex);
+        net_mutex_unlock(&mutex->mutex);
+    }
+    NET_LOCK_REGISTRY_UNLOCK();
+}
+
+static const char *net_lock_format_ns(char *buffer, size_t size, uint64_t ns)
+{
+    if (ns < 1000ULL)
+        snprintf(buffer, size, "%uns", (unsigned int)ns);
+    else if (ns < 1000000ULL)
+        snprintf(buffer, size, "%.1fus", (double)ns / 1e3);
+    else if (ns < 1000000000ULL)
+        snprintf(buffer, size, "%.1fms", (double)ns / 1e6);
+    else
+        snprintf(buffer, size, "%.2fs", (double)ns / 1e9);
+    return buffer;
+}
+
+static const char *net_lock_basename(const char *file)
+{
+    const char *slash = strrchr(file, '/');
+    const char *backslash = strrchr(file, '\\');
+    if (backslash > slash)
+        slash = backslash;
+    return slash ? slash + 1 : file;
+}
+
+// "wait: <256ns 120, 256ns+ 4, ..." listing only the buckets in use
+static void net_lock_dump_histogram(const char *label, const unsigned long *histogram, NetLockProfileSink sink,
+                                    void *userdata)
+{
+    char line[512];
+    int length = snprintf(line, sizeof(line), "[Locks]   %s:", label);
+    for (int bucket = 0; bucket < NET_LOCK_HISTOGRAM_BUCKETS && length > 0 && (size_t)length < sizeof(line); ++bucket)
+    {
+        if (histogram[bucket] == 0)
+            continue;
+        char bound[32];
+        if (bucket == 0)
+        {
+            net_lock_format_ns(bound, sizeof(bound), 1ULL << NET_LOCK_HISTOGRAM_SHIFT);
+            length += snprintf(line + length, sizeof(line) - (size_t)length, " <%s %lu", bound, histogram[bucket]);
+        }
+        else
+        {
+            net_lock_format_ns(bound, sizeof(bound), 1ULL << (NET_LOCK_HISTOGRAM_SHIFT + bucket - 1));
+            length += snprintf(line + length, sizeof(line) - (size_t)length, " %s+ %lu", bound, histogram[bucket]);
+        }
+    }
+    sink(line, userdata);
+}
+
+static void net_lock_dump_site(const NetLockSite *site, NetLockProfileSink sink, void *userdata)
+{
+    char line[256];
+    char wait[32];
+    char hold[32];
+    char max_hold[32];
+    char where[96];
+    if (site->file)
+        snprintf(where, sizeof(where), "%s:%d", net_lock_basename(site->file), site->line);
+    else
+        snprintf(where, sizeof(where), "(other sites)");
+    snprintf(line, sizeof(line), "[Locks]   %-28s %8lu taken %6lu waited  wait %9s  hold %9s  max hold %9s", where,
+             site->acquisitions, site->contended, net_lock_format_ns(wait, sizeof(wait), site->wait_ns),
+             net_lock_format_ns(hold, sizeof(hold), site->hold_ns),
+             net_lock_format_ns(max_hold, sizeof(max_hold), site->max_hold_ns));
+    sink(line, userdata);
+}
+
+static int net_lock_compare_hold(const void *left, const void *right)
+{
+    uint64_t a = ((const NetLockSite *)left)->hold_ns;
+    uint64_t b = ((const NetLockSite *)right)->hold_ns;
+    return a < b ? 1 : (a > b ? -1 : 0);
+}
+
+static void net_lock_dump_one(NetProfiledMutex *mutex, NetLockProfileSink sink, void *userdata)
+{
+    char line[256];
+    int attempts = 0;
+    while (net_mutex_trylock(&mutex->mutex) != 0)
+    {
+        if (++attempts == NET_LOCK_DUMP_ATTEMPTS)
+        {
+            // Likely stuck; say who has it rather than joining the queue
+            NetLockSite *holder = net_lock_holder(mutex);
+            if (holder && holder->file)
+                snprintf(line, sizeof(line), "[Locks] %s: busy, held at %s:%d", mutex->name,
+                         net_lock_basename(holder->file), holder->line);
+            else
+                snprintf(line, sizeof(line), "[Locks] %s: busy", mutex->name);
+            sink(line, userdata);
+            return;
+        }
+        net_thread_yield();
+    }
+    // Report from a copy so the sink never runs under the lock it describes
+    NetProfiledMutex copy = *mutex;
+    net_mutex_unlock(&mutex->mutex);
+
+    char wait[32];
+    char max_wait[32];
+    char hold[32];
+    char max_hold[32];
+    snprintf(line, sizeof(line), "[Locks] %s: %lu taken, %lu waited; wait %s (max %s), hold %s (max %s)", copy.name,
+             copy.acquisitions, copy.contended, net_lock_format_ns(wait, sizeof(wait), copy.wait_ns),
+             net_lock_format_ns(max_wait, sizeof(max_wait), copy.max_wait_ns),
+             net_lock_format_ns(hold, sizeof(hold), copy.hold_ns),
+             net_lock_format_ns(max_hold, sizeof(max_hold), copy.max_hold_ns));
+    sink(line, userdata);
+    if (copy.acquisitions == 0)
+        return;
+
+    net_lock_dump_histogram("wait", copy.wait_histogram, sink, userdata);
+    net_lock_dump_histogram("hold", copy.hold_histogram, sink, userdata);
+    qsort(copy.sites, (size_t)copy.site_count, sizeof(NetLockSite), net_lock_compare_hold);
+    for (int i = 0; i < copy.site_count; ++i)
+        net_lock_dump_site(&copy.sites[i], sink, userdata);
+    if (copy.other_sites.acquisitions > 0)
+        net_lock_dump_site(&copy.other_sites, sink, userdata);
+}
+
+/**
+ * Report each registered lock: totals, wait and hold histograms, then its
+ * call sites by total hold time. Each lock is copied under a try-lock and
+ * reported after release; one that stays busy is reported by its holder.
+ */
+void net_lock_profile_dump(NetLockProfileSink sink, void *userdata)
+{
+    if (!sink)
+        return;
+    if (!net_lock_profile_enabled())
+    {
+        sink("[Locks] Profiling is off; set ARMADA_LOCK_PROFILE=1 to record lock contention", userdata);
+        return;
+    }
+    NET_LOCK_REGISTRY_LOCK();
+    for (NetProfiledMutex *mutex = net_lock_registry; mutex; mutex = mutex->next_registered)
+        net_lock_dump_one(mutex, sink, userdata);
+    NET_LOCK_REGISTRY_UNLOCK();
+}
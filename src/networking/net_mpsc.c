@@ -0,0 +1,164 @@
+#include "../../include/networking/net_mpsc.h"
+#include "../../include/networking/net_platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Items start this far into a cell, aligned for any field they hold
+#define NET_MPSC_ITEM_OFFSET 16
+// Keeps the producers' cursor off the consumer's cache line
+#define NET_MPSC_CACHE_LINE 64
+
+struct NetMpscQueue
+{
+    unsigned char *cells; // capacity cells: a sequence number, then the item
+    size_t cell_size;
+    size_t item_size;
+    unsigned long mask;
+    unsigned long dequeue_pos; // Consumer only
+    char pad[NET_MPSC_CACHE_LINE];
+    volatile long enqueue_pos; // Claimed by producers with compare-and-swap
+};
+
+static volatile long *net_mpsc_sequence(NetMpscQueue *queue, unsigned long pos)
+{
+    return (volatile long *)(queue->cells + (size_t)(pos & queue->mask) * queue->cell_size);
+}
+
+static unsigned long net_mpsc_load(volatile long *value)
+{
+#if defined(_MSC_VER)
+    return (unsigned long)InterlockedCompareExchange(value, 0, 0);
+#else
+    return (unsigned long)__atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void net_mpsc_store(volatile long *value, unsigned long next)
+{
+#if defined(_MSC_VER)
+    InterlockedExchange(value, (long)next);
+#else
+    __atomic_store_n(value, (long)next, __ATOMIC_RELEASE);
+#endif
+}
+
+// Returns the value seen before the swap; the swap happened if it equals expected
+static unsigned long net_mpsc_compare_swap(volatile long *value, unsigned long expected, unsigned long next)
+{
+#if defined(_MSC_VER)
+    return (unsigned long)InterlockedCompareExchange(value, (long)next, (long)expected);
+#else
+    long seen = (long)expected;
+    __atomic_compare_exchange_n(value, &seen, (long)next, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    return (unsigned long)seen;
+#endif
+}
+
+/**
+ * Allocate a queue of at least capacity items of item_size bytes.
+ */
+NetMpscQueue *net_mpsc_create(size_t capacity, size_t item_size)
+{
+    if (capacity < 2 || item_size == 0)
+        return NULL;
+
+    size_t rounded = 2;
+    while (rounded < capacity)
+        rounded <<= 1;
+
+    NetMpscQueue *queue = (NetMpscQueue *)calloc(1, sizeof(NetMpscQueue));
+    if (!queue)
+        return NULL;
+    queue->item_size = item_size;
+    queue->cell_size = NET_MPSC_ITEM_OFFSET + (item_size + NET_MPSC_ITEM_OFFSET - 1) / NET_MPSC_ITEM_OFFSET * NET_MPSC_ITEM_OFFSET;
+    queue->mask = (unsigned long)(rounded - 1);
+    queue->cells = (unsigned char *)calloc(rounded, queue->cell_size);
+    if (!queue->cells)
+    {
+        free(queue);
+        return NULL;
+    }
+    // Cell i is free for the producer that claims position i
+    for (size_t i = 0; i < rounded; ++i)
+    {
+        net_mpsc_store(net_mpsc_sequence(queue, (unsigned long)i), (unsigned long)i);
+    }
+    return queue;
+}
+
+/**
+ * Free a queue. Items still inside are dropped.
+ */
+void net_mpsc_destroy(NetMpscQueue *queue)
+{
+    if (!queue)
+        return;
+    free(queue->cells);
+    free(queue);
+}
+
+/**
+ * Claim the next position and copy the item into its cell. The cell becomes
+ * visible to the consumer only once the copy is complete.
+ */
+int net_mpsc_push(NetMpscQueue *queue, const void *item)
+{
+    if (!queue || !item)
+        return 0;
+
+    unsigned long pos = net_mpsc_load(&queue->enqueue_pos);
+    volatile long *sequence;
+    for (;;)
+    {
+        sequence = net_mpsc_sequence(queue, pos);
+        long turn = (long)(net_mpsc_load(sequence) - pos);
+        if (turn == 0)
+        {
+            unsigned long seen = net_mpsc_compare_swap(&queue->enqueue_pos, pos, pos + 1);
+            if (seen == pos)
+                break;
+            pos = seen; // Another producer took it
+        }
+        else if (turn < 0)
+        {
+            return 0; // The consumer has not emptied this cell since the last lap
+        }
+        else
+        {
+            pos = net_mpsc_load(&queue->enqueue_pos);
+        }
+    }
+
+    memcpy((unsigned char *)sequence + NET_MPSC_ITEM_OFFSET, item, queue->item_size);
+    net_mpsc_store(sequence, pos + 1);
+    return 1;
+}
+
+/**
+ * Copy out the oldest item and hand its cell back to the producers' next lap.
+ */
+int net_mpsc_pop(NetMpscQueue *queue, void *out_item)
+{
+    if (!queue || !out_item || net_mpsc_empty(queue))
+        return 0;
+
+    unsigned long pos = queue->dequeue_pos;
+    volatile long *sequence = net_mpsc_sequence(queue, pos);
+    memcpy(out_item, (const unsigned char *)sequence + NET_MPSC_ITEM_OFFSET, queue->item_size);
+    net_mpsc_store(sequence, pos + queue->mask + 1);
+    queue->dequeue_pos = pos + 1;
+    return 1;
+}
+
+/**
+ * A claimed cell whose copy is still in progress counts as empty; the pop
+ * after the producer finishes will find it.
+ */
+int net_mpsc_empty(NetMpscQueue *queue)
+{
+    if (!queue)
+        return 1;
+    unsigned long pos = queue->dequeue_pos;
+    return (long)(net_mpsc_load(net_mpsc_sequence(queue, pos)) - (pos + 1)) < 0;
+}
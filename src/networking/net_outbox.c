@@ -0,0 +1,128 @@
+#include "../../include/networking/net_outbox.h"
+#include "../../include/networking/network.h"
+#include <string.h>
+
+#if defined(_WIN32)
+// Winsock has no per-call nonblocking flag; server sockets are switched
+// to nonblocking mode with net_set_nonblocking() instead
+#define NET_OUTBOX_SEND_FLAGS 0
+#else
+#define NET_OUTBOX_SEND_FLAGS (MSG_DONTWAIT | NET_MSG_NOSIGNAL)
+#endif
+
+/**
+ * Empty the outbox and bind it to sock (NET_INVALID_SOCKET detaches it).
+ */
+void net_outbox_reset(NetOutbox *outbox, net_socket_t sock)
+{
+    if (!outbox)
+        return;
+    outbox->sock = sock;
+    outbox->head = 0;
+    outbox->count = 0;
+    outbox->head_offset = 0;
+    outbox->dropped_frames = 0;
+    outbox->coalesced_frames = 0;
+}
+
+/**
+ * Append an encoded frame to the tail of the outbox.
+ */
+int net_outbox_push(NetOutbox *outbox, const unsigned char *frame, size_t len)
+{
+    if (!outbox || !frame || len == 0 || len > NET_FRAME_MAX_SIZE || outbox->sock == NET_INVALID_SOCKET)
+        return 0;
+    if (outbox->count == NET_OUTBOX_CAPACITY)
+        return 0;
+
+    NetOutboxFrame *slot = &outbox->frames[(outbox->head + outbox->count) % NET_OUTBOX_CAPACITY];
+    memcpy(slot->data, frame, len);
+    slot->length = len;
+    outbox->count += 1;
+    return 1;
+}
+
+/**
+ * Remove every queued frame whose type is in type_mask, keeping the order of the rest.
+ * A head frame that is partly on the wire must be finished, so it is always kept.
+ */
+size_t net_outbox_discard(NetOutbox *outbox, unsigned int type_mask)
+{
+    if (!outbox || outbox->count == 0)
+        return 0;
+
+    size_t first = outbox->head_offset > 0 ? 1 : 0;
+    size_t kept = first;
+    for (size_t i = first; i < outbox->count; ++i)
+    {
+        NetOutboxFrame *frame = &outbox->frames[(outbox->head + i) % NET_OUTBOX_CAPACITY];
+        unsigned int type = frame->data[NET_FRAME_LENGTH_SIZE + 1];
+        if (type < 32 && (type_mask & NET_OUTBOX_TYPE_BIT(type)))
+        {
+            continue;
+        }
+        if (kept != i)
+        {
+            NetOutboxFrame *dst = &outbox->frames[(outbox->head + kept) % NET_OUTBOX_CAPACITY];
+            memcpy(dst->data, frame->data, frame->length);
+            dst->length = frame->length;
+        }
+        kept += 1;
+    }
+
+    size_t removed = outbox->count - kept;
+    outbox->count = kept;
+    return removed;
+}
+
+/**
+ * Write queued frames until the outbox is empty or the socket's send buffer is full.
+ * Every queued frame goes out in one gathered write, so a burst costs one system
+ * call. Partial writes are remembered in head_offset and resumed on the next call.
+ */
+int net_outbox_flush(NetOutbox *outbox)
+{
+    if (!outbox || outbox->sock == NET_INVALID_SOCKET)
+        return -1;
+
+    while (outbox->count > 0)
+    {
+        NetIoSlice slices[NET_OUTBOX_CAPACITY];
+        for (size_t i = 0; i < outbox->count; ++i)
+        {
+            const NetOutboxFrame *frame = &outbox->frames[(outbox->head + i) % NET_OUTBOX_CAPACITY];
+            size_t skip = i == 0 ? outbox->head_offset : 0;
+            slices[i].data = frame->data + skip;
+            slices[i].length = frame->length - skip;
+        }
+
+        ssize_t sent = net_sendv(outbox->sock, slices, outbox->count, NET_OUTBOX_SEND_FLAGS);
+        if (sent == NET_SOCKET_ERROR)
+        {
+            int err = NET_ERRNO();
+            if (err == NET_EINTR)
+                continue;
+            if (err == NET_EAGAIN || err == NET_EWOULDBLOCK)
+                return 0;
+            net_log_socket_error("send");
+            return -1;
+        }
+        if (sent == 0)
+            return -1;
+
+        size_t written = (size_t)sent;
+        while (outbox->count > 0 && written >= outbox->frames[outbox->head].length - outbox->head_offset)
+        {
+            written -= outbox->frames[outbox->head].length - outbox->head_offset;
+            outbox->head = (outbox->head + 1) % NET_OUTBOX_CAPACITY;
+            outbox->count -= 1;
+            outbox->head_offset = 0;
+        }
+        if (outbox->count > 0)
+        {
+            outbox->head_offset += written;
+            return 0; // Kernel buffer is full
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,544 @@
+#include "../../include/networking/net_reactor.h"
+#include "../../include/networking/net_uring.h"
+#include "../../include/networking/network.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#define NET_REACTOR_USE_EPOLL 1
+#elif !defined(_WIN32)
+#include <poll.h>
+#include <fcntl.h>
+#endif
+
+#if defined(NET_REACTOR_USE_EPOLL)
+
+// Largest batch fetched from the kernel per net_reactor_wait call
+#define NET_REACTOR_BATCH 64
+
+#define NET_REACTOR_NATIVE_NAME "epoll"
+
+typedef struct
+{
+    int epoll_fd;
+    int wake_fd; // eventfd, registered with the reactor itself as userdata
+} NetReactorNative;
+
+static unsigned int net_reactor_to_epoll(unsigned int interest)
+{
+    unsigned int events = EPOLLET | EPOLLRDHUP;
+    if (interest & NET_REACTOR_READ)
+        events |= EPOLLIN;
+    if (interest & NET_REACTOR_WRITE)
+        events |= EPOLLOUT;
+    return events;
+}
+
+static void net_reactor_native_destroy(NetReactorNative *reactor)
+{
+    if (reactor->wake_fd >= 0)
+        close(reactor->wake_fd);
+    if (reactor->epoll_fd >= 0)
+        close(reactor->epoll_fd);
+}
+
+static int net_reactor_native_create(NetReactorNative *reactor)
+{
+    reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    reactor->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (reactor->epoll_fd < 0 || reactor->wake_fd < 0)
+    {
+        net_log_socket_error("epoll_create1");
+        net_reactor_native_destroy(reactor);
+        return -1;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = reactor;
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->wake_fd, &ev) != 0)
+    {
+        net_log_socket_error("epoll_ctl");
+        net_reactor_native_destroy(reactor);
+        return -1;
+    }
+    return 0;
+}
+
+static int net_reactor_ctl(NetReactorNative *reactor, int op, net_socket_t sock, unsigned int interest, void *userdata)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = net_reactor_to_epoll(interest);
+    ev.data.ptr = userdata;
+    net_io_count(NET_IO_CONTROL);
+    if (epoll_ctl(reactor->epoll_fd, op, sock, &ev) != 0)
+    {
+        net_log_socket_error("epoll_ctl");
+        return -1;
+    }
+    return 0;
+}
+
+static int net_reactor_native_add(NetReactorNative *reactor, net_socket_t sock, unsigned int interest, void *userdata)
+{
+    return net_reactor_ctl(reactor, EPOLL_CTL_ADD, sock, interest, userdata);
+}
+
+static int net_reactor_native_modify(NetReactorNative *reactor, net_socket_t sock, unsigned int interest, void *userdata)
+{
+    return net_reactor_ctl(reactor, EPOLL_CTL_MOD, sock, interest, userdata);
+}
+
+static int net_reactor_native_remove(NetReactorNative *reactor, net_socket_t sock)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    net_io_count(NET_IO_CONTROL);
+    return epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, sock, &ev) == 0 ? 0 : -1;
+}
+
+static int net_reactor_native_wait(NetReactorNative *reactor, NetReactorEvent *events, int max_events, int timeout_ms)
+{
+    struct epoll_event ready[NET_REACTOR_BATCH];
+    int batch = max_events < NET_REACTOR_BATCH ? max_events : NET_REACTOR_BATCH;
+    net_io_count(NET_IO_WAIT);
+    int count = epoll_wait(reactor->epoll_fd, ready, batch, timeout_ms);
+    if (count < 0)
+    {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    int stored = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (ready[i].data.ptr == reactor)
+        {
+            uint64_t value;
+            net_io_count(NET_IO_READ);
+            while (read(reactor->wake_fd, &value, sizeof(value)) > 0)
+            {
+            }
+            continue;
+        }
+
+        unsigned int flags = 0;
+        if (ready[i].events & EPOLLIN)
+            flags |= NET_REACTOR_READ;
+        if (ready[i].events & EPOLLOUT)
+            flags |= NET_REACTOR_WRITE;
+        if (ready[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP))
+            flags |= NET_REACTOR_HANGUP;
+        events[stored].userdata = ready[i].data.ptr;
+        events[stored].events = flags;
+        events[stored].accepted = NET_INVALID_SOCKET;
+        events[stored].data = NULL;
+        events[stored].length = 0;
+        stored++;
+    }
+    return stored;
+}
+
+static void net_reactor_native_wake(NetReactorNative *reactor)
+{
+    uint64_t one = 1;
+    net_io_count(NET_IO_CONTROL);
+    ssize_t written = write(reactor->wake_fd, &one, sizeof(one));
+    (void)written; // A full counter already guarantees a wake-up
+}
+
+#else // poll()/WSAPoll() fallback
+
+#if defined(_WIN32)
+typedef WSAPOLLFD net_pollfd_t;
+#define net_poll(fds, count, timeout) WSAPoll((fds), (ULONG)(count), (timeout))
+#else
+typedef struct pollfd net_pollfd_t;
+#define net_poll(fds, count, timeout) poll((fds), (nfds_t)(count), (timeout))
+#endif
+
+typedef struct
+{
+    net_socket_t sock;
+    unsigned int interest;
+    void *userdata;
+} NetReactorEntry;
+
+#define NET_REACTOR_NATIVE_NAME "poll"
+
+typedef struct
+{
+    net_mutex_t mutex; // Guards entries; the waiting thread polls a copy
+    NetReactorEntry *entries;
+    size_t count;
+    size_t capacity;
+
+    net_pollfd_t *fds; // Scratch space owned by the waiting thread
+    void **fd_userdata;
+    size_t fds_capacity;
+
+    net_socket_t wake_recv;
+    net_socket_t wake_send;
+} NetReactorNative;
+
+#if defined(_WIN32)
+// Winsock cannot poll pipes, so wake-ups travel over a loopback UDP socket connected to itself
+static int net_reactor_open_wake(NetReactorNative *reactor)
+{
+    net_socket_t sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock == NET_INVALID_SOCKET)
+        return -1;
+
+    struct sockaddr_in addr;
+    int addrlen = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) == NET_SOCKET_ERROR ||
+        getsockname(sock, (struct sockaddr *)&addr, &addrlen) == NET_SOCKET_ERROR ||
+        connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == NET_SOCKET_ERROR)
+    {
+        net_close_socket(sock);
+        return -1;
+    }
+    net_set_nonblocking(sock);
+    reactor->wake_recv = sock;
+    reactor->wake_send = sock;
+    return 0;
+}
+#else
+static int net_reactor_open_wake(NetReactorNative *reactor)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+        return -1;
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL, 0) | O_NONBLOCK);
+    reactor->wake_recv = fds[0];
+    reactor->wake_send = fds[1];
+    return 0;
+}
+#endif
+
+static int net_reactor_native_create(NetReactorNative *reactor)
+{
+    reactor->wake_recv = NET_INVALID_SOCKET;
+    reactor->wake_send = NET_INVALID_SOCKET;
+    if (net_reactor_open_wake(reactor) != 0)
+    {
+        net_log_socket_error("reactor wake");
+        return -1;
+    }
+    net_mutex_init(&reactor->mutex);
+    return 0;
+}
+
+static void net_reactor_native_destroy(NetReactorNative *reactor)
+{
+#if defined(_WIN32)
+    net_close_socket(reactor->wake_recv);
+#else
+    close(reactor->wake_recv);
+    close(reactor->wake_send);
+#endif
+    net_mutex_destroy(&reactor->mutex);
+    free(reactor->entries);
+    free(reactor->fds);
+    free(reactor->fd_userdata);
+}
+
+static NetReactorEntry *net_reactor_find(NetReactorNative *reactor, net_socket_t sock)
+{
+    for (size_t i = 0; i < reactor->count; ++i)
+    {
+        if (reactor->entries[i].sock == sock)
+            return &reactor->entries[i];
+    }
+    return NULL;
+}
+
+static void net_reactor_native_wake(NetReactorNative *reactor);
+
+static int net_reactor_native_add(NetReactorNative *reactor, net_socket_t sock, unsigned int interest, void *userdata)
+{
+    net_mutex_lock(&reactor->mutex);
+    if (reactor->count == reactor->capacity)
+    {
+        size_t capacity = reactor->capacity ? reactor->capacity * 2 : 16;
+        NetReactorEntry *entries = (NetReactorEntry *)realloc(reactor->entries, capacity * sizeof(NetReactorEntry));
+        if (!entries)
+        {
+            net_mutex_unlock(&reactor->mutex);
+            return -1;
+        }
+        reactor->entries = entries;
+        reactor->capacity = capacity;
+    }
+    reactor->entries[reactor->count].sock = sock;
+    reactor->entries[reactor->count].interest = interest;
+    reactor->entries[reactor->count].userdata = userdata;
+    reactor->count++;
+    net_mutex_unlock(&reactor->mutex);
+
+    net_reactor_native_wake(reactor);
+    return 0;
+}
+
+static int net_reactor_native_modify(NetReactorNative *reactor, net_socket_t sock, unsigned int interest, void *userdata)
+{
+    net_mutex_lock(&reactor->mutex);
+    NetReactorEntry *entry = net_reactor_find(reactor, sock);
+    if (entry)
+    {
+        entry->interest = interest;
+        entry->userdata = userdata;
+    }
+    net_mutex_unlock(&reactor->mutex);
+
+    if (!entry)
+        return -1;
+    net_reactor_native_wake(reactor);
+    return 0;
+}
+
+static int net_reactor_native_remove(NetReactorNative *reactor, net_socket_t sock)
+{
+    net_mutex_lock(&reactor->mutex);
+    NetReactorEntry *entry = net_reactor_find(reactor, sock);
+    if (entry)
+    {
+        *entry = reactor->entries[reactor->count - 1];
+        reactor->count--;
+    }
+    net_mutex_unlock(&reactor->mutex);
+    return entry ? 0 : -1;
+}
+
+static int net_reactor_native_wait(NetReactorNative *reactor, NetReactorEvent *events, int max_events, int timeout_ms)
+{
+    net_mutex_lock(&reactor->mutex);
+    size_t needed = reactor->count + 1;
+    if (needed > reactor->fds_capacity)
+    {
+        net_pollfd_t *fds = (net_pollfd_t *)realloc(reactor->fds, needed * sizeof(net_pollfd_t));
+        void **userdata = fds ? (void **)realloc(reactor->fd_userdata, needed * sizeof(void *)) : NULL;
+        if (!fds || !userdata)
+        {
+            if (fds)
+                reactor->fds = fds;
+            net_mutex_unlock(&reactor->mutex);
+            return -1;
+        }
+        reactor->fds = fds;
+        reactor->fd_userdata = userdata;
+        reactor->fds_capacity = needed;
+    }
+
+    reactor->fds[0].fd = reactor->wake_recv;
+    reactor->fds[0].events = POLLIN;
+    reactor->fds[0].revents = 0;
+    for (size_t i = 0; i < reactor->count; ++i)
+    {
+        net_pollfd_t *pfd = &reactor->fds[i + 1];
+        pfd->fd = reactor->entries[i].sock;
+        pfd->events = 0;
+        if (reactor->entries[i].interest & NET_REACTOR_READ)
+            pfd->events |= POLLIN;
+        if (reactor->entries[i].interest & NET_REACTOR_WRITE)
+            pfd->events |= POLLOUT;
+        pfd->revents = 0;
+        reactor->fd_userdata[i + 1] = reactor->entries[i].userdata;
+    }
+    size_t polled = needed;
+    net_mutex_unlock(&reactor->mutex);
+
+    net_io_count(NET_IO_WAIT);
+    int ready = net_poll(reactor->fds, polled, timeout_ms);
+    if (ready < 0)
+    {
+        return NET_ERRNO() == NET_EINTR ? 0 : -1;
+    }
+
+    if (reactor->fds[0].revents)
+    {
+        char drain[64];
+        net_io_count(NET_IO_READ);
+#if defined(_WIN32)
+        while (recv(reactor->wake_recv, drain, sizeof(drain), 0) > 0)
+#else
+        while (read(reactor->wake_recv, drain, sizeof(drain)) > 0)
+#endif
+        {
+        }
+    }
+
+    int stored = 0;
+    for (size_t i = 1; i < polled && stored < max_events; ++i)
+    {
+        short revents = reactor->fds[i].revents;
+        if (!revents)
+            continue;
+        unsigned int flags = 0;
+        if (revents & POLLIN)
+            flags |= NET_REACTOR_READ;
+        if (revents & POLLOUT)
+            flags |= NET_REACTOR_WRITE;
+        if (revents & (POLLHUP | POLLERR | POLLNVAL))
+            flags |= NET_REACTOR_HANGUP;
+        events[stored].userdata = reactor->fd_userdata[i];
+        events[stored].events = flags;
+        events[stored].accepted = NET_INVALID_SOCKET;
+        events[stored].data = NULL;
+        events[stored].length = 0;
+        stored++;
+    }
+    return stored;
+}
+
+static void net_reactor_native_wake(NetReactorNative *reactor)
+{
+    char byte = 1;
+    net_io_count(NET_IO_CONTROL);
+#if defined(_WIN32)
+    send(reactor->wake_send, &byte, 1, 0);
+#else
+    ssize_t written = write(reactor->wake_send, &byte, 1);
+    (void)written; // A full pipe already guarantees a wake-up
+#endif
+}
+
+#endif
+
+struct NetReactor
+{
+    NetUring *uring; // Set for NET_REACTOR_BACKEND_URING, which replaces native
+    NetReactorNative native;
+};
+
+NetReactor *net_reactor_create(void)
+{
+    return net_reactor_create_backend(NET_REACTOR_BACKEND_DEFAULT);
+}
+
+NetReactor *net_reactor_create_backend(NetReactorBackend backend)
+{
+    NetReactor *reactor = (NetReactor *)calloc(1, sizeof(NetReactor));
+    if (!reactor)
+        return NULL;
+
+    if (backend == NET_REACTOR_BACKEND_URING)
+    {
+        reactor->uring = net_uring_create();
+        if (!reactor->uring)
+        {
+            free(reactor);
+            return NULL;
+        }
+        return reactor;
+    }
+
+    if (net_reactor_native_create(&reactor->native) != 0)
+    {
+        free(reactor);
+        return NULL;
+    }
+    return reactor;
+}
+
+void net_reactor_destroy(NetReactor *reactor)
+{
+    if (!reactor)
+        return;
+    if (reactor->uring)
+        net_uring_destroy(reactor->uring);
+    else
+        net_reactor_native_destroy(&reactor->native);
+    free(reactor);
+}
+
+int net_reactor_add(NetReactor *reactor, net_socket_t sock, unsigned int interest, void *userdata)
+{
+    if (!reactor)
+        return -1;
+    if (reactor->uring)
+        return net_uring_watch(reactor->uring, sock, interest, userdata);
+    return net_reactor_native_add(&reactor->native, sock, interest, userdata);
+}
+
+int net_reactor_modify(NetReactor *reactor, net_socket_t sock, unsigned int interest, void *userdata)
+{
+    if (!reactor)
+        return -1;
+    if (reactor->uring)
+        return net_uring_watch(reactor->uring, sock, interest, userdata);
+    return net_reactor_native_modify(&reactor->native, sock, interest, userdata);
+}
+
+int net_reactor_remove(NetReactor *reactor, net_socket_t sock)
+{
+    if (!reactor)
+        return -1;
+    if (reactor->uring)
+        return net_uring_remove(reactor->uring, sock);
+    return net_reactor_native_remove(&reactor->native, sock);
+}
+
+int net_reactor_accept(NetReactor *reactor, net_socket_t listen_sock, void *userdata)
+{
+    if (!reactor || !reactor->uring)
+        return -1;
+    return net_uring_accept(reactor->uring, listen_sock, userdata);
+}
+
+int net_reactor_recv(NetReactor *reactor, net_socket_t sock, void *userdata)
+{
+    if (!reactor || !reactor->uring)
+        return -1;
+    return net_uring_recv(reactor->uring, sock, userdata);
+}
+
+int net_reactor_wait(NetReactor *reactor, NetReactorEvent *events, int max_events, int timeout_ms)
+{
+    if (!reactor || !events || max_events <= 0)
+        return -1;
+    if (reactor->uring)
+        return net_uring_wait(reactor->uring, events, max_events, timeout_ms);
+    return net_reactor_native_wait(&reactor->native, events, max_events, timeout_ms);
+}
+
+void net_reactor_wake(NetReactor *reactor)
+{
+    if (!reactor)
+        return;
+    if (reactor->uring)
+        net_uring_wake(reactor->uring);
+    else
+        net_reactor_native_wake(&reactor->native);
+}
+
+const char *net_reactor_backend(const NetReactor *reactor)
+{
+    return reactor && reactor->uring ? "io_uring" : NET_REACTOR_NATIVE_NAME;
+}
+
+int net_reactor_backend_from_name(const char *name, NetReactorBackend *out_backend)
+{
+    if (!name || !out_backend)
+        return -1;
+    if (strcmp(name, "default") == 0 || strcmp(name, "epoll") == 0 || strcmp(name, "poll") == 0)
+    {
+        *out_backend = NET_REACTOR_BACKEND_DEFAULT;
+        return 0;
+    }
+    if (strcmp(name, "uring") == 0 || strcmp(name, "io_uring") == 0)
+    {
+        *out_backend = NET_REACTOR_BACKEND_URING;
+        return 0;
+    }
+    return -1;
+}
@@ -0,0 +1,148 @@
+#include "../../include/networking/net_snapshot.h"
+#include <string.h>
+
+/**
+ * Compare two PlayerState values field by field.
+ * Returns the SNAPSHOT_SELF_* bits for every field that differs.
+ */
+unsigned int net_snapshot_diff_self(const PlayerState *base, const PlayerState *next)
+{
+    unsigned int mask = 0;
+    if (base->player_id != next->player_id)
+        mask |= SNAPSHOT_SELF_ID;
+    if (strncmp(base->name, next->name, MAX_NAME_LEN) != 0)
+        mask |= SNAPSHOT_SELF_NAME;
+    if (base->is_active != next->is_active || base->is_connected != next->is_connected ||
+        base->has_crossed_threshold != next->has_crossed_threshold)
+        mask |= SNAPSHOT_SELF_FLAGS;
+    if (base->stars != next->stars)
+        mask |= SNAPSHOT_SELF_STARS;
+    if (base->planet.level != next->planet.level)
+        mask |= SNAPSHOT_SELF_PLANET_LEVEL;
+    if (base->planet.max_health != next->planet.max_health)
+        mask |= SNAPSHOT_SELF_PLANET_MAX_HEALTH;
+    if (base->planet.current_health != next->planet.current_health)
+        mask |= SNAPSHOT_SELF_PLANET_HEALTH;
+    if (base->planet.base_income != next->planet.base_income)
+        mask |= SNAPSHOT_SELF_PLANET_INCOME;
+    if (base->ship.level != next->ship.level)
+        mask |= SNAPSHOT_SELF_SHIP_LEVEL;
+    if (base->ship.base_damage != next->ship.base_damage)
+        mask |= SNAPSHOT_SELF_SHIP_DAMAGE;
+    return mask;
+}
+
+/**
+ * Compare two PlayerPublicInfo values field by field.
+ * Returns the SNAPSHOT_ENTRY_* bits for every field that differs.
+ */
+unsigned int net_snapshot_diff_entry(const PlayerPublicInfo *base, const PlayerPublicInfo *next)
+{
+    unsigned int mask = 0;
+    if (base->player_id != next->player_id)
+        mask |= SNAPSHOT_ENTRY_ID;
+    if (base->is_active != next->is_active || base->show_stars != next->show_stars)
+        mask |= SNAPSHOT_ENTRY_FLAGS;
+    if (strncmp(base->name, next->name, MAX_NAME_LEN) != 0)
+        mask |= SNAPSHOT_ENTRY_NAME;
+    if (base->coarse_planet_health != next->coarse_planet_health)
+        mask |= SNAPSHOT_ENTRY_HEALTH;
+    if (base->ship_level != next->ship_level)
+        mask |= SNAPSHOT_ENTRY_SHIP_LEVEL;
+    if (base->planet_level != next->planet_level)
+        mask |= SNAPSHOT_ENTRY_PLANET_LEVEL;
+    if (base->ship_base_damage != next->ship_base_damage)
+        mask |= SNAPSHOT_ENTRY_SHIP_DAMAGE;
+    return mask;
+}
+
+/**
+ * Describe the public entries in next relative to base.
+ * Without a base every field is marked present (keyframe).
+ */
+void net_snapshot_make_public_delta(const PlayerPublicInfo *base, const PlayerPublicInfo *next, EventPayload_TurnInfo *turn)
+{
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        turn->entries[i] = next[i];
+        turn->entry_masks[i] = base ? net_snapshot_diff_entry(&base[i], &next[i]) : SNAPSHOT_ENTRY_ALL;
+    }
+}
+
+/**
+ * Describe a viewer's own PlayerState relative to base.
+ * Without a base every field is marked present (keyframe).
+ */
+void net_snapshot_make_private_delta(const PlayerState *base, const PlayerState *next, EventPayload_TurnPrivate *update)
+{
+    update->self = *next;
+    update->self_mask = base ? net_snapshot_diff_self(base, next) : SNAPSHOT_SELF_ALL;
+}
+
+static void net_snapshot_apply_self(PlayerState *dst, const PlayerState *src, unsigned int mask)
+{
+    if (mask & SNAPSHOT_SELF_ID)
+        dst->player_id = src->player_id;
+    if (mask & SNAPSHOT_SELF_NAME)
+        memcpy(dst->name, src->name, MAX_NAME_LEN);
+    if (mask & SNAPSHOT_SELF_FLAGS)
+    {
+        dst->is_active = src->is_active;
+        dst->is_connected = src->is_connected;
+        dst->has_crossed_threshold = src->has_crossed_threshold;
+    }
+    if (mask & SNAPSHOT_SELF_STARS)
+        dst->stars = src->stars;
+    if (mask & SNAPSHOT_SELF_PLANET_LEVEL)
+        dst->planet.level = src->planet.level;
+    if (mask & SNAPSHOT_SELF_PLANET_MAX_HEALTH)
+        dst->planet.max_health = src->planet.max_health;
+    if (mask & SNAPSHOT_SELF_PLANET_HEALTH)
+        dst->planet.current_health = src->planet.current_health;
+    if (mask & SNAPSHOT_SELF_PLANET_INCOME)
+        dst->planet.base_income = src->planet.base_income;
+    if (mask & SNAPSHOT_SELF_SHIP_LEVEL)
+        dst->ship.level = src->ship.level;
+    if (mask & SNAPSHOT_SELF_SHIP_DAMAGE)
+        dst->ship.base_damage = src->ship.base_damage;
+}
+
+static void net_snapshot_apply_entry(PlayerPublicInfo *dst, const PlayerPublicInfo *src, unsigned int mask)
+{
+    if (mask & SNAPSHOT_ENTRY_ID)
+        dst->player_id = src->player_id;
+    if (mask & SNAPSHOT_ENTRY_FLAGS)
+    {
+        dst->is_active = src->is_active;
+        dst->show_stars = src->show_stars;
+    }
+    if (mask & SNAPSHOT_ENTRY_NAME)
+        memcpy(dst->name, src->name, MAX_NAME_LEN);
+    if (mask & SNAPSHOT_ENTRY_HEALTH)
+        dst->coarse_planet_health = src->coarse_planet_health;
+    if (mask & SNAPSHOT_ENTRY_SHIP_LEVEL)
+        dst->ship_level = src->ship_level;
+    if (mask & SNAPSHOT_ENTRY_PLANET_LEVEL)
+        dst->planet_level = src->planet_level;
+    if (mask & SNAPSHOT_ENTRY_SHIP_DAMAGE)
+        dst->ship_base_damage = src->ship_base_damage;
+}
+
+/**
+ * Patch the public entries with the fields carried by a turn event.
+ */
+void net_snapshot_apply_public(PlayerPublicInfo *entries, const EventPayload_TurnInfo *turn)
+{
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        net_snapshot_apply_entry(&entries[i], &turn->entries[i], turn->entry_masks[i]);
+    }
+}
+
+/**
+ * Patch the viewer's own state with the fields carried by a private update.
+ */
+void net_snapshot_apply_private(PlayerState *self, const EventPayload_TurnPrivate *update)
+{
+    net_snapshot_apply_self(self, &update->self, update->self_mask);
+}
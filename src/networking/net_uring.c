@@ -0,0 +1,669 @@
+#include "../../include/networking/net_uring.h"
+#include "../../include/networking/network.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+#ifndef POLLRDHUP
+#define POLLRDHUP 0x2000 // Linux value; <poll.h> only exposes it with _GNU_SOURCE
+#endif
+
+// Submission queue size; completions get twice as many slots
+#define NET_URING_ENTRIES 256
+// Registered receive buffers shared by every multishot recv (power of two)
+#define NET_URING_BUFFER_COUNT 256
+#define NET_URING_BUFFER_SIZE 2048
+#define NET_URING_BUFFER_GROUP 0
+
+typedef enum
+{
+    NET_URING_OP_WAKE = 1,
+    NET_URING_OP_POLL,
+    NET_URING_OP_ACCEPT,
+    NET_URING_OP_RECV,
+} NetUringOpKind;
+
+// One long-lived request; its address is the SQE user_data
+typedef struct NetUringOp
+{
+    struct NetUringOp *next;
+    NetUringOpKind kind;
+    net_socket_t sock;
+    void *userdata;
+    unsigned int poll_mask; // POLL ops only
+    int armed;              // The kernel still holds the request
+    int removed;            // Owner lost interest; freed once disarmed
+    int rearm;              // Multishot request ended early; resubmit on the next wait
+} NetUringOp;
+
+struct NetUring
+{
+    int ring_fd;
+    net_mutex_t mutex; // Guards the submission queue, ops and the buffer ring
+
+    void *ring_mem;
+    size_t ring_size;
+    unsigned int *sq_head;
+    unsigned int *sq_tail;
+    unsigned int sq_mask;
+    unsigned int sq_entries;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned int unsubmitted;
+
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int cq_mask;
+    struct io_uring_cqe *cqes;
+
+    struct io_uring_buf_ring *buf_ring;
+    size_t buf_ring_size;
+    unsigned char *buffers;
+    unsigned short buf_tail;
+    // Buffers handed out by the last wait; given back to the kernel on the next one
+    unsigned short lent[NET_URING_BUFFER_COUNT];
+    unsigned int lent_count;
+
+    int wake_fd;
+    NetUringOp *ops;
+};
+
+static int net_uring_enter(NetUring *uring, unsigned int to_submit, unsigned int min_complete, unsigned int flags, void *arg, size_t argsz)
+{
+    int result = (int)syscall(__NR_io_uring_enter, uring->ring_fd, to_submit, min_complete, flags, arg, argsz);
+    return result < 0 ? -errno : result;
+}
+
+// Hand queued SQEs to the kernel (mutex held)
+static int net_uring_submit_locked(NetUring *uring)
+{
+    if (uring->unsubmitted == 0)
+        return 0;
+    net_io_count(NET_IO_CONTROL);
+    int result;
+    do
+    {
+        result = net_uring_enter(uring, uring->unsubmitted, 0, 0, NULL, 0);
+    } while (result == -EINTR);
+    if (result < 0)
+        return -1;
+    uring->unsubmitted = 0;
+    return 0;
+}
+
+// Next free SQE, already cleared (mutex held)
+static struct io_uring_sqe *net_uring_get_sqe_locked(NetUring *uring)
+{
+    unsigned int tail = *uring->sq_tail;
+    if (tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) >= uring->sq_entries)
+    {
+        if (net_uring_submit_locked(uring) != 0)
+            return NULL;
+        if (tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) >= uring->sq_entries)
+            return NULL;
+    }
+    struct io_uring_sqe *sqe = &uring->sqes[tail & uring->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+static void net_uring_commit_sqe_locked(NetUring *uring)
+{
+    __atomic_store_n(uring->sq_tail, *uring->sq_tail + 1, __ATOMIC_RELEASE);
+    uring->unsubmitted++;
+}
+
+// Queue the request described by op (mutex held)
+static int net_uring_arm_locked(NetUring *uring, NetUringOp *op)
+{
+    struct io_uring_sqe *sqe = net_uring_get_sqe_locked(uring);
+    if (!sqe)
+        return -1;
+
+    sqe->fd = op->kind == NET_URING_OP_WAKE ? uring->wake_fd : op->sock;
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+    switch (op->kind)
+    {
+    case NET_URING_OP_WAKE:
+    case NET_URING_OP_POLL:
+    {
+        uint32_t mask = op->kind == NET_URING_OP_WAKE ? POLLIN : op->poll_mask;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        mask = (mask << 16) | (mask >> 16);
+#endif
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->len = IORING_POLL_ADD_MULTI;
+        sqe->poll32_events = mask;
+        break;
+    }
+    case NET_URING_OP_ACCEPT:
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+        break;
+    case NET_URING_OP_RECV:
+        sqe->opcode = IORING_OP_RECV;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = NET_URING_BUFFER_GROUP;
+        break;
+    }
+    net_uring_commit_sqe_locked(uring);
+    op->armed = 1;
+    op->rearm = 0;
+    return 0;
+}
+
+static void net_uring_cancel_locked(NetUring *uring, NetUringOp *op)
+{
+    struct io_uring_sqe *sqe = net_uring_get_sqe_locked(uring);
+    if (!sqe)
+        return;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = (uint64_t)(uintptr_t)op;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->user_data = 0;
+    net_uring_commit_sqe_locked(uring);
+}
+
+static void net_uring_free_op_locked(NetUring *uring, NetUringOp *op)
+{
+    for (NetUringOp **link = &uring->ops; *link; link = &(*link)->next)
+    {
+        if (*link == op)
+        {
+            *link = op->next;
+            break;
+        }
+    }
+    free(op);
+}
+
+// Stop reporting events for op; it is freed when the kernel lets go of it
+static void net_uring_retire_locked(NetUring *uring, NetUringOp *op)
+{
+    op->removed = 1;
+    if (op->armed)
+        net_uring_cancel_locked(uring, op);
+    else
+        net_uring_free_op_locked(uring, op);
+}
+
+static NetUringOp *net_uring_new_op_locked(NetUring *uring, NetUringOpKind kind, net_socket_t sock, void *userdata)
+{
+    NetUringOp *op = (NetUringOp *)calloc(1, sizeof(NetUringOp));
+    if (!op)
+        return NULL;
+    op->kind = kind;
+    op->sock = sock;
+    op->userdata = userdata;
+    op->next = uring->ops;
+    uring->ops = op;
+    return op;
+}
+
+static NetUringOp *net_uring_find_locked(NetUring *uring, net_socket_t sock, NetUringOpKind kind)
+{
+    for (NetUringOp *op = uring->ops; op; op = op->next)
+    {
+        if (!op->removed && op->sock == sock && op->kind == kind)
+            return op;
+    }
+    return NULL;
+}
+
+// Kernels before 6.0 lack multishot recv, and no feature bit announces it
+static int net_uring_kernel_supported(void)
+{
+    struct utsname name;
+    int major = 0;
+    if (uname(&name) != 0 || sscanf(name.release, "%d", &major) != 1)
+        return 0;
+    return major >= 6;
+}
+
+static void net_uring_provide_buffer_locked(NetUring *uring, unsigned short bid)
+{
+    struct io_uring_buf *buf = &uring->buf_ring->bufs[uring->buf_tail & (NET_URING_BUFFER_COUNT - 1)];
+    buf->addr = (uint64_t)(uintptr_t)(uring->buffers + (size_t)bid * NET_URING_BUFFER_SIZE);
+    buf->len = NET_URING_BUFFER_SIZE;
+    buf->bid = bid;
+    uring->buf_tail++;
+}
+
+static void net_uring_publish_buffers_locked(NetUring *uring)
+{
+    __atomic_store_n(&uring->buf_ring->tail, uring->buf_tail, __ATOMIC_RELEASE);
+}
+
+NetUring *net_uring_create(void)
+{
+    if (!net_uring_kernel_supported())
+        return NULL;
+
+    NetUring *uring = (NetUring *)calloc(1, sizeof(NetUring));
+    if (!uring)
+        return NULL;
+    uring->ring_fd = -1;
+    uring->wake_fd = -1;
+    net_mutex_init(&uring->mutex);
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    uring->ring_fd = (int)syscall(__NR_io_uring_setup, NET_URING_ENTRIES, &params);
+    unsigned int required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if (uring->ring_fd < 0 || (params.features & required) != required)
+        goto fail;
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    uring->ring_size = sq_size > cq_size ? sq_size : cq_size;
+    uring->ring_mem = mmap(NULL, uring->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->ring_fd, IORING_OFF_SQ_RING);
+    if (uring->ring_mem == MAP_FAILED)
+    {
+        uring->ring_mem = NULL;
+        goto fail;
+    }
+    uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    uring->sqes = (struct io_uring_sqe *)mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->ring_fd, IORING_OFF_SQES);
+    if (uring->sqes == MAP_FAILED)
+    {
+        uring->sqes = NULL;
+        goto fail;
+    }
+
+    unsigned char *ring = (unsigned char *)uring->ring_mem;
+    uring->sq_head = (unsigned int *)(ring + params.sq_off.head);
+    uring->sq_tail = (unsigned int *)(ring + params.sq_off.tail);
+    uring->sq_mask = *(unsigned int *)(ring + params.sq_off.ring_mask);
+    uring->sq_entries = params.sq_entries;
+    unsigned int *sq_array = (unsigned int *)(ring + params.sq_off.array);
+    for (unsigned int i = 0; i < params.sq_entries; ++i)
+        sq_array[i] = i;
+    uring->cq_head = (unsigned int *)(ring + params.cq_off.head);
+    uring->cq_tail = (unsigned int *)(ring + params.cq_off.tail);
+    uring->cq_mask = *(unsigned int *)(ring + params.cq_off.ring_mask);
+    uring->cqes = (struct io_uring_cqe *)(ring + params.cq_off.cqes);
+
+    // Registered buffer ring for multishot recv
+    uring->buf_ring_size = NET_URING_BUFFER_COUNT * sizeof(struct io_uring_buf);
+    uring->buf_ring = (struct io_uring_buf_ring *)mmap(NULL, uring->buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    uring->buffers = (unsigned char *)malloc((size_t)NET_URING_BUFFER_COUNT * NET_URING_BUFFER_SIZE);
+    if (uring->buf_ring == MAP_FAILED || !uring->buffers)
+    {
+        if (uring->buf_ring == MAP_FAILED)
+            uring->buf_ring = NULL;
+        goto fail;
+    }
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)uring->buf_ring;
+    reg.ring_entries = NET_URING_BUFFER_COUNT;
+    reg.bgid = NET_URING_BUFFER_GROUP;
+    if (syscall(__NR_io_uring_register, uring->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+        goto fail;
+    for (unsigned int bid = 0; bid < NET_URING_BUFFER_COUNT; ++bid)
+        net_uring_provide_buffer_locked(uring, (unsigned short)bid);
+    net_uring_publish_buffers_locked(uring);
+
+    uring->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (uring->wake_fd < 0)
+        goto fail;
+    net_mutex_lock(&uring->mutex);
+    NetUringOp *wake = net_uring_new_op_locked(uring, NET_URING_OP_WAKE, uring->wake_fd, NULL);
+    int armed = wake && net_uring_arm_locked(uring, wake) == 0 && net_uring_submit_locked(uring) == 0;
+    net_mutex_unlock(&uring->mutex);
+    if (!armed)
+        goto fail;
+    return uring;
+
+fail:
+    net_uring_destroy(uring);
+    return NULL;
+}
+
+void net_uring_destroy(NetUring *uring)
+{
+    if (!uring)
+        return;
+    // Closing the ring cancels whatever is still in flight
+    if (uring->ring_fd >= 0)
+        close(uring->ring_fd);
+    if (uring->wake_fd >= 0)
+        close(uring->wake_fd);
+    if (uring->sqes)
+        munmap(uring->sqes, uring->sqes_size);
+    if (uring->ring_mem)
+        munmap(uring->ring_mem, uring->ring_size);
+    if (uring->buf_ring)
+        munmap(uring->buf_ring, uring->buf_ring_size);
+    free(uring->buffers);
+    while (uring->ops)
+    {
+        NetUringOp *op = uring->ops;
+        uring->ops = op->next;
+        free(op);
+    }
+    net_mutex_destroy(&uring->mutex);
+    free(uring);
+}
+
+// poll(2) mask for a readiness watch. Reads already flow through a
+// completion request when the socket has one.
+static unsigned int net_uring_poll_mask_locked(NetUring *uring, net_socket_t sock, unsigned int interest)
+{
+    unsigned int mask = 0;
+    int completes_reads = net_uring_find_locked(uring, sock, NET_URING_OP_RECV) ||
+                          net_uring_find_locked(uring, sock, NET_URING_OP_ACCEPT);
+    if ((interest & NET_REACTOR_READ) && !completes_reads)
+        mask |= POLLIN | POLLRDHUP;
+    if (interest & NET_REACTOR_WRITE)
+        mask |= POLLOUT;
+    return mask;
+}
+
+int net_uring_watch(NetUring *uring, net_socket_t sock, unsigned int interest, void *userdata)
+{
+    if (!uring)
+        return -1;
+
+    int result = 0;
+    net_mutex_lock(&uring->mutex);
+    unsigned int mask = net_uring_poll_mask_locked(uring, sock, interest);
+    NetUringOp *current = net_uring_find_locked(uring, sock, NET_URING_OP_POLL);
+    if (current && current->poll_mask == mask)
+    {
+        current->userdata = userdata;
+    }
+    else
+    {
+        if (current)
+            net_uring_retire_locked(uring, current);
+        if (mask)
+        {
+            NetUringOp *op = net_uring_new_op_locked(uring, NET_URING_OP_POLL, sock, userdata);
+            if (op)
+                op->poll_mask = mask;
+            result = op ? net_uring_arm_locked(uring, op) : -1;
+        }
+        if (net_uring_submit_locked(uring) != 0)
+            result = -1;
+    }
+    net_mutex_unlock(&uring->mutex);
+    return result;
+}
+
+static int net_uring_start(NetUring *uring, NetUringOpKind kind, net_socket_t sock, void *userdata)
+{
+    if (!uring)
+        return -1;
+
+    net_mutex_lock(&uring->mutex);
+    NetUringOp *op = net_uring_new_op_locked(uring, kind, sock, userdata);
+    int result = op ? net_uring_arm_locked(uring, op) : -1;
+    if (result == 0)
+        result = net_uring_submit_locked(uring);
+    net_mutex_unlock(&uring->mutex);
+    return result;
+}
+
+int net_uring_accept(NetUring *uring, net_socket_t listen_sock, void *userdata)
+{
+    return net_uring_start(uring, NET_URING_OP_ACCEPT, listen_sock, userdata);
+}
+
+int net_uring_recv(NetUring *uring, net_socket_t sock, void *userdata)
+{
+    return net_uring_start(uring, NET_URING_OP_RECV, sock, userdata);
+}
+
+int net_uring_remove(NetUring *uring, net_socket_t sock)
+{
+    if (!uring)
+        return -1;
+
+    int found = 0;
+    net_mutex_lock(&uring->mutex);
+    NetUringOp *op = uring->ops;
+    while (op)
+    {
+        NetUringOp *next = op->next;
+        if (!op->removed && op->sock == sock && op->kind != NET_URING_OP_WAKE)
+        {
+            net_uring_retire_locked(uring, op);
+            found = 1;
+        }
+        op = next;
+    }
+    // Cancel now: the kernel keeps the socket open while a request references it
+    net_uring_submit_locked(uring);
+    net_mutex_unlock(&uring->mutex);
+    return found ? 0 : -1;
+}
+
+// Translate one completion into at most one event (mutex held).
+// Returns 1 if an event was stored.
+static int net_uring_complete_locked(NetUring *uring, const struct io_uring_cqe *cqe, NetReactorEvent *event)
+{
+    NetUringOp *op = (NetUringOp *)(uintptr_t)cqe->user_data;
+    if (!op)
+        return 0; // Failed cancel: the request had already finished
+
+    int more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+    int res = cqe->res;
+    const unsigned char *data = NULL;
+    if (cqe->flags & IORING_CQE_F_BUFFER)
+    {
+        unsigned short bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        data = uring->buffers + (size_t)bid * NET_URING_BUFFER_SIZE;
+        uring->lent[uring->lent_count++] = bid;
+    }
+    if (!more)
+        op->armed = 0;
+
+    if (op->removed)
+    {
+        if (!op->armed)
+            net_uring_free_op_locked(uring, op);
+        return 0;
+    }
+
+    memset(event, 0, sizeof(*event));
+    event->userdata = op->userdata;
+    event->accepted = NET_INVALID_SOCKET;
+    int stored = 0;
+    int terminal = 0;
+
+    switch (op->kind)
+    {
+    case NET_URING_OP_WAKE:
+    {
+        uint64_t value;
+        net_io_count(NET_IO_READ);
+        while (read(uring->wake_fd, &value, sizeof(value)) > 0)
+        {
+        }
+        break;
+    }
+    case NET_URING_OP_POLL:
+        if (res >= 0)
+        {
+            if (res & POLLIN)
+                event->events |= NET_REACTOR_READ;
+            if (res & POLLOUT)
+                event->events |= NET_REACTOR_WRITE;
+            if (res & (POLLHUP | POLLERR | POLLRDHUP))
+                event->events |= NET_REACTOR_HANGUP;
+            stored = event->events != 0;
+        }
+        break;
+    case NET_URING_OP_ACCEPT:
+        if (res >= 0)
+        {
+            event->events = NET_REACTOR_ACCEPTED;
+            event->accepted = res;
+            stored = 1;
+        }
+        break;
+    case NET_URING_OP_RECV:
+        if (res > 0 && data)
+        {
+            event->events = NET_REACTOR_DATA;
+            event->data = data;
+            event->length = (size_t)res;
+            stored = 1;
+        }
+        else if (res != -ENOBUFS)
+        {
+            // EOF or a socket error; the owner removes the socket
+            event->events = NET_REACTOR_HANGUP;
+            stored = 1;
+            terminal = 1;
+        }
+        break;
+    }
+
+    if (!more && !terminal)
+        op->rearm = 1;
+    return stored;
+}
+
+int net_uring_wait(NetUring *uring, NetReactorEvent *events, int max_events, int timeout_ms)
+{
+    if (!uring || !events || max_events <= 0)
+        return -1;
+
+    net_mutex_lock(&uring->mutex);
+    // Data returned by the previous wait has been consumed by now
+    for (unsigned int i = 0; i < uring->lent_count; ++i)
+        net_uring_provide_buffer_locked(uring, uring->lent[i]);
+    if (uring->lent_count > 0)
+        net_uring_publish_buffers_locked(uring);
+    uring->lent_count = 0;
+    for (NetUringOp *op = uring->ops; op; op = op->next)
+    {
+        if (op->rearm && !op->removed)
+            net_uring_arm_locked(uring, op);
+    }
+    unsigned int to_submit = uring->unsubmitted;
+    uring->unsubmitted = 0;
+    net_mutex_unlock(&uring->mutex);
+
+    // Submitting and waiting share one system call; skip it entirely when
+    // completions are already queued and there is nothing to submit
+    int ready = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE) != *uring->cq_head;
+    if (to_submit > 0 || !ready)
+    {
+        struct __kernel_timespec ts;
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.sigmask_sz = _NSIG / 8;
+        if (timeout_ms >= 0)
+        {
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000LL;
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+        }
+        net_io_count(ready ? NET_IO_CONTROL : NET_IO_WAIT);
+        int result = net_uring_enter(uring, to_submit, ready ? 0 : 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+        if (result < 0 && result != -ETIME && result != -EINTR)
+        {
+            errno = -result;
+            return -1;
+        }
+    }
+
+    int stored = 0;
+    net_mutex_lock(&uring->mutex);
+    unsigned int head = *uring->cq_head;
+    unsigned int tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+    // Each completion yields at most one event, so stop before overflowing the caller's array
+    while (head != tail && stored < max_events)
+    {
+        const struct io_uring_cqe *cqe = &uring->cqes[head & uring->cq_mask];
+        stored += net_uring_complete_locked(uring, cqe, &events[stored]);
+        head++;
+    }
+    __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+    net_mutex_unlock(&uring->mutex);
+    return stored;
+}
+
+void net_uring_wake(NetUring *uring)
+{
+    if (!uring)
+        return;
+    uint64_t one = 1;
+    net_io_count(NET_IO_CONTROL);
+    ssize_t written = write(uring->wake_fd, &one, sizeof(one));
+    (void)written; // A full counter already guarantees a wake-up
+}
+
+#else // No io_uring outside Linux
+
+NetUring *net_uring_create(void)
+{
+    return NULL;
+}
+
+void net_uring_destroy(NetUring *uring)
+{
+    (void)uring;
+}
+
+int net_uring_watch(NetUring *uring, net_socket_t sock, unsigned int interest, void *userdata)
+{
+    (void)uring;
+    (void)sock;
+    (void)interest;
+    (void)userdata;
+    return -1;
+}
+
+int net_uring_accept(NetUring *uring, net_socket_t listen_sock, void *userdata)
+{
+    (void)uring;
+    (void)listen_sock;
+    (void)userdata;
+    return -1;
+}
+
+int net_uring_recv(NetUring *uring, net_socket_t sock, void *userdata)
+{
+    (void)uring;
+    (void)sock;
+    (void)userdata;
+    return -1;
+}
+
+int net_uring_remove(NetUring *uring, net_socket_t sock)
+{
+    (void)uring;
+    (void)sock;
+    return -1;
+}
+
+int net_uring_wait(NetUring *uring, NetReactorEvent *events, int max_events, int timeout_ms)
+{
+    (void)uring;
+    (void)events;
+    (void)max_events;
+    (void)timeout_ms;
+    return -1;
+}
+
+void net_uring_wake(NetUring *uring)
+{
+    (void)uring;
+}
+
+#endif
@@ -1,4 +1,9 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // sendmmsg()
+#endif
+
 #include "../../include/networking/network.h"
+#include "../../include/networking/net_codec.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,8 +12,20 @@
 #include <mstcpip.h>
 #else
 #include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <ifaddrs.h>
+#include <net/if.h>
 #endif
 
+// Encoded events gathered by net_send_events before they are written
+#define NET_SEND_BATCH_SIZE (8 * NET_FRAME_MAX_SIZE)
+// Pending Fast Open requests the listening socket accepts data from
+#define NET_FASTOPEN_QUEUE 16
+
+static int net_send_all(net_socket_t sock, const unsigned char *data, size_t len);
+
 #if defined(_WIN32)
 static int net_platform_initialized = 0;
 
@@ -64,6 +81,96 @@ static void net_get_time(struct timeval *tv)
 #endif
 }
 
+/**
+ * Monotonic clock in microseconds, for timeouts and round-trip samples.
+ */
+uint64_t net_monotonic_us(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000ULL +
+           (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000ULL / (uint64_t)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+#endif
+}
+
+void net_rtt_reset(NetRttStats *stats)
+{
+    if (stats)
+        memset(stats, 0, sizeof(*stats));
+}
+
+/**
+ * Fold one round-trip sample into the smoothed estimate.
+ * The first sample seeds srtt with itself and jitter with half of it.
+ */
+void net_rtt_sample(NetRttStats *stats, unsigned int rtt_us)
+{
+    if (!stats)
+        return;
+
+    stats->last_us = rtt_us;
+    if (stats->samples == 0)
+    {
+        stats->srtt_us = rtt_us;
+        stats->jitter_us = rtt_us / 2;
+    }
+    else
+    {
+        long long error = (long long)rtt_us - (long long)stats->srtt_us;
+        long long deviation = error < 0 ? -error : error;
+        stats->jitter_us = (unsigned int)((long long)stats->jitter_us + (deviation - (long long)stats->jitter_us) / 4);
+        stats->srtt_us = (unsigned int)((long long)stats->srtt_us + error / 8);
+    }
+    stats->samples++;
+}
+
+#define NET_TOKEN_SCALE 1000000ULL
+
+void net_token_bucket_reset(NetTokenBucket *bucket, const NetRateLimit *limit, uint64_t now_us)
+{
+    if (!bucket || !limit)
+        return;
+    bucket->tokens = (uint64_t)limit->burst * NET_TOKEN_SCALE;
+    bucket->updated_us = now_us;
+}
+
+/**
+ * Refill the bucket for the time since the last call, then spend one token.
+ * Tokens are kept in millionths so that rate_per_sec tokens accrue per second
+ * of elapsed microseconds without rounding away slow rates.
+ */
+int net_token_bucket_take(NetTokenBucket *bucket, const NetRateLimit *limit, uint64_t now_us)
+{
+    if (!bucket || !limit || limit->rate_per_sec == 0)
+        return 1;
+
+    uint64_t capacity = (uint64_t)(limit->burst > 0 ? limit->burst : 1) * NET_TOKEN_SCALE;
+    uint64_t elapsed_us = now_us > bucket->updated_us ? now_us - bucket->updated_us : 0;
+    bucket->updated_us = now_us;
+    // Checked before multiplying so a long-idle bucket cannot overflow
+    if (elapsed_us >= capacity / limit->rate_per_sec)
+        bucket->tokens = capacity;
+    else
+    {
+        bucket->tokens += elapsed_us * limit->rate_per_sec;
+        if (bucket->tokens > capacity)
+            bucket->tokens = capacity;
+    }
+
+    if (bucket->tokens < NET_TOKEN_SCALE)
+        return 0;
+    bucket->tokens -= NET_TOKEN_SCALE;
+    return 1;
+}
+
 void net_log_socket_error(const char *context)
 {
 #if defined(_WIN32)
@@ -74,11 +181,101 @@ void net_log_socket_error(const char *context)
 #endif
 }
 
+static volatile long net_io_counts[NET_IO_COUNTER_COUNT];
+
+/**
+ * Count one system call made by the networking layer.
+ */
+void net_io_count(NetIoCounter counter)
+{
+    if ((int)counter < 0 || counter >= NET_IO_COUNTER_COUNT)
+        return;
+#if defined(_MSC_VER)
+    InterlockedIncrement(&net_io_counts[counter]);
+#else
+    __atomic_fetch_add(&net_io_counts[counter], 1, __ATOMIC_RELAXED);
+#endif
+}
+
+/**
+ * Copy the system call counters accumulated since the last reset.
+ */
+void net_io_stats_get(NetIoStats *out_stats)
+{
+    if (!out_stats)
+        return;
+    for (int i = 0; i < NET_IO_COUNTER_COUNT; ++i)
+    {
+#if defined(_MSC_VER)
+        out_stats->counts[i] = (unsigned long)InterlockedCompareExchange(&net_io_counts[i], 0, 0);
+#else
+        out_stats->counts[i] = (unsigned long)__atomic_load_n(&net_io_counts[i], __ATOMIC_RELAXED);
+#endif
+    }
+}
+
+void net_io_stats_reset(void)
+{
+    for (int i = 0; i < NET_IO_COUNTER_COUNT; ++i)
+    {
+#if defined(_MSC_VER)
+        InterlockedExchange(&net_io_counts[i], 0);
+#else
+        __atomic_store_n(&net_io_counts[i], 0, __ATOMIC_RELAXED);
+#endif
+    }
+}
+
 /**
  * Create a TCP server socket bound to the given port.
  * Returns the socket file descriptor on success, -1 on failure.
  */
 net_socket_t net_create_server_socket(int port)
+{
+    return net_create_listen_socket(port, NET_LISTEN_BACKLOG, 0);
+}
+
+/**
+ * Create a nonblocking UDP socket bound to port on every address (0 picks any port).
+ * Returns NET_INVALID_SOCKET on failure.
+ */
+net_socket_t net_create_udp_socket(int port)
+{
+    if (net_ensure_platform_initialized() != 0)
+    {
+        return NET_INVALID_SOCKET;
+    }
+
+    net_socket_t sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock == NET_INVALID_SOCKET)
+    {
+        net_log_socket_error("socket");
+        return NET_INVALID_SOCKET;
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(sock, (struct sockaddr *)&address, sizeof(address)) == NET_SOCKET_ERROR)
+    {
+        net_log_socket_error("bind");
+        net_close_socket(sock);
+        return NET_INVALID_SOCKET;
+    }
+
+    net_set_nonblocking(sock);
+    return sock;
+}
+
+/**
+ * Create a TCP server socket bound to the given port with room for backlog
+ * pending connections. With reuse_port, every socket created the same way
+ * shares the port and the kernel spreads new connections over them.
+ * Returns -1 on failure, including when the platform cannot share ports.
+ */
+net_socket_t net_create_listen_socket(int port, int backlog, int reuse_port)
 {
     if (net_ensure_platform_initialized() != 0)
     {
@@ -100,6 +297,21 @@ net_socket_t net_create_server_socket(int port)
         return NET_INVALID_SOCKET;
     }
 
+    if (reuse_port)
+    {
+#if defined(SO_REUSEPORT) && !defined(_WIN32)
+        if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, (const char *)&opt, sizeof(opt)) == NET_SOCKET_ERROR)
+        {
+            net_log_socket_error("setsockopt(SO_REUSEPORT)");
+            net_close_socket(server_fd);
+            return NET_INVALID_SOCKET;
+        }
+#else
+        net_close_socket(server_fd);
+        return NET_INVALID_SOCKET;
+#endif
+    }
+
     struct sockaddr_in address;
     memset(&address, 0, sizeof(address));
     address.sin_family = AF_INET;
@@ -113,7 +325,15 @@ net_socket_t net_create_server_socket(int port)
         return NET_INVALID_SOCKET;
     }
 
-    if (listen(server_fd, 3) == NET_SOCKET_ERROR)
+#if defined(TCP_FASTOPEN)
+    // Let clients put their join request in the SYN (best effort: needs kernel support)
+    int fastopen_queue = NET_FASTOPEN_QUEUE;
+    setsockopt(server_fd, IPPROTO_TCP, TCP_FASTOPEN, (const char *)&fastopen_queue, sizeof(fastopen_queue));
+#endif
+
+    if (backlog <= 0)
+        backlog = NET_LISTEN_BACKLOG;
+    if (listen(server_fd, backlog) == NET_SOCKET_ERROR)
     {
         net_log_socket_error("listen");
         net_close_socket(server_fd);
@@ -123,275 +343,1466 @@ net_socket_t net_create_server_socket(int port)
     return server_fd;
 }
 
+// Resolved names are kept this long; getaddrinfo() does not report the DNS TTL
+#define NET_RESOLVE_CACHE_TTL_US (60ULL * 1000000ULL)
+#define NET_RESOLVE_CACHE_SIZE 8
+
+typedef struct
+{
+    char host[64];
+    struct sockaddr_storage addresses[NET_CONNECT_MAX_ADDRESSES]; // Port left at 0
+    socklen_t lengths[NET_CONNECT_MAX_ADDRESSES];
+    int count;
+    uint64_t expires_us;
+} NetResolveEntry;
+
+static NetResolveEntry net_resolve_cache[NET_RESOLVE_CACHE_SIZE];
+#if defined(_WIN32)
+static SRWLOCK net_resolve_lock = SRWLOCK_INIT;
+#define NET_RESOLVE_LOCK() AcquireSRWLockExclusive(&net_resolve_lock)
+#define NET_RESOLVE_UNLOCK() ReleaseSRWLockExclusive(&net_resolve_lock)
+#else
+static pthread_mutex_t net_resolve_lock = PTHREAD_MUTEX_INITIALIZER;
+#define NET_RESOLVE_LOCK() pthread_mutex_lock(&net_resolve_lock)
+#define NET_RESOLVE_UNLOCK() pthread_mutex_unlock(&net_resolve_lock)
+#endif
+
+static void net_set_address_port(struct sockaddr_storage *address, int port)
+{
+    if (address->ss_family == AF_INET6)
+        ((struct sockaddr_in6 *)address)->sin6_port = htons((unsigned short)port);
+    else
+        ((struct sockaddr_in *)address)->sin_port = htons((unsigned short)port);
+}
+
+// Answer from a literal address or the cache, never from the resolver. Returns 0 on a miss.
+static int net_resolve_known(const char *host, int port, struct sockaddr_storage *out_addresses, socklen_t *out_lengths,
+                             int max_addresses)
+{
+    struct sockaddr_in literal;
+    memset(&literal, 0, sizeof(literal));
+    literal.sin_family = AF_INET;
+    if (inet_pton(AF_INET, host, &literal.sin_addr) == 1)
+    {
+        memset(&out_addresses[0], 0, sizeof(out_addresses[0]));
+        memcpy(&out_addresses[0], &literal, sizeof(literal));
+        out_lengths[0] = (socklen_t)sizeof(literal);
+        net_set_address_port(&out_addresses[0], port);
+        return 1;
+    }
+
+    uint64_t now_us = net_monotonic_us();
+    int count = 0;
+    NET_RESOLVE_LOCK();
+    for (int i = 0; i < NET_RESOLVE_CACHE_SIZE; ++i)
+    {
+        NetResolveEntry *entry = &net_resolve_cache[i];
+        if (entry->count > 0 && now_us < entry->expires_us && strcmp(entry->host, host) == 0)
+        {
+            for (count = 0; count < entry->count && count < max_addresses; ++count)
+            {
+                out_addresses[count] = entry->addresses[count];
+                out_lengths[count] = entry->lengths[count];
+                net_set_address_port(&out_addresses[count], port);
+            }
+            break;
+        }
+    }
+    NET_RESOLVE_UNLOCK();
+    return count;
+}
+
 /**
- * Connect to a TCP server at the given host and port.
- * Returns the socket file descriptor on success, -1 on failure.
+ * Resolve a host name or literal address to TCP endpoints.
+ * Literal addresses never reach the resolver; names are cached, so reconnecting
+ * to the same host does not wait on DNS again.
  */
-net_socket_t net_connect_to_server(const char *host, int port)
+int net_resolve_host(const char *host, int port, struct sockaddr_storage *out_addresses, socklen_t *out_lengths,
+                     int max_addresses)
 {
+    if (!host || host[0] == '\0' || !out_addresses || !out_lengths || max_addresses <= 0)
+        return 0;
     if (net_ensure_platform_initialized() != 0)
+        return 0;
+
+    int count = net_resolve_known(host, port, out_addresses, out_lengths, max_addresses);
+    if (count > 0)
+        return count;
+
+    uint64_t now_us = net_monotonic_us();
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    struct addrinfo *results = NULL;
+    if (getaddrinfo(host, NULL, &hints, &results) != 0 || !results)
     {
-        return NET_INVALID_SOCKET;
+        fprintf(stderr, "Cannot resolve %s\n", host);
+        return 0;
     }
 
-    net_socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock == NET_INVALID_SOCKET)
+    NetResolveEntry fresh;
+    memset(&fresh, 0, sizeof(fresh));
+    strncpy(fresh.host, host, sizeof(fresh.host) - 1);
+    for (struct addrinfo *it = results; it && fresh.count < NET_CONNECT_MAX_ADDRESSES; it = it->ai_next)
     {
-        net_log_socket_error("socket");
+        if ((it->ai_family != AF_INET && it->ai_family != AF_INET6) || it->ai_addrlen > sizeof(struct sockaddr_storage))
+            continue;
+        memcpy(&fresh.addresses[fresh.count], it->ai_addr, it->ai_addrlen);
+        fresh.lengths[fresh.count] = (socklen_t)it->ai_addrlen;
+        fresh.count += 1;
+    }
+    freeaddrinfo(results);
+    if (fresh.count == 0)
+        return 0;
+    fresh.expires_us = now_us + NET_RESOLVE_CACHE_TTL_US;
+
+    // Names too long to key on are resolved every time
+    if (strlen(host) < sizeof(fresh.host))
+    {
+        NET_RESOLVE_LOCK();
+        int victim = 0;
+        for (int i = 0; i < NET_RESOLVE_CACHE_SIZE; ++i)
+        {
+            if (strcmp(net_resolve_cache[i].host, host) == 0 || net_resolve_cache[i].expires_us < net_resolve_cache[victim].expires_us)
+            {
+                victim = i;
+                if (strcmp(net_resolve_cache[i].host, host) == 0)
+                    break;
+            }
+        }
+        net_resolve_cache[victim] = fresh;
+        NET_RESOLVE_UNLOCK();
+    }
+
+    for (count = 0; count < fresh.count && count < max_addresses; ++count)
+    {
+        out_addresses[count] = fresh.addresses[count];
+        out_lengths[count] = fresh.lengths[count];
+        net_set_address_port(&out_addresses[count], port);
+    }
+    return count;
+}
+
+static int net_set_blocking(net_socket_t sock)
+{
+#if defined(_WIN32)
+    u_long mode = 0;
+    return ioctlsocket(sock, FIONBIO, &mode) == 0 ? 0 : -1;
+#else
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags < 0)
+        return -1;
+    return fcntl(sock, F_SETFL, flags & ~O_NONBLOCK) == 0 ? 0 : -1;
+#endif
+}
+
+static int net_connect_in_progress(int error)
+{
+#if defined(_WIN32)
+    return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+#else
+    return error == EINPROGRESS || error == EINTR;
+#endif
+}
+
+/**
+ * Start a nonblocking connect to address. With TCP Fast Open the early data rides
+ * in the SYN when the kernel holds a cookie for the server; otherwise, or when the
+ * platform lacks it, this is a plain connect and the data follows the handshake.
+ * Returns 0 while the connect is in flight (or already done), -1 on failure.
+ */
+static int net_connect_start_one(NetConnectAttempt *attempt, net_socket_t sock, const struct sockaddr_storage *address,
+                                 socklen_t length, int send_early)
+{
+#if defined(__linux__) && defined(MSG_FASTOPEN)
+    if (send_early && attempt->early_length > 0)
+    {
+        ssize_t sent = sendto(sock, (const char *)attempt->early_data, attempt->early_length, MSG_FASTOPEN | NET_MSG_NOSIGNAL,
+                              (const struct sockaddr *)address, length);
+        if (sent >= 0)
+        {
+            attempt->early_sent = (size_t)sent;
+            return 0;
+        }
+        if (net_connect_in_progress(NET_ERRNO()) || NET_ERRNO() == EALREADY)
+            return 0; // No cookie yet: the SYN asked for one and the data waits
+        if (NET_ERRNO() != EOPNOTSUPP && NET_ERRNO() != EPIPE)
+            return -1;
+        // Fast Open disabled on this host: fall through to a plain connect
+    }
+#else
+    (void)send_early;
+    (void)attempt;
+#endif
+    if (connect(sock, (const struct sockaddr *)address, length) == 0)
+        return 0;
+    return net_connect_in_progress(NET_ERRNO()) ? 0 : -1;
+}
+
+/*
+ * A name lookup for one connect attempt, run on a thread of its own so the
+ * caller never waits on DNS. The attempt and the thread each hold a reference;
+ * whichever lets go last frees the job, so a cancelled attempt does not wait
+ * for getaddrinfo to return.
+ */
+struct NetResolveJob
+{
+    net_mutex_t mutex;
+    net_cond_t done_cond;
+    int references;
+    int done;
+    char host[256];
+    int port;
+    struct sockaddr_storage addresses[NET_CONNECT_MAX_ADDRESSES];
+    socklen_t lengths[NET_CONNECT_MAX_ADDRESSES];
+    int count;
+};
+
+static void net_resolve_job_release(NetResolveJob *job)
+{
+    net_mutex_lock(&job->mutex);
+    int last = --job->references == 0;
+    net_mutex_unlock(&job->mutex);
+    if (!last)
+        return;
+    net_cond_destroy(&job->done_cond);
+    net_mutex_destroy(&job->mutex);
+    free(job);
+}
+
+static void *net_resolve_thread(void *arg)
+{
+    NetResolveJob *job = (NetResolveJob *)arg;
+    struct sockaddr_storage addresses[NET_CONNECT_MAX_ADDRESSES];
+    socklen_t lengths[NET_CONNECT_MAX_ADDRESSES];
+    int count = net_resolve_host(job->host, job->port, addresses, lengths, NET_CONNECT_MAX_ADDRESSES);
+
+    net_mutex_lock(&job->mutex);
+    for (int i = 0; i < count; ++i)
+    {
+        job->addresses[i] = addresses[i];
+        job->lengths[i] = lengths[i];
+    }
+    job->count = count;
+    job->done = 1;
+    net_cond_broadcast(&job->done_cond);
+    net_mutex_unlock(&job->mutex);
+    net_resolve_job_release(job);
+    return NULL;
+}
+
+// Look host up on a detached thread. Returns 0 once it is running, -1 otherwise.
+static int net_connect_start_lookup(NetConnectAttempt *attempt, const char *host, int port)
+{
+    NetResolveJob *job = (NetResolveJob *)calloc(1, sizeof(NetResolveJob));
+    if (!job)
+        return -1;
+    if (strlen(host) >= sizeof(job->host) || net_mutex_init(&job->mutex) != 0)
+    {
+        free(job);
+        return -1;
+    }
+    if (net_cond_init(&job->done_cond) != 0)
+    {
+        net_mutex_destroy(&job->mutex);
+        free(job);
+        return -1;
+    }
+    strcpy(job->host, host);
+    job->port = port;
+    job->references = 2;
+
+    net_thread_t thread;
+    if (net_thread_create(&thread, net_resolve_thread, job) != 0)
+    {
+        job->references = 1;
+        net_resolve_job_release(job);
+        return -1;
+    }
+    net_thread_detach(thread);
+    attempt->resolving = job;
+    return 0;
+}
+
+// Start a nonblocking connect to each address. Returns 0 if one is in flight, -1 otherwise.
+static int net_connect_start_all(NetConnectAttempt *attempt, const struct sockaddr_storage *addresses,
+                                 const socklen_t *lengths, int count)
+{
+    // Early data may only leave once, so it rides in the SYN only when a single
+    // connection can win; with several candidates it follows the handshake
+    int send_early = (count == 1);
+    for (int i = 0; i < count; ++i)
+    {
+        net_socket_t sock = socket(addresses[i].ss_family, SOCK_STREAM, 0);
+        if (sock == NET_INVALID_SOCKET)
+            continue;
+        if (net_set_nonblocking(sock) != 0 || net_connect_start_one(attempt, sock, &addresses[i], lengths[i], send_early) != 0)
+        {
+            net_close_socket(sock);
+            continue;
+        }
+        attempt->sockets[attempt->socket_count++] = sock;
+    }
+    if (attempt->socket_count == 0)
+    {
+        net_log_socket_error("connect");
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Check on a name lookup in flight, waiting up to wait_ms for it, and start
+ * connecting to its addresses once it is done.
+ * Returns 1 once the connects are in flight, 0 while still looking up, -1 on failure.
+ */
+static int net_connect_finish_lookup(NetConnectAttempt *attempt, int wait_ms)
+{
+    NetResolveJob *job = attempt->resolving;
+    net_mutex_lock(&job->mutex);
+    if (!job->done && wait_ms > 0)
+        net_cond_timedwait(&job->done_cond, &job->mutex, wait_ms);
+    int done = job->done;
+    net_mutex_unlock(&job->mutex);
+    if (!done)
+        return 0;
+
+    // The thread is finished with the results once done is set
+    attempt->resolving = NULL;
+    int count = job->count;
+    int started = -1;
+    if (count == 0)
+        fprintf(stderr, "Invalid address: %s\n", job->host);
+    else
+        started = net_connect_start_all(attempt, job->addresses, job->lengths, count);
+    net_resolve_job_release(job);
+    return started == 0 ? 1 : -1;
+}
+
+/**
+ * Start connecting to host. Literal addresses and cached names connect at
+ * once; any other name is looked up on its own thread first, and
+ * net_connect_poll starts the connects once it resolves, so this never blocks
+ * on DNS. The timeout covers the lookup as well.
+ */
+int net_connect_begin(NetConnectAttempt *attempt, const char *host, int port, int timeout_ms,
+                      const void *early_data, size_t early_length)
+{
+    if (!attempt)
+        return -1;
+    memset(attempt, 0, sizeof(*attempt));
+    for (int i = 0; i < NET_CONNECT_MAX_ADDRESSES; ++i)
+        attempt->sockets[i] = NET_INVALID_SOCKET;
+    if (early_length > sizeof(attempt->early_data))
+        return -1;
+    if (early_data && early_length > 0)
+    {
+        memcpy(attempt->early_data, early_data, early_length);
+        attempt->early_length = early_length;
+    }
+    if (!host || host[0] == '\0' || net_ensure_platform_initialized() != 0)
+    {
+        fprintf(stderr, "Invalid address: %s\n", host ? host : "(null)");
+        return -1;
+    }
+    attempt->deadline_us = net_monotonic_us() + (uint64_t)(timeout_ms > 0 ? timeout_ms : NET_CONNECT_TIMEOUT_MS) * 1000ULL;
+
+    struct sockaddr_storage addresses[NET_CONNECT_MAX_ADDRESSES];
+    socklen_t lengths[NET_CONNECT_MAX_ADDRESSES];
+    int count = net_resolve_known(host, port, addresses, lengths, NET_CONNECT_MAX_ADDRESSES);
+    if (count > 0)
+        return net_connect_start_all(attempt, addresses, lengths, count);
+    return net_connect_start_lookup(attempt, host, port);
+}
+
+/**
+ * Close every attempt still in flight and abandon a lookup still running.
+ */
+void net_connect_cancel(NetConnectAttempt *attempt)
+{
+    if (!attempt)
+        return;
+    for (int i = 0; i < attempt->socket_count; ++i)
+    {
+        net_close_socket(attempt->sockets[i]);
+        attempt->sockets[i] = NET_INVALID_SOCKET;
+    }
+    attempt->socket_count = 0;
+    if (attempt->resolving)
+    {
+        net_resolve_job_release(attempt->resolving);
+        attempt->resolving = NULL;
+    }
+}
+
+/**
+ * Check the attempts in flight, waiting up to wait_ms for one to finish.
+ */
+int net_connect_poll(NetConnectAttempt *attempt, int wait_ms, net_socket_t *out_sock)
+{
+    if (!attempt || !out_sock)
+        return -1;
+
+    uint64_t now_us = net_monotonic_us();
+    if (now_us >= attempt->deadline_us)
+    {
+        net_connect_cancel(attempt);
+        return -1;
+    }
+    uint64_t left_ms = (attempt->deadline_us - now_us + 999ULL) / 1000ULL;
+    if (wait_ms < 0 || (uint64_t)wait_ms > left_ms)
+        wait_ms = (int)left_ms;
+
+    if (attempt->resolving)
+    {
+        int lookup = net_connect_finish_lookup(attempt, wait_ms);
+        if (lookup <= 0)
+        {
+            if (lookup < 0)
+                net_connect_cancel(attempt);
+            return lookup;
+        }
+        wait_ms = 0; // The wait went to the lookup; just check the fresh connects
+    }
+
+    fd_set writefds;
+    fd_set exceptfds;
+    FD_ZERO(&writefds);
+    FD_ZERO(&exceptfds);
+    net_socket_t max_sock = 0;
+    int pending = 0;
+    for (int i = 0; i < attempt->socket_count; ++i)
+    {
+        net_socket_t sock = attempt->sockets[i];
+        if (sock == NET_INVALID_SOCKET)
+            continue;
+        FD_SET(sock, &writefds);
+        FD_SET(sock, &exceptfds); // Winsock reports a failed connect here
+        if (sock > max_sock)
+            max_sock = sock;
+        pending += 1;
+    }
+    if (pending == 0)
+    {
+        net_connect_cancel(attempt);
+        return -1;
+    }
+
+    struct timeval wait;
+    wait.tv_sec = wait_ms / 1000;
+    wait.tv_usec = (wait_ms % 1000) * 1000;
+#if defined(_WIN32)
+    int ready = select(0, NULL, &writefds, &exceptfds, &wait);
+#else
+    int ready = select((int)(max_sock + 1), NULL, &writefds, &exceptfds, &wait);
+#endif
+    if (ready <= 0)
+        return 0;
+
+    for (int i = 0; i < attempt->socket_count; ++i)
+    {
+        net_socket_t sock = attempt->sockets[i];
+        if (sock == NET_INVALID_SOCKET || (!FD_ISSET(sock, &writefds) && !FD_ISSET(sock, &exceptfds)))
+            continue;
+
+        int error = 0;
+        socklen_t error_length = (socklen_t)sizeof(error);
+        if (getsockopt(sock, SOL_SOCKET, SO_ERROR, (char *)&error, &error_length) != 0 || error != 0 ||
+            FD_ISSET(sock, &exceptfds))
+        {
+            net_close_socket(sock);
+            attempt->sockets[i] = NET_INVALID_SOCKET;
+            continue;
+        }
+
+        // Winner: the others are no longer needed
+        attempt->sockets[i] = NET_INVALID_SOCKET;
+        net_connect_cancel(attempt);
+
+        net_set_blocking(sock);
+        // Enable TCP_NODELAY to reduce latency (disable Nagle's algorithm)
+        int nodelay = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay, sizeof(nodelay));
+        if (attempt->early_sent < attempt->early_length &&
+            !net_send_all(sock, attempt->early_data + attempt->early_sent, attempt->early_length - attempt->early_sent))
+        {
+            net_close_socket(sock);
+            return -1;
+        }
+        attempt->early_sent = attempt->early_length;
+        *out_sock = sock;
+        return 1;
+    }
+
+    for (int i = 0; i < attempt->socket_count; ++i)
+    {
+        if (attempt->sockets[i] != NET_INVALID_SOCKET)
+            return 0;
+    }
+    net_connect_cancel(attempt);
+    return -1;
+}
+
+/**
+ * Connect to a TCP server at the given host and port, blocking for at most
+ * NET_CONNECT_TIMEOUT_MS. Returns the connected socket, or NET_INVALID_SOCKET.
+ */
+net_socket_t net_connect_to_server(const char *host, int port)
+{
+    NetConnectAttempt attempt;
+    if (net_connect_begin(&attempt, host, port, NET_CONNECT_TIMEOUT_MS, NULL, 0) != 0)
+        return NET_INVALID_SOCKET;
+
+    net_socket_t sock = NET_INVALID_SOCKET;
+    int result;
+    while ((result = net_connect_poll(&attempt, NET_CONNECT_TIMEOUT_MS, &sock)) == 0)
+    {
+    }
+    if (result < 0)
+    {
+        fprintf(stderr, "connect to %s:%d failed or timed out\n", host ? host : "(null)", port);
         return NET_INVALID_SOCKET;
     }
+    return sock;
+}
 
-    struct sockaddr_in serv_addr;
-    memset(&serv_addr, 0, sizeof(serv_addr));
-    serv_addr.sin_family = AF_INET;
-    serv_addr.sin_port = htons(port);
+/**
+ * Close a socket if valid.
+ */
+void net_close_socket(net_socket_t sock)
+{
+    if (sock != NET_INVALID_SOCKET)
+    {
+        NET_CLOSE_SOCKET(sock);
+    }
+}
+
+/**
+ * Put a socket into nonblocking mode.
+ * Returns 0 on success, -1 on failure.
+ */
+int net_set_nonblocking(net_socket_t sock)
+{
+#if defined(_WIN32)
+    u_long mode = 1;
+    return ioctlsocket(sock, FIONBIO, &mode) == 0 ? 0 : -1;
+#else
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags < 0)
+        return -1;
+    return fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0 ? 0 : -1;
+#endif
+}
+
+/**
+ * Accept one pending connection as a nonblocking, close-on-exec socket.
+ * Returns NET_INVALID_SOCKET when none is pending or on error (see NET_ERRNO()).
+ */
+net_socket_t net_accept_nonblocking(net_socket_t listen_sock)
+{
+#if defined(__linux__)
+    // accept4 saves the two fcntl calls per connection
+    return accept4(listen_sock, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+    net_socket_t sock = accept(listen_sock, NULL, NULL);
+    if (sock != NET_INVALID_SOCKET)
+    {
+        net_set_nonblocking(sock);
+#if !defined(_WIN32)
+        fcntl(sock, F_SETFD, FD_CLOEXEC);
+#endif
+    }
+    return sock;
+#endif
+}
+
+/**
+ * Send len bytes, retrying on short writes and interrupts.
+ * Returns 1 on success, 0 on failure.
+ */
+static int net_send_all(net_socket_t sock, const unsigned char *data, size_t len)
+{
+    size_t offset = 0;
+    while (offset < len)
+    {
+        net_io_count(NET_IO_WRITE);
+        ssize_t sent = send(sock, (const char *)data + offset, (int)(len - offset), NET_MSG_NOSIGNAL);
+        if (sent == NET_SOCKET_ERROR)
+        {
+            if (NET_ERRNO() == NET_EINTR)
+                continue;
+            net_log_socket_error("send");
+            return 0;
+        }
+        if (sent == 0)
+            return 0;
+        offset += (size_t)sent;
+    }
+    return 1;
+}
+
+/**
+ * Send a frame that was already encoded with net_encode_event.
+ * Lets callers encode a broadcast once and reuse it for every receiver.
+ * Returns 1 on success, 0 on failure.
+ */
+int net_send_frame(net_socket_t sock, const unsigned char *frame, size_t len)
+{
+    if (sock == NET_INVALID_SOCKET || !frame || len == 0)
+        return 0;
+    return net_send_all(sock, frame, len);
+}
+
+/**
+ * Encode events into one buffer and write it with a single send().
+ * A burst larger than the buffer is written in pieces with the socket corked,
+ * so the pieces still leave in full segments.
+ * Returns 1 on success, 0 on failure.
+ */
+int net_send_events(net_socket_t sock, const GameEvent *events, size_t count)
+{
+    if (sock == NET_INVALID_SOCKET || (!events && count > 0))
+        return 0;
+
+    unsigned char batch[NET_SEND_BATCH_SIZE];
+    size_t used = 0;
+    int corked = 0;
+    int ok = 1;
+    for (size_t i = 0; i < count && ok; ++i)
+    {
+        if (sizeof(batch) - used < NET_FRAME_MAX_SIZE)
+        {
+            if (!corked)
+                corked = net_set_cork(sock, 1) == 0;
+            ok = net_send_all(sock, batch, used);
+            used = 0;
+            if (!ok)
+                break;
+        }
+
+        size_t frame_size = net_encode_event(&events[i], batch + used, NET_FRAME_MAX_SIZE);
+        if (frame_size == 0)
+        {
+            fprintf(stderr, "Warning: Event type %d does not fit in a frame\n", (int)events[i].type);
+            ok = 0;
+            break;
+        }
+        used += frame_size;
+    }
+    if (ok && used > 0)
+        ok = net_send_all(sock, batch, used);
+    if (corked)
+        net_set_cork(sock, 0);
+    return ok;
+}
+
+/**
+ * Gathered write of several buffers in one system call.
+ * Slices beyond NET_SENDV_MAX_SLICES are left for the next call.
+ */
+ssize_t net_sendv(net_socket_t sock, const NetIoSlice *slices, size_t count, int flags)
+{
+    if (count > NET_SENDV_MAX_SLICES)
+        count = NET_SENDV_MAX_SLICES;
+
+#if defined(_WIN32)
+    WSABUF buffers[NET_SENDV_MAX_SLICES];
+    for (size_t i = 0; i < count; ++i)
+    {
+        buffers[i].buf = (CHAR *)slices[i].data;
+        buffers[i].len = (ULONG)slices[i].length;
+    }
+    DWORD sent = 0;
+    (void)flags; // Server sockets are already nonblocking on Windows
+    net_io_count(NET_IO_WRITE);
+    if (WSASend(sock, buffers, (DWORD)count, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+        return NET_SOCKET_ERROR;
+    return (ssize_t)sent;
+#else
+    struct iovec iov[NET_SENDV_MAX_SLICES];
+    for (size_t i = 0; i < count; ++i)
+    {
+        iov[i].iov_base = (void *)slices[i].data;
+        iov[i].iov_len = slices[i].length;
+    }
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    net_io_count(NET_IO_WRITE);
+    return sendmsg(sock, &msg, flags);
+#endif
+}
+
+/**
+ * Toggle TCP corking. Turning it off pushes out whatever was held back.
+ */
+int net_set_cork(net_socket_t sock, int enabled)
+{
+    int value = enabled ? 1 : 0;
+#if defined(TCP_CORK)
+    net_io_count(NET_IO_CONTROL);
+    return setsockopt(sock, IPPROTO_TCP, TCP_CORK, (const char *)&value, sizeof(value)) == 0 ? 0 : -1;
+#elif defined(TCP_NOPUSH)
+    net_io_count(NET_IO_CONTROL);
+    return setsockopt(sock, IPPROTO_TCP, TCP_NOPUSH, (const char *)&value, sizeof(value)) == 0 ? 0 : -1;
+#else
+    (void)sock;
+    (void)value;
+    return -1;
+#endif
+}
+
+/**
+ * Send a batch of datagrams. Linux hands the whole batch to the kernel with
+ * sendmmsg(); other platforms fall back to one sendto() each.
+ */
+int net_send_datagrams(net_socket_t sock, const NetDatagram *datagrams, size_t count)
+{
+    if (sock == NET_INVALID_SOCKET || !datagrams)
+        return 0;
+
+    int sent = 0;
+#if defined(__linux__)
+    size_t next = 0;
+    while (next < count)
+    {
+        struct mmsghdr messages[NET_SENDV_MAX_SLICES];
+        struct iovec iov[NET_SENDV_MAX_SLICES];
+        size_t batch = count - next;
+        if (batch > NET_SENDV_MAX_SLICES)
+            batch = NET_SENDV_MAX_SLICES;
+        memset(messages, 0, batch * sizeof(messages[0]));
+        for (size_t i = 0; i < batch; ++i)
+        {
+            const NetDatagram *datagram = &datagrams[next + i];
+            iov[i].iov_base = (void *)datagram->data;
+            iov[i].iov_len = datagram->length;
+            messages[i].msg_hdr.msg_name = (void *)&datagram->addr;
+            messages[i].msg_hdr.msg_namelen = sizeof(datagram->addr);
+            messages[i].msg_hdr.msg_iov = &iov[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        net_io_count(NET_IO_WRITE);
+        int result = sendmmsg(sock, messages, (unsigned int)batch, 0);
+        if (result < 0)
+        {
+            // Only the first datagram failed (e.g. an unreachable broadcast address); skip it
+            if (errno != EINTR)
+                next++;
+            continue;
+        }
+        next += (size_t)result;
+        sent += result;
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+        net_io_count(NET_IO_WRITE);
+        if (sendto(sock, (const char *)datagrams[i].data, (int)datagrams[i].length, 0,
+                   (const struct sockaddr *)&datagrams[i].addr, sizeof(datagrams[i].addr)) != NET_SOCKET_ERROR)
+            sent++;
+    }
+#endif
+    return sent;
+}
+
+/**
+ * Encode a GameEvent into a wire frame and send it over the socket.
+ * Returns 1 on success, 0 on failure.
+ */
+int net_send_event(net_socket_t sock, const GameEvent *event)
+{
+    if (sock == NET_INVALID_SOCKET || !event)
+        return 0;
+
+    unsigned char frame[NET_FRAME_MAX_SIZE];
+    size_t frame_size = net_encode_event(event, frame, sizeof(frame));
+    if (frame_size == 0)
+    {
+        fprintf(stderr, "Warning: Event type %d does not fit in a frame\n", (int)event->type);
+        return 0;
+    }
+    return net_send_frame(sock, frame, frame_size);
+}
+
+/**
+ * Wait until the socket is readable or timeout_ms elapses (0 = poll, -1 = forever).
+ * Returns 1 if readable, 0 on timeout/interrupt, -1 on error.
+ */
+static int net_wait_readable(net_socket_t sock, int timeout_ms)
+{
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(sock, &readfds);
+
+    struct timeval tv;
+    struct timeval *tv_ptr = NULL;
+    if (timeout_ms >= 0)
+    {
+        tv.tv_sec = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        tv_ptr = &tv;
+    }
+
+#if defined(_WIN32)
+    int ready = select(0, &readfds, NULL, NULL, tv_ptr);
+#else
+    int ready = select((int)(sock + 1), &readfds, NULL, NULL, tv_ptr);
+#endif
+    if (ready < 0)
+    {
+        int last_error = NET_ERRNO();
+        if (last_error == NET_EINTR)
+            return 0; // Interrupted, treat as timeout
+        net_log_socket_error("select");
+        return -1;
+    }
+    return ready > 0 ? 1 : 0;
+}
+
+/**
+ * Reset a receive buffer, discarding any partial frame.
+ */
+void net_recv_buffer_reset(NetRecvBuffer *buffer)
+{
+    if (!buffer)
+        return;
+    buffer->start = 0;
+    buffer->end = 0;
+}
+
+// Move the partial tail to the front so the free space is contiguous
+static void net_recv_buffer_compact(NetRecvBuffer *buffer)
+{
+    if (buffer->start > 0)
+    {
+        size_t pending = buffer->end - buffer->start;
+        memmove(buffer->data, buffer->data + buffer->start, pending);
+        buffer->start = 0;
+        buffer->end = pending;
+    }
+}
+
+/**
+ * Read everything currently available on the socket into the buffer with one recv().
+ * Returns bytes read (> 0), 0 if no data was available, -1 on error/disconnect.
+ */
+int net_recv_buffer_fill(net_socket_t sock, NetRecvBuffer *buffer)
+{
+    if (sock == NET_INVALID_SOCKET || !buffer)
+        return -1;
+
+    net_recv_buffer_compact(buffer);
+
+    size_t space = sizeof(buffer->data) - buffer->end;
+    if (space == 0)
+    {
+        // Cannot happen with well-formed frames: NET_FRAME_MAX_SIZE is far below the buffer size
+        fprintf(stderr, "Warning: Receive buffer overflow\n");
+        return -1;
+    }
+
+#if defined(_WIN32)
+    int recv_flags = 0; // Winsock has no per-call MSG_DONTWAIT; callers wait for readability first
+#else
+    int recv_flags = MSG_DONTWAIT;
+#endif
+    net_io_count(NET_IO_READ);
+    ssize_t valread = recv(sock, (char *)buffer->data + buffer->end, (int)space, recv_flags);
+    if (valread == 0)
+    {
+        return -1; // disconnected
+    }
+    if (valread < 0)
+    {
+        int last_error = NET_ERRNO();
+        if (last_error == NET_EWOULDBLOCK || last_error == NET_EAGAIN || last_error == NET_EINTR)
+        {
+            return 0; // no data available right now
+        }
+        net_log_socket_error("recv");
+        return -1;
+    }
+
+    buffer->end += (size_t)valread;
+    return (int)valread;
+}
+
+/**
+ * Append bytes that were received elsewhere (e.g. by an io_uring multishot recv).
+ * Returns 0 on success, -1 if they do not fit.
+ */
+int net_recv_buffer_append(NetRecvBuffer *buffer, const unsigned char *data, size_t len)
+{
+    if (!buffer || (!data && len > 0))
+        return -1;
+
+    net_recv_buffer_compact(buffer);
+    if (len > sizeof(buffer->data) - buffer->end)
+    {
+        fprintf(stderr, "Warning: Receive buffer overflow\n");
+        return -1;
+    }
+    memcpy(buffer->data + buffer->end, data, len);
+    buffer->end += len;
+    return 0;
+}
+
+/**
+ * Pop the next complete event out of the buffer.
+ * Returns 1 on success, 0 if the buffer holds no complete frame, -1 on a malformed frame.
+ */
+int net_recv_buffer_pop(NetRecvBuffer *buffer, GameEvent *event)
+{
+    if (!buffer || !event)
+        return -1;
 
-    int pton_result = inet_pton(AF_INET, host, &serv_addr.sin_addr);
-    if (pton_result <= 0)
+    int consumed = net_decode_event(buffer->data + buffer->start, buffer->end - buffer->start, event);
+    if (consumed < 0)
     {
-        if (host && strcmp(host, "localhost") == 0)
-        {
-            pton_result = inet_pton(AF_INET, "127.0.0.1", &serv_addr.sin_addr);
-        }
+        fprintf(stderr, "Warning: Malformed event frame\n");
+        return -1;
     }
-
-    if (pton_result <= 0)
+    if (consumed == 0)
     {
-        fprintf(stderr, "Invalid address: %s\n", host ? host : "(null)");
-        net_close_socket(sock);
-        return NET_INVALID_SOCKET;
+        return 0;
     }
 
-    if (connect(sock, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) == NET_SOCKET_ERROR)
+    buffer->start += (size_t)consumed;
+    if (buffer->start == buffer->end)
     {
-        net_log_socket_error("connect");
-        net_close_socket(sock);
-        return NET_INVALID_SOCKET;
+        buffer->start = 0;
+        buffer->end = 0;
     }
+    return 1;
+}
 
-    // Enable TCP_NODELAY to reduce latency (disable Nagle's algorithm)
-    int nodelay = 1;
-    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay, sizeof(nodelay));
+/**
+ * Receive the next GameEvent through the connection's buffer.
+ * Events already buffered are returned without touching the socket.
+ * Returns 1 on success, 0 if no complete event is available (non-blocking), -1 on error/disconnect.
+ */
+int net_receive_event_flags(net_socket_t sock, NetRecvBuffer *buffer, GameEvent *event, int flags)
+{
+    int wants_nonblock = (flags & NET_MSG_DONTWAIT) != 0;
+    return net_receive_event_timeout(sock, buffer, event, wants_nonblock ? 0 : -1);
+}
 
-    return sock;
+/**
+ * Receive a GameEvent from the socket (blocking).
+ * Returns 1 on success, 0 on error/disconnect.
+ */
+int net_receive_event(net_socket_t sock, NetRecvBuffer *buffer, GameEvent *event)
+{
+    int result = net_receive_event_flags(sock, buffer, event, 0);
+    return result > 0 ? 1 : 0;
 }
 
 /**
- * Close a socket if valid.
+ * Receive a GameEvent from the socket with a timeout (-1 waits forever).
+ * Returns 1 on success, 0 on timeout, -1 on error/disconnect.
+ * Each wakeup reads everything available; the extra events stay buffered
+ * and are returned by later calls without another syscall.
  */
-void net_close_socket(net_socket_t sock)
+int net_receive_event_timeout(net_socket_t sock, NetRecvBuffer *buffer, GameEvent *event, int timeout_ms)
 {
-    if (sock != NET_INVALID_SOCKET)
+    if (sock == NET_INVALID_SOCKET || !buffer || !event)
+        return -1;
+
+    for (;;)
     {
-        NET_CLOSE_SOCKET(sock);
+        int popped = net_recv_buffer_pop(buffer, event);
+        if (popped != 0)
+        {
+            return popped;
+        }
+
+        int ready = net_wait_readable(sock, timeout_ms);
+        if (ready <= 0)
+        {
+            return ready; // Timeout (0) or error (-1)
+        }
+
+        if (net_recv_buffer_fill(sock, buffer) < 0)
+        {
+            return -1;
+        }
+        if (timeout_ms >= 0)
+        {
+            // Timed callers return after one read; a partial frame stays buffered for the next call
+            return net_recv_buffer_pop(buffer, event);
+        }
+        // Blocking callers loop until the rest of the frame arrives
     }
 }
 
 /**
- * Send a GameEvent struct over the socket.
- * Returns 1 on success, 0 on failure.
+ * List the IPv4 interfaces that are up, with their broadcast addresses.
+ * Returns how many were stored in out_interfaces.
  */
-int net_send_event(net_socket_t sock, const GameEvent *event)
+int net_list_interfaces(NetInterface *out_interfaces, int max_interfaces)
 {
+    if (!out_interfaces || max_interfaces <= 0 || net_ensure_platform_initialized() != 0)
+        return 0;
+
+    int count = 0;
+#if defined(_WIN32)
+    net_socket_t sock = socket(AF_INET, SOCK_DGRAM, 0);
     if (sock == NET_INVALID_SOCKET)
         return 0;
-    ssize_t sent = send(sock, (const char *)event, sizeof(GameEvent), 0);
-    if (sent != (ssize_t)sizeof(GameEvent))
+    INTERFACE_INFO list[NET_MAX_INTERFACES];
+    DWORD bytes = 0;
+    if (WSAIoctl(sock, SIO_GET_INTERFACE_LIST, NULL, 0, list, sizeof(list), &bytes, NULL, NULL) == 0)
     {
-        if (sent == NET_SOCKET_ERROR)
+        int listed = (int)(bytes / sizeof(INTERFACE_INFO));
+        for (int i = 0; i < listed && count < max_interfaces; ++i)
         {
-            net_log_socket_error("send");
+            if (!(list[i].iiFlags & IFF_UP))
+                continue;
+            NetInterface *entry = &out_interfaces[count++];
+            memset(entry, 0, sizeof(*entry));
+            entry->address = list[i].iiAddress.AddressIn.sin_addr;
+            // Windows reports 255.255.255.255 here; the subnet's own address is derived instead
+            entry->broadcast.s_addr = entry->address.s_addr | ~list[i].iiNetmask.AddressIn.sin_addr.s_addr;
+            if (list[i].iiFlags & IFF_BROADCAST)
+                entry->flags |= NET_INTERFACE_BROADCAST;
+            if (list[i].iiFlags & IFF_MULTICAST)
+                entry->flags |= NET_INTERFACE_MULTICAST;
+            if (list[i].iiFlags & IFF_LOOPBACK)
+                entry->flags |= NET_INTERFACE_LOOPBACK;
         }
+    }
+    net_close_socket(sock);
+#else
+    struct ifaddrs *addresses = NULL;
+    if (getifaddrs(&addresses) != 0)
         return 0;
+    for (struct ifaddrs *it = addresses; it && count < max_interfaces; it = it->ifa_next)
+    {
+        if (!it->ifa_addr || it->ifa_addr->sa_family != AF_INET || !(it->ifa_flags & IFF_UP))
+            continue;
+        NetInterface *entry = &out_interfaces[count++];
+        memset(entry, 0, sizeof(*entry));
+        entry->address = ((const struct sockaddr_in *)it->ifa_addr)->sin_addr;
+        if ((it->ifa_flags & IFF_BROADCAST) && it->ifa_broadaddr)
+        {
+            entry->broadcast = ((const struct sockaddr_in *)it->ifa_broadaddr)->sin_addr;
+            entry->flags |= NET_INTERFACE_BROADCAST;
+        }
+        if (it->ifa_flags & IFF_MULTICAST)
+            entry->flags |= NET_INTERFACE_MULTICAST;
+        if (it->ifa_flags & IFF_LOOPBACK)
+            entry->flags |= NET_INTERFACE_LOOPBACK;
     }
-    return 1;
+    freeifaddrs(addresses);
+#endif
+    return count;
 }
 
 /**
- * Receive a GameEvent struct from the socket with flags.
- * Returns 1 on success, 0 if no data (non-blocking), -1 on error/disconnect.
+ * Parse a beacon or probe reply:
+ * "<prefix> <port> <players> <max> [<server id> <phase> <wire version>]".
+ * Older servers stop after <max>; they were waiting-only wire version 1 servers.
+ * Returns 1 on success, 0 if the payload is not one.
  */
-int net_receive_event_flags(net_socket_t sock, GameEvent *event, int flags)
+int net_parse_lan_host(const char *payload, const char *prefix, const struct sockaddr_in *from, NetLanHost *out_host)
 {
-    if (sock == NET_INVALID_SOCKET || !event)
-        return -1;
+    size_t prefix_length = strlen(prefix);
+    if (strncmp(payload, prefix, prefix_length) != 0)
+        return 0;
 
-    int wants_nonblock = (flags & NET_MSG_DONTWAIT) != 0;
+    memset(out_host, 0, sizeof(*out_host));
+    unsigned int server_id = 0;
+    out_host->phase = LOBBY_PHASE_WAITING;
+    out_host->protocol_version = 1;
+    out_host->rtt_us = -1;
+    int fields = sscanf(payload + prefix_length, "%d %d %d %u %d %d", &out_host->port, &out_host->player_count,
+                        &out_host->max_players, &server_id, &out_host->phase, &out_host->protocol_version);
+    if (fields < 1)
+        return 0;
+    out_host->server_id = server_id;
+    return inet_ntop(AF_INET, &from->sin_addr, out_host->address, sizeof(out_host->address)) != NULL;
+}
 
-    // Use select() for non-blocking check on all platforms for consistency
-    if (wants_nonblock)
-    {
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        FD_SET(sock, &readfds);
+int net_lan_host_joinable(const NetLanHost *host)
+{
+    if (!host || host->protocol_version != ARMADA_WIRE_VERSION || host->phase == LOBBY_PHASE_IN_MATCH)
+        return 0;
+    return host->max_players <= 0 || host->player_count < host->max_players;
+}
 
-        struct timeval tv;
-        tv.tv_sec = 0;
-        tv.tv_usec = 0; // Zero timeout = poll
+// Same server: by id when it sends one, otherwise by address and port
+static int net_same_lan_host(const NetLanHost *a, const NetLanHost *b)
+{
+    if (a->server_id != 0 || b->server_id != 0)
+        return a->server_id == b->server_id;
+    return a->port == b->port && strcmp(a->address, b->address) == 0;
+}
 
-#if defined(_WIN32)
-        int ready = select(0, &readfds, NULL, NULL, &tv);
-#else
-        int ready = select((int)(sock + 1), &readfds, NULL, NULL, &tv);
-#endif
-        if (ready < 0)
-        {
-            int last_error = NET_ERRNO();
-            if (last_error == NET_EINTR)
-                return 0;
-            net_log_socket_error("select");
-            return -1;
-        }
-        if (ready == 0)
-        {
-            return 0; // No data available
-        }
-    }
+typedef struct
+{
+    char (*hosts)[64];
+    int max_hosts;
+    int found;
+} NetHostCollector;
 
-    // Now do a blocking recv - we know data is available if non-blocking was requested
-    ssize_t valread = recv(sock, (char *)event, sizeof(GameEvent), 0);
+static int net_collect_host(const NetLanHost *host, void *userdata)
+{
+    NetHostCollector *collector = (NetHostCollector *)userdata;
+    snprintf(collector->hosts[collector->found], sizeof(collector->hosts[0]), "%s", host->address);
+    return ++collector->found >= collector->max_hosts;
+}
 
-    if (valread == 0)
+/**
+ * Discover LAN servers by probing every local subnet.
+ * Fills hosts array with found server IPs (up to max_hosts).
+ * Returns number of servers found.
+ */
+int net_discover_lan_servers(char hosts[][64], int max_hosts, int port, int timeout_ms)
+{
+    if (!hosts || max_hosts <= 0)
     {
-        return -1; // disconnected
+        return 0;
     }
 
-    if (valread < 0)
-    {
-        int last_error = NET_ERRNO();
-        if (last_error == NET_EWOULDBLOCK || last_error == NET_EAGAIN || last_error == NET_EINTR)
-        {
-            return 0; // no data available for non-blocking polls
-        }
-        net_log_socket_error("recv");
-        return -1;
-    }
+    NetHostCollector collector = {hosts, max_hosts, 0};
+    net_discover_lan_servers_stream(port, timeout_ms, net_collect_host, &collector);
+    return collector.found;
+}
 
-    if (valread != (ssize_t)sizeof(GameEvent))
+/**
+ * Let beacons come back to listeners on this machine, so the host sees its
+ * own server. The interface is chosen per send by net_beacon_send.
+ * Returns 0 on success, -1 on failure.
+ */
+int net_beacon_configure_sender(net_socket_t sock)
+{
+    unsigned char ttl = 1; // Stay on the local network
+    unsigned char loop = 1;
+    if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, (const char *)&ttl, sizeof(ttl)) == NET_SOCKET_ERROR ||
+        setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, (const char *)&loop, sizeof(loop)) == NET_SOCKET_ERROR)
     {
-        fprintf(stderr, "Warning: Partial event read %zd/%zu\n", valread, sizeof(GameEvent));
+        net_log_socket_error("setsockopt(IP_MULTICAST)");
         return -1;
     }
-
-    return 1;
+    return 0;
 }
 
 /**
- * Receive a GameEvent struct from the socket (blocking).
- * Returns 1 on success, 0 on error/disconnect.
+ * Send one beacon to ARMADA_BEACON_GROUP out of every multicast interface, so
+ * each subnet of a multi-homed host hears it. A unicast copy to loopback
+ * reaches a client on this machine when no interface carries multicast.
+ * Returns 0 if any copy was sent, -1 otherwise.
  */
-int net_receive_event(net_socket_t sock, GameEvent *event)
+int net_beacon_send(net_socket_t sock, const char *payload, size_t length)
 {
-    int result = net_receive_event_flags(sock, event, 0);
-    return result > 0 ? 1 : 0;
+    struct sockaddr_in group;
+    memset(&group, 0, sizeof(group));
+    group.sin_family = AF_INET;
+    group.sin_port = htons(ARMADA_BEACON_PORT);
+    inet_pton(AF_INET, ARMADA_BEACON_GROUP, &group.sin_addr);
+
+    int sent_any = 0;
+    NetInterface interfaces[NET_MAX_INTERFACES];
+    int interface_count = net_list_interfaces(interfaces, NET_MAX_INTERFACES);
+    for (int i = 0; i < interface_count; ++i)
+    {
+        if ((interfaces[i].flags & NET_INTERFACE_LOOPBACK) || !(interfaces[i].flags & NET_INTERFACE_MULTICAST))
+            continue;
+        if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, (const char *)&interfaces[i].address,
+                       sizeof(interfaces[i].address)) == NET_SOCKET_ERROR)
+            continue;
+        net_io_count(NET_IO_WRITE);
+        if (sendto(sock, payload, (int)length, 0, (struct sockaddr *)&group, sizeof(group)) == (ssize_t)length)
+            sent_any = 1;
+    }
+
+    struct sockaddr_in local = group;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    net_io_count(NET_IO_WRITE);
+    if (sendto(sock, payload, (int)length, 0, (struct sockaddr *)&local, sizeof(local)) == (ssize_t)length)
+        sent_any = 1;
+    return sent_any ? 0 : -1;
 }
 
 /**
- * Receive a GameEvent struct from the socket with a timeout.
- * Returns 1 on success, 0 on timeout, -1 on error/disconnect.
- * This is useful for server client threads that need to periodically
- * check if the server is still running.
+ * Bind the beacon port and join the beacon group on every multicast
+ * interface. Several clients on one machine can listen at once.
+ * Returns 0 on success, -1 if no interface could join.
  */
-int net_receive_event_timeout(net_socket_t sock, GameEvent *event, int timeout_ms)
+int net_beacon_listen(NetBeaconListener *listener)
 {
-    if (sock == NET_INVALID_SOCKET || !event)
+    if (!listener)
         return -1;
+    memset(listener, 0, sizeof(*listener));
+    listener->sock = NET_INVALID_SOCKET;
 
-    fd_set readfds;
-    FD_ZERO(&readfds);
-    FD_SET(sock, &readfds);
+    if (net_ensure_platform_initialized() != 0)
+        return -1;
 
-    struct timeval tv;
-    tv.tv_sec = timeout_ms / 1000;
-    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    net_socket_t sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock == NET_INVALID_SOCKET)
+    {
+        net_log_socket_error("socket");
+        return -1;
+    }
 
-#if defined(_WIN32)
-    int ready = select(0, &readfds, NULL, NULL, &tv);
-#else
-    int ready = select((int)(sock + 1), &readfds, NULL, NULL, &tv);
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+#if defined(SO_REUSEPORT) && !defined(_WIN32)
+    // BSDs only share a multicast port between sockets that all set this
+    setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (const char *)&reuse, sizeof(reuse));
 #endif
-    if (ready < 0)
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(ARMADA_BEACON_PORT);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) == NET_SOCKET_ERROR)
     {
-        int last_error = NET_ERRNO();
-        if (last_error == NET_EINTR)
-            return 0; // Interrupted, treat as timeout
-        net_log_socket_error("select");
+        net_log_socket_error("bind");
+        net_close_socket(sock);
         return -1;
     }
-    if (ready == 0)
+
+    struct ip_mreq membership;
+    memset(&membership, 0, sizeof(membership));
+    inet_pton(AF_INET, ARMADA_BEACON_GROUP, &membership.imr_multiaddr);
+    int joined = 0;
+    NetInterface interfaces[NET_MAX_INTERFACES];
+    int interface_count = net_list_interfaces(interfaces, NET_MAX_INTERFACES);
+    for (int i = 0; i < interface_count; ++i)
     {
-        return 0; // Timeout, no data available
+        if ((interfaces[i].flags & NET_INTERFACE_LOOPBACK) || !(interfaces[i].flags & NET_INTERFACE_MULTICAST))
+            continue;
+        membership.imr_interface = interfaces[i].address;
+        if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char *)&membership, sizeof(membership)) == 0)
+            joined = 1;
     }
-
-    // Data is available, do a blocking recv
-    ssize_t valread = recv(sock, (char *)event, sizeof(GameEvent), 0);
-
-    if (valread == 0)
+    if (!joined)
     {
-        return -1; // disconnected
+        // Interfaces could not be listed: let the system pick one
+        membership.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char *)&membership, sizeof(membership)) == NET_SOCKET_ERROR)
+        {
+            net_log_socket_error("setsockopt(IP_ADD_MEMBERSHIP)");
+            net_close_socket(sock);
+            return -1;
+        }
     }
 
-    if (valread < 0)
+    net_set_nonblocking(sock);
+    listener->sock = sock;
+    return 0;
+}
+
+// Record one beacon. Returns 1 if the table changed.
+static int net_beacon_record(NetBeaconListener *listener, const struct sockaddr_in *from, const char *payload, uint64_t now_us)
+{
+    NetLanHost heard;
+    if (!net_parse_lan_host(payload, ARMADA_BEACON, from, &heard))
+        return 0;
+
+    NetLanHost *host = NULL;
+    for (int i = 0; i < listener->host_count; ++i)
     {
-        int last_error = NET_ERRNO();
-        if (last_error == NET_EWOULDBLOCK || last_error == NET_EAGAIN || last_error == NET_EINTR)
+        if (net_same_lan_host(&listener->hosts[i], &heard))
         {
-            return 0; // Treat as timeout
+            host = &listener->hosts[i];
+            break;
         }
-        net_log_socket_error("recv");
-        return -1;
     }
 
-    if (valread != (ssize_t)sizeof(GameEvent))
+    int changed = 0;
+    if (!host)
     {
-        fprintf(stderr, "Warning: Partial event read %zd/%zu\n", valread, sizeof(GameEvent));
-        return -1;
+        if (listener->host_count >= NET_BEACON_MAX_HOSTS)
+            return 0;
+        // A server heard on several interfaces keeps the first address it came from
+        host = &listener->hosts[listener->host_count++];
+        *host = heard;
+        changed = 1;
     }
-
-    return 1;
+    if (host->player_count != heard.player_count || host->max_players != heard.max_players ||
+        host->phase != heard.phase || host->protocol_version != heard.protocol_version)
+    {
+        host->player_count = heard.player_count;
+        host->max_players = heard.max_players;
+        host->phase = heard.phase;
+        host->protocol_version = heard.protocol_version;
+        changed = 1;
+    }
+    host->last_seen_us = now_us;
+    return changed;
 }
 
 /**
- * Check if candidate host is already in the hosts list.
- * Returns 1 if found, 0 otherwise.
+ * Wait up to wait_ms for beacons, read every one that is queued, then expire
+ * hosts that stopped announcing. Hosts keep their order of first arrival.
+ * Returns 1 if the table changed, 0 if not, -1 on a socket error.
  */
-static int net_host_list_contains(char hosts[][64], int count, const char *candidate)
+int net_beacon_poll(NetBeaconListener *listener, int wait_ms)
 {
-    if (!candidate)
+    if (!listener || listener->sock == NET_INVALID_SOCKET)
+        return -1;
+
+    if (wait_ms > 0)
     {
-        return 0;
+        fd_set readfds;
+        FD_ZERO(&readfds);
+        FD_SET(listener->sock, &readfds);
+        struct timeval wait;
+        wait.tv_sec = wait_ms / 1000;
+        wait.tv_usec = (wait_ms % 1000) * 1000;
+        net_io_count(NET_IO_WAIT);
+#if defined(_WIN32)
+        int ready = select(0, &readfds, NULL, NULL, &wait);
+#else
+        int ready = select((int)(listener->sock + 1), &readfds, NULL, NULL, &wait);
+#endif
+        if (ready < 0 && NET_ERRNO() != NET_EINTR)
+            return -1;
     }
 
-    for (int i = 0; i < count; ++i)
+    int changed = 0;
+    uint64_t now_us = net_monotonic_us();
+    for (;;)
     {
-        if (strncmp(hosts[i], candidate, 64) == 0)
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        char buffer[128];
+        net_io_count(NET_IO_READ);
+        ssize_t len = recvfrom(listener->sock, buffer, sizeof(buffer) - 1, 0, (struct sockaddr *)&from, &from_len);
+        if (len < 0)
         {
-            return 1;
+            if (NET_ERRNO() == NET_EINTR)
+                continue;
+            break; // Drained
         }
+        buffer[len] = '\0';
+        changed |= net_beacon_record(listener, &from, buffer, now_us);
     }
-    return 0;
+
+    uint64_t ttl_us = (uint64_t)NET_BEACON_TTL_MS * 1000ULL;
+    int kept = 0;
+    for (int i = 0; i < listener->host_count; ++i)
+    {
+        if (now_us - listener->hosts[i].last_seen_us > ttl_us)
+        {
+            changed = 1;
+            continue;
+        }
+        if (kept != i)
+            listener->hosts[kept] = listener->hosts[i];
+        ++kept;
+    }
+    listener->host_count = kept;
+    return changed;
+}
+
+typedef struct
+{
+    NetBeaconListener *listener;
+    int probed[NET_BEACON_MAX_HOSTS]; // Hosts of this round still waiting for a reply
+    int pending;
+    int measured;
+} NetRttProbe;
+
+static int net_beacon_take_rtt(const NetLanHost *reply, void *userdata)
+{
+    NetRttProbe *probe = (NetRttProbe *)userdata;
+    for (int i = 0; i < probe->listener->host_count; ++i)
+    {
+        NetLanHost *host = &probe->listener->hosts[i];
+        if (net_same_lan_host(host, reply))
+        {
+            host->rtt_us = reply->rtt_us;
+            host->rtt_misses = 0;
+            host->next_rtt_probe_us = reply->last_seen_us + (uint64_t)NET_BEACON_RTT_REFRESH_MS * 1000ULL;
+            ++probe->measured;
+            if (probe->probed[i])
+            {
+                probe->probed[i] = 0;
+                --probe->pending;
+            }
+            break;
+        }
+    }
+    return probe->pending == 0;
 }
 
-static int net_discover_lan_servers_udp(char hosts[][64], int max_hosts, int port, int timeout_ms);
+// Targets one probe batch can hold: every beacon host, which outnumbers the
+// interfaces plus loopback that a broadcast round reaches
+#define NET_PROBE_TARGETS_MAX NET_BEACON_MAX_HOSTS
+
+static int net_probe_targets(int port, const struct in_addr *targets, size_t target_count, int timeout_ms,
+                             NetDiscoveryCallback callback, void *userdata);
 
 /**
- * Discover LAN servers by probing common local IPs.
- * Fills hosts array with found server IPs (up to max_hosts).
- * Returns number of servers found.
+ * Probe each host in the table that is due, with one datagram to its own
+ * address, and store its round trip. A host that answers is measured again
+ * after NET_BEACON_RTT_REFRESH_MS; one that does not is retried after
+ * NET_BEACON_RTT_RETRY_MS, doubling per miss up to NET_BEACON_RTT_BACKOFF_MAX_MS.
+ * Hosts that do not answer keep their last measurement. Stops early once all
+ * answered. Returns the number of hosts measured, 0 when none was due.
  */
-int net_discover_lan_servers(char hosts[][64], int max_hosts, int port, int timeout_ms)
+int net_beacon_measure_rtt(NetBeaconListener *listener, int port, int timeout_ms)
 {
-    if (!hosts || max_hosts <= 0)
-    {
+    if (!listener || listener->host_count == 0)
         return 0;
-    }
 
-    if (timeout_ms < 0)
+    NetRttProbe probe;
+    memset(&probe, 0, sizeof(probe));
+    probe.listener = listener;
+    struct in_addr targets[NET_BEACON_MAX_HOSTS];
+    size_t target_count = 0;
+    uint64_t now_us = net_monotonic_us();
+    for (int i = 0; i < listener->host_count; ++i)
     {
-        timeout_ms = 300;
+        NetLanHost *host = &listener->hosts[i];
+        if (host->next_rtt_probe_us > now_us)
+            continue;
+
+        // Schedule the retry up front, so a silent host is not probed again on every poll
+        uint64_t backoff_ms = NET_BEACON_RTT_RETRY_MS;
+        for (int miss = 0; miss < host->rtt_misses && backoff_ms < NET_BEACON_RTT_BACKOFF_MAX_MS; ++miss)
+            backoff_ms *= 2;
+        if (backoff_ms > NET_BEACON_RTT_BACKOFF_MAX_MS)
+            backoff_ms = NET_BEACON_RTT_BACKOFF_MAX_MS;
+        host->next_rtt_probe_us = now_us + backoff_ms * 1000ULL;
+        host->rtt_misses += 1;
+
+        struct in_addr address;
+        if (inet_pton(AF_INET, host->address, &address) != 1)
+            continue;
+        probe.probed[i] = 1;
+        ++probe.pending;
+
+        // Servers sharing an address all answer the same probe
+        int duplicate = 0;
+        for (size_t t = 0; t < target_count && !duplicate; ++t)
+            duplicate = targets[t].s_addr == address.s_addr;
+        if (!duplicate)
+            targets[target_count++] = address;
     }
+    if (target_count == 0)
+        return 0;
+
+    net_probe_targets(port, targets, target_count, timeout_ms, net_beacon_take_rtt, &probe);
+    return probe.measured;
+}
 
-    return net_discover_lan_servers_udp(hosts, max_hosts, port, timeout_ms);
+void net_beacon_close(NetBeaconListener *listener)
+{
+    if (!listener || listener->sock == NET_INVALID_SOCKET)
+        return;
+    net_close_socket(listener->sock);
+    listener->sock = NET_INVALID_SOCKET;
+    listener->host_count = 0;
 }
 
 static long net_elapsed_ms_since(const struct timeval *start)
@@ -403,18 +1814,59 @@ static long net_elapsed_ms_since(const struct timeval *start)
     return sec * 1000L + usec / 1000L;
 }
 
-static int net_discover_lan_servers_udp(char hosts[][64], int max_hosts, int port, int timeout_ms)
+/**
+ * Probe every up interface's broadcast address and this machine with one
+ * batch of datagrams, then hand each new server to callback as its reply
+ * arrives, until timeout_ms passes or callback returns nonzero.
+ * Returns the number of servers reported.
+ */
+int net_discover_lan_servers_stream(int port, int timeout_ms, NetDiscoveryCallback callback, void *userdata)
 {
-    if (max_hosts <= 0)
+    if (!callback)
     {
         return 0;
     }
 
+    if (timeout_ms < 0)
+    {
+        timeout_ms = 300;
+    }
+
     if (net_ensure_platform_initialized() != 0)
     {
         return 0;
     }
 
+    // One probe per subnet, all in a single batch
+    NetInterface interfaces[NET_MAX_INTERFACES];
+    int interface_count = net_list_interfaces(interfaces, NET_MAX_INTERFACES);
+    struct in_addr targets[NET_MAX_INTERFACES + 2];
+    size_t target_count = 0;
+    for (int i = 0; i < interface_count; ++i)
+    {
+        if ((interfaces[i].flags & NET_INTERFACE_BROADCAST) && !(interfaces[i].flags & NET_INTERFACE_LOOPBACK))
+        {
+            targets[target_count++] = interfaces[i].broadcast;
+        }
+    }
+    if (target_count == 0)
+    {
+        // Nothing listed: the limited broadcast at least leaves by the default route
+        targets[target_count++].s_addr = htonl(INADDR_BROADCAST);
+    }
+    targets[target_count++].s_addr = htonl(INADDR_LOOPBACK); // A server on this machine
+
+    return net_probe_targets(port, targets, target_count, timeout_ms, callback, userdata);
+}
+
+/**
+ * Send one discovery probe to each target in a single batch, then hand each
+ * new server to callback as its reply arrives, until timeout_ms passes or
+ * callback returns nonzero. Returns the number of servers reported.
+ */
+static int net_probe_targets(int port, const struct in_addr *targets, size_t target_count, int timeout_ms,
+                             NetDiscoveryCallback callback, void *userdata)
+{
     net_socket_t sock = socket(AF_INET, SOCK_DGRAM, 0);
     if (sock == NET_INVALID_SOCKET)
     {
@@ -429,30 +1881,29 @@ static int net_discover_lan_servers_udp(char hosts[][64], int max_hosts, int por
     addr.sin_family = AF_INET;
     addr.sin_port = htons(port);
 
-    const char *targets[] = {
-        "255.255.255.255",
-        "192.168.0.255",
-        "192.168.1.255",
-        "10.0.0.255",
-        "127.0.0.1"};
-    const size_t target_count = sizeof(targets) / sizeof(targets[0]);
     char payload[64];
     snprintf(payload, sizeof(payload), "%s %d", ARMADA_DISCOVERY_REQUEST, port);
 
+    NetDatagram probes[NET_PROBE_TARGETS_MAX];
+    if (target_count > NET_PROBE_TARGETS_MAX)
+        target_count = NET_PROBE_TARGETS_MAX;
     for (size_t i = 0; i < target_count; ++i)
     {
-        if (inet_pton(AF_INET, targets[i], &addr.sin_addr) <= 0)
-        {
-            continue;
-        }
-        sendto(sock, payload, strlen(payload), 0, (struct sockaddr *)&addr, sizeof(addr));
+        addr.sin_addr = targets[i];
+        probes[i].addr = addr;
+        probes[i].data = payload;
+        probes[i].length = strlen(payload);
     }
+    uint64_t sent_us = net_monotonic_us();
+    net_send_datagrams(sock, probes, target_count);
 
+    NetLanHost seen[NET_BEACON_MAX_HOSTS];
     int found = 0;
+    int stop = 0;
     struct timeval start;
     net_get_time(&start);
 
-    while (found < max_hosts)
+    while (!stop && found < NET_BEACON_MAX_HOSTS)
     {
         long elapsed = net_elapsed_ms_since(&start);
         if (elapsed >= timeout_ms)
@@ -510,25 +1961,27 @@ static int net_discover_lan_servers_udp(char hosts[][64], int max_hosts, int por
         }
 
         buffer[len] = '\0';
-        if (strncmp(buffer, ARMADA_DISCOVERY_RESPONSE, strlen(ARMADA_DISCOVERY_RESPONSE)) != 0)
+        NetLanHost *host = &seen[found];
+        if (!net_parse_lan_host(buffer, ARMADA_DISCOVERY_RESPONSE, &from, host))
         {
             continue;
         }
 
-        char address[64];
-        if (!inet_ntop(AF_INET, &from.sin_addr, address, sizeof(address)))
+        // A server answers each probe that reaches it, e.g. by broadcast and by loopback
+        int duplicate = 0;
+        for (int i = 0; i < found && !duplicate; ++i)
         {
-            continue;
+            duplicate = net_same_lan_host(&seen[i], host);
         }
-
-        if (net_host_list_contains(hosts, found, address))
+        if (duplicate)
         {
             continue;
         }
 
-        strncpy(hosts[found], address, 63);
-        hosts[found][63] = '\0';
+        host->last_seen_us = net_monotonic_us();
+        host->rtt_us = (int)(host->last_seen_us - sent_us);
         ++found;
+        stop = callback(host, userdata);
     }
 
     net_close_socket(sock);
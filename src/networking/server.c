@@ -1,6 +1,9 @@
 #include "../../include/server/server_api.h"
 #include "../../include/server/main.h"
 #include "../../include/networking/network.h"
+#include "../../include/networking/net_codec.h"
+#include "../../include/networking/net_snapshot.h"
+#include "../../include/networking/net_directory.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,6 +17,9 @@
 #include <netinet/tcp.h>
 #endif
 
+// Names the lock profiler reports the per-slot outbox locks under
+static const char *const server_player_mutex_names[MAX_PLAYERS] = {"player_mutex[0]", "player_mutex[1]", "player_mutex[2]", "player_mutex[3]"};
+
 // Create a new server context
 ServerContext *server_create()
 {
@@ -26,16 +32,45 @@ ServerContext *server_create()
     ctx->server_socket = NET_INVALID_SOCKET;
     ctx->discovery_socket = NET_INVALID_SOCKET;
     ctx->running = 0;
-    ctx->accept_thread = 0;
-    ctx->discovery_thread = 0;
+    ctx->io_threads = NULL;
+    ctx->io_thread_count = 1;
+    ctx->io_backend = NET_REACTOR_BACKEND_DEFAULT;
+    const char *backend_name = getenv("ARMADA_IO_BACKEND");
+    if (backend_name && net_reactor_backend_from_name(backend_name, &ctx->io_backend) != 0)
+    {
+        fprintf(stderr, "[Server] Warning: unknown ARMADA_IO_BACKEND \"%s\", using the default.\n", backend_name);
+    }
+    const char *directory = getenv("ARMADA_DIRECTORY");
+    if (directory && directory[0] && server_set_directory(ctx, directory) != 0)
+    {
+        fprintf(stderr, "[Server] Warning: cannot resolve ARMADA_DIRECTORY \"%s\", not registering.\n", directory);
+    }
     ctx->game_state.host_player_id = -1;
     ctx->game_state.turn.current_player_id = -1;
     ctx->game_state.winner_id = -1;
     for (int i = 0; i < MAX_PLAYERS; ++i)
     {
         ctx->player_sockets[i] = NET_INVALID_SOCKET;
+        net_outbox_reset(&ctx->outboxes[i], NET_INVALID_SOCKET);
+    }
+    ctx->slow_consumer_policy = NET_OUTBOX_POLICY_COALESCE;
+    ctx->heartbeat_interval_ms = NET_HEARTBEAT_INTERVAL_MS;
+    ctx->heartbeat_timeout_ms = NET_HEARTBEAT_TIMEOUT_MS;
+    ctx->resume_grace_ms = NET_RESUME_GRACE_MS;
+    ctx->listen_backlog = NET_LISTEN_BACKLOG;
+    server_default_rate_limits(ctx);
+    ctx->resume_seed = net_monotonic_us() ^ ((uint64_t)time(NULL) << 20) ^ (uint64_t)(uintptr_t)ctx;
+    do
+    {
+        ctx->server_id = (uint32_t)(server_new_resume_token(ctx) >> 32);
+    } while (ctx->server_id == 0);
+    net_profiled_mutex_init(&ctx->roster_mutex, "roster_mutex");
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        net_profiled_mutex_init(&ctx->player_mutexes[i], server_player_mutex_names[i]);
     }
-    net_mutex_init(&ctx->state_mutex);
+    net_mutex_init(&ctx->game_wake_mutex);
+    net_cond_init(&ctx->game_wake);
     return ctx;
 }
 
@@ -50,7 +85,13 @@ void server_destroy(ServerContext *ctx)
         server_stop(ctx);
     }
 
-    net_mutex_destroy(&ctx->state_mutex);
+    net_cond_destroy(&ctx->game_wake);
+    net_mutex_destroy(&ctx->game_wake_mutex);
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        net_profiled_mutex_destroy(&ctx->player_mutexes[i]);
+    }
+    net_profiled_mutex_destroy(&ctx->roster_mutex);
     free(ctx);
 }
 
@@ -63,19 +104,223 @@ int server_init(ServerContext *ctx, int max_players)
     int clamped_max = max_players > 0 && max_players <= MAX_PLAYERS ? max_players : MAX_PLAYERS;
     ctx->max_players = clamped_max;
 
-    net_mutex_lock(&ctx->state_mutex);
     memset(&ctx->game_state, 0, sizeof(GameState));
     ctx->game_state.turn.current_player_id = -1;
     ctx->game_state.turn.turn_number = 0;
     ctx->game_state.host_player_id = -1;
     ctx->game_state.winner_id = -1;
-    net_mutex_unlock(&ctx->state_mutex);
+    memset(ctx->resume_slots, 0, sizeof(ctx->resume_slots));
+    ctx->away_deadline_us = 0;
+    server_publish_snapshot(ctx);
 
     server_on_init(ctx);
     server_on_initialized(ctx, clamped_max);
     return 0;
 }
 
+// Choose how to treat a client whose outbox is full
+void server_set_slow_consumer_policy(ServerContext *ctx, NetOutboxPolicy policy)
+{
+    if (!ctx)
+        return;
+    // Read under any one player mutex; a rare change takes them all, in order
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        net_profiled_mutex_lock(&ctx->player_mutexes[i]);
+    }
+    ctx->slow_consumer_policy = policy;
+    for (int i = MAX_PLAYERS - 1; i >= 0; --i)
+    {
+        net_profiled_mutex_unlock(&ctx->player_mutexes[i]);
+    }
+}
+
+// Choose how many event loop threads the next server_start runs
+void server_set_io_threads(ServerContext *ctx, int count)
+{
+    if (!ctx || ctx->running)
+        return;
+    if (count < 1)
+        count = 1;
+    if (count > SERVER_MAX_IO_THREADS)
+        count = SERVER_MAX_IO_THREADS;
+    ctx->io_thread_count = count;
+}
+
+// Choose the reactor backend for the next server_start
+void server_set_io_backend(ServerContext *ctx, NetReactorBackend backend)
+{
+    if (!ctx || ctx->running)
+        return;
+    ctx->io_backend = backend;
+}
+
+// Choose the ping interval and silence timeout for the next server_start
+void server_set_heartbeat(ServerContext *ctx, int interval_ms, int timeout_ms)
+{
+    if (!ctx || ctx->running)
+        return;
+    ctx->heartbeat_interval_ms = interval_ms > 0 ? interval_ms : 0;
+    ctx->heartbeat_timeout_ms = timeout_ms > 0 ? timeout_ms : 0;
+}
+
+// Choose how long a dropped player's slot waits for a resume. Safe while the
+// server runs: the game thread reads it at each disconnect.
+void server_set_resume_grace(ServerContext *ctx, int grace_ms)
+{
+    if (!ctx)
+        return;
+    server_set_flag(&ctx->resume_grace_ms, grace_ms > 0 ? grace_ms : 0);
+}
+
+// Limits that an honest client, even a bot playing at full speed against a
+// human-paced server, stays well under. Clients never send the other types.
+static void server_default_rate_limits(ServerContext *ctx)
+{
+    ctx->connection_limit.rate_per_sec = 100;
+    ctx->connection_limit.burst = 200;
+    for (int type = 0; type < EVENT_TYPE_COUNT; ++type)
+    {
+        ctx->event_limits[type].rate_per_sec = 2;
+        ctx->event_limits[type].burst = 5;
+    }
+    ctx->event_limits[EVENT_USER_ACTION].rate_per_sec = 20;
+    ctx->event_limits[EVENT_USER_ACTION].burst = 40;
+    ctx->event_limits[EVENT_STATE_RESYNC_REQUEST].rate_per_sec = 5;
+    ctx->event_limits[EVENT_STATE_RESYNC_REQUEST].burst = 10;
+    ctx->event_limits[EVENT_PING].rate_per_sec = 10;
+    ctx->event_limits[EVENT_PING].burst = 20;
+    ctx->event_limits[EVENT_PONG].rate_per_sec = 10;
+    ctx->event_limits[EVENT_PONG].burst = 20;
+}
+
+// Limit how fast each connection may send one event type (EVENT_UNKNOWN: all events)
+void server_set_rate_limit(ServerContext *ctx, EventType type, unsigned int rate_per_sec, unsigned int burst)
+{
+    if (!ctx || ctx->running || (int)type < 0 || (int)type >= EVENT_TYPE_COUNT)
+        return;
+    NetRateLimit *limit = type == EVENT_UNKNOWN ? &ctx->connection_limit : &ctx->event_limits[type];
+    limit->rate_per_sec = rate_per_sec;
+    limit->burst = burst > 0 ? burst : 1;
+}
+
+static unsigned long server_read_count(volatile long *counter)
+{
+#if defined(_MSC_VER)
+    return (unsigned long)InterlockedCompareExchange(counter, 0, 0);
+#else
+    return (unsigned long)__atomic_load_n(counter, __ATOMIC_RELAXED);
+#endif
+}
+
+// Copy the admission counters
+void server_get_admission_stats(ServerContext *ctx, ServerAdmissionStats *out_stats)
+{
+    if (!out_stats)
+        return;
+    memset(out_stats, 0, sizeof(*out_stats));
+    if (!ctx)
+        return;
+    for (int type = 0; type < EVENT_TYPE_COUNT; ++type)
+    {
+        out_stats->throttled[type] = server_read_count(&ctx->throttled_events[type]);
+    }
+    out_stats->dropped = server_read_count(&ctx->dropped_events);
+    out_stats->disconnected = server_read_count(&ctx->flood_disconnects);
+}
+
+// Choose how many unaccepted connections each listener queues for the next server_start
+void server_set_listen_backlog(ServerContext *ctx, int backlog)
+{
+    if (!ctx || ctx->running)
+        return;
+    ctx->listen_backlog = backlog > 0 ? backlog : NET_LISTEN_BACKLOG;
+}
+
+int server_set_directory(ServerContext *ctx, const char *directory)
+{
+    if (!ctx || ctx->running)
+        return -1;
+    if (!directory || directory[0] == '\0')
+    {
+        ctx->has_directory = 0;
+        return 0;
+    }
+    if (net_directory_resolve(directory, &ctx->directory_addr) != 0)
+    {
+        ctx->has_directory = 0;
+        return -1;
+    }
+    ctx->has_directory = 1;
+    return 0;
+}
+
+int server_get_peer_rtt(ServerContext *ctx, int player_id, NetRttStats *out_stats)
+{
+    if (!ctx || !out_stats || player_id < 0 || player_id >= MAX_PLAYERS)
+        return -1;
+
+    ServerSnapshot snapshot;
+    server_read_snapshot(ctx, &snapshot);
+    *out_stats = snapshot.peer_rtt[player_id];
+    return snapshot.game_state.players[player_id].is_active ? 0 : -1;
+}
+
+const char *server_get_io_backend_name(const ServerContext *ctx)
+{
+    if (!ctx || !ctx->running || !ctx->io_threads)
+        return NULL;
+    return net_reactor_backend(ctx->io_threads[0].reactor);
+}
+
+// Tear down the I/O threads created so far, then the game thread, which may
+// still use their reactors (server must no longer be running)
+static void server_stop_io_threads(ServerContext *ctx, int started)
+{
+    for (int i = 0; i < started; ++i)
+    {
+        net_reactor_wake(ctx->io_threads[i].reactor);
+    }
+    for (int i = 0; i < started; ++i)
+    {
+        net_thread_join(ctx->io_threads[i].thread);
+    }
+    server_stop_game_thread(ctx);
+    // Cancel the multishot accept and discovery watch before the sockets close
+    net_reactor_remove(ctx->io_threads[0].reactor, ctx->server_socket);
+    net_reactor_remove(ctx->io_threads[0].reactor, ctx->discovery_socket);
+    for (int i = 0; i < ctx->io_thread_count; ++i)
+    {
+        ServerIoThread *io = &ctx->io_threads[i];
+        if (io->listen_socket != NET_INVALID_SOCKET)
+        {
+            net_reactor_remove(io->reactor, io->listen_socket);
+            shutdown(io->listen_socket, NET_SHUT_RDWR);
+            net_close_socket(io->listen_socket);
+            io->listen_socket = NET_INVALID_SOCKET;
+        }
+        // Connections handed over but never adopted
+        while (io->incoming)
+        {
+            ServerConnection *conn = io->incoming;
+            io->incoming = conn->next;
+            net_close_socket(conn->sock);
+            free(conn);
+        }
+        while (io->closed)
+        {
+            ServerConnection *conn = io->closed;
+            io->closed = conn->next;
+            net_close_socket(conn->sock);
+            free(conn);
+        }
+        net_reactor_destroy(io->reactor);
+        net_mutex_destroy(&io->incoming_mutex);
+    }
+    free(ctx->io_threads);
+    ctx->io_threads = NULL;
+}
+
 // Start the server and begin accepting clients
 void server_start(ServerContext *ctx)
 {
@@ -83,32 +328,95 @@ void server_start(ServerContext *ctx)
         return;
 
     server_on_starting(ctx, DEFAULT_PORT);
-    ctx->server_socket = net_create_server_socket(DEFAULT_PORT);
+    // Several I/O threads each get their own listener on the shared port where
+    // the platform allows it, so a join storm is accepted in parallel
+    int reuse_port = ctx->io_thread_count > 1;
+    ctx->server_socket = net_create_listen_socket(DEFAULT_PORT, ctx->listen_backlog, reuse_port);
+    if (ctx->server_socket == NET_INVALID_SOCKET && reuse_port)
+    {
+        reuse_port = 0;
+        ctx->server_socket = net_create_listen_socket(DEFAULT_PORT, ctx->listen_backlog, 0);
+    }
     if (ctx->server_socket == NET_INVALID_SOCKET)
     {
         server_on_start_failed(ctx, "Failed to create socket");
         return;
     }
+    net_set_nonblocking(ctx->server_socket);
 
-    ctx->running = 1;
+    ctx->io_threads = (ServerIoThread *)calloc((size_t)ctx->io_thread_count, sizeof(ServerIoThread));
+    if (!ctx->io_threads)
+    {
+        server_on_start_failed(ctx, "Out of memory");
+        net_close_socket(ctx->server_socket);
+        ctx->server_socket = NET_INVALID_SOCKET;
+        return;
+    }
+    NetReactorBackend backend = ctx->io_backend;
+    for (int i = 0; i < ctx->io_thread_count; ++i)
+    {
+        ctx->io_threads[i].ctx = ctx;
+        ctx->io_threads[i].index = i;
+        ctx->io_threads[i].listen_socket = NET_INVALID_SOCKET;
+        ctx->io_threads[i].reactor = net_reactor_create_backend(backend);
+        if (!ctx->io_threads[i].reactor && backend != NET_REACTOR_BACKEND_DEFAULT && i == 0)
+        {
+            fprintf(stderr, "[Server] Warning: io_uring unavailable, using the default I/O backend.\n");
+            backend = NET_REACTOR_BACKEND_DEFAULT;
+            ctx->io_threads[i].reactor = net_reactor_create_backend(backend);
+        }
+        net_mutex_init(&ctx->io_threads[i].incoming_mutex);
+        if (!ctx->io_threads[i].reactor)
+        {
+            server_on_io_threads_failed(ctx, "Failed to create reactor");
+            ctx->io_thread_count = i + 1;
+            server_stop_io_threads(ctx, 0);
+            ctx->io_thread_count = 1;
+            net_close_socket(ctx->server_socket);
+            ctx->server_socket = NET_INVALID_SOCKET;
+            return;
+        }
+    }
 
+    server_watch_listener(&ctx->io_threads[0], ctx->server_socket, &ctx->server_socket);
+    ctx->acceptor_count = 1;
+    if (reuse_port)
+    {
+        server_open_acceptors(ctx);
+    }
     if (server_start_discovery_service(ctx) != 0)
     {
         fprintf(stderr, "[Server] Warning: LAN discovery responder unavailable.\n");
     }
-
-    if (net_thread_create(&ctx->accept_thread, server_accept_thread, ctx) != 0)
+    ctx->next_io_thread = 0;
+    server_publish_snapshot(ctx);
+    if (server_start_game_thread(ctx) != 0)
     {
-        server_on_accept_thread_failed(ctx, "Failed to create accept thread");
-        ctx->running = 0;
+        server_on_io_threads_failed(ctx, "Failed to create game thread");
+        server_stop_io_threads(ctx, 0);
+        server_stop_discovery_service(ctx);
         net_close_socket(ctx->server_socket);
         ctx->server_socket = NET_INVALID_SOCKET;
-        server_stop_discovery_service(ctx);
+        return;
     }
-    else
+    ctx->running = 1;
+
+    for (int i = 0; i < ctx->io_thread_count; ++i)
     {
-        server_on_started(ctx, DEFAULT_PORT);
+        if (net_thread_create(&ctx->io_threads[i].thread, server_io_thread, &ctx->io_threads[i]) != 0)
+        {
+            server_on_io_threads_failed(ctx, "Failed to create I/O thread");
+            ctx->running = 0;
+            server_stop_io_threads(ctx, i);
+            server_stop_discovery_service(ctx);
+            net_close_socket(ctx->server_socket);
+            ctx->server_socket = NET_INVALID_SOCKET;
+            return;
+        }
     }
+
+    server_on_io_threads_started(ctx, ctx->io_thread_count, net_reactor_backend(ctx->io_threads[0].reactor));
+    server_on_started(ctx, DEFAULT_PORT);
 }
 
 // Stop the server and disconnect all clients
@@ -120,31 +428,32 @@ void server_stop(ServerContext *ctx)
     server_on_stopping(ctx);
     ctx->running = 0;
 
+    // Each I/O thread closes its own connections on the way out and hands
+    // them to the game thread, which frees them before it stops
+    if (ctx->io_threads)
+    {
+        server_stop_io_threads(ctx, ctx->io_thread_count);
+    }
+
     server_stop_discovery_service(ctx);
 
     if (ctx->server_socket != NET_INVALID_SOCKET)
     {
+        // io_uring may release its reference later; shutdown stops listening right away
+        shutdown(ctx->server_socket, NET_SHUT_RDWR);
         net_close_socket(ctx->server_socket);
         ctx->server_socket = NET_INVALID_SOCKET;
     }
 
-    if (ctx->accept_thread)
-    {
-        net_thread_join(ctx->accept_thread);
-        ctx->accept_thread = 0;
-    }
-
-    net_mutex_lock(&ctx->state_mutex);
     for (int i = 0; i < MAX_PLAYERS; ++i)
     {
-        if (ctx->player_sockets[i] != NET_INVALID_SOCKET)
-        {
-            net_close_socket(ctx->player_sockets[i]);
-            ctx->player_sockets[i] = NET_INVALID_SOCKET;
-            ctx->game_state.players[i].is_active = 0;
-            ctx->game_state.players[i].is_connected = 0;
-        }
+        // Players waiting to resume hold no socket but still own their slot
+        ctx->player_sockets[i] = NET_INVALID_SOCKET;
+        ctx->game_state.players[i].is_active = 0;
+        ctx->game_state.players[i].is_connected = 0;
     }
+    memset(ctx->resume_slots, 0, sizeof(ctx->resume_slots));
+    ctx->away_deadline_us = 0;
     ctx->game_state.player_count = 0;
     ctx->game_state.match_started = 0;
     ctx->game_state.host_player_id = -1;
@@ -152,7 +461,7 @@ void server_stop(ServerContext *ctx)
     ctx->game_state.winner_id = -1;
     ctx->game_state.turn.current_player_id = -1;
     ctx->game_state.turn.turn_number = 0;
-    net_mutex_unlock(&ctx->state_mutex);
+    server_publish_snapshot(ctx);
 }
 
 static int server_start_discovery_service(ServerContext *ctx)
@@ -193,12 +502,23 @@ static int server_start_discovery_service(ServerContext *ctx)
         return -1;
     }
 
-    if (net_thread_create(&ctx->discovery_thread, server_discovery_thread, ctx) != 0)
+    // Probes are answered by I/O thread 0 alongside TCP traffic, and the same
+    // socket carries the beacons and directory heartbeats. Without multicast,
+    // probes still work.
+    net_set_nonblocking(ctx->discovery_socket);
+    int multicast = net_beacon_configure_sender(ctx->discovery_socket) == 0;
+    if (multicast || ctx->has_directory)
     {
-        fprintf(stderr, "[Server] Failed to start discovery thread.\n");
+        ctx->beacon_enabled = 1;
+        ctx->beacon_multicast = multicast;
+        ctx->beacon_player_count = -1;
+        ctx->next_beacon_us = net_monotonic_us();
+    }
+    if (net_reactor_add(ctx->io_threads[0].reactor, ctx->discovery_socket, NET_REACTOR_READ, &ctx->discovery_socket) != 0)
+    {
+        fprintf(stderr, "[Server] Failed to register discovery socket.\n");
         net_close_socket(ctx->discovery_socket);
         ctx->discovery_socket = NET_INVALID_SOCKET;
-        ctx->discovery_thread = 0;
         return -1;
     }
 
@@ -210,44 +530,111 @@ static void server_stop_discovery_service(ServerContext *ctx)
     if (!ctx)
         return;
 
+    ctx->beacon_enabled = 0;
     if (ctx->discovery_socket != NET_INVALID_SOCKET)
     {
+        if (ctx->has_directory)
+        {
+            // Leave the directory now rather than when the heartbeats time out
+            char leave[64];
+            int length = snprintf(leave, sizeof(leave), "%s %d", ARMADA_DIRECTORY_LEAVE, DEFAULT_PORT);
+            sendto(ctx->discovery_socket, leave, length, 0, (const struct sockaddr *)&ctx->directory_addr,
+                   sizeof(ctx->directory_addr));
+        }
         net_close_socket(ctx->discovery_socket);
         ctx->discovery_socket = NET_INVALID_SOCKET;
     }
+}
+
+// Phase shown to browsing clients (game thread only)
+static LobbyPhase server_lobby_phase(ServerContext *ctx)
+{
+    if (ctx->game_state.match_started)
+        return LOBBY_PHASE_IN_MATCH;
+    if (ctx->game_state.is_game_over)
+        return LOBBY_PHASE_GAME_OVER;
+    return LOBBY_PHASE_WAITING;
+}
+
+// Beacon and probe reply text: "<prefix> <port> <players> <max> <id> <phase> <wire version>"
+static size_t server_format_announcement(ServerContext *ctx, const char *prefix, int player_count, LobbyPhase phase, char *out, size_t out_size)
+{
+    int length = snprintf(out, out_size, "%s %d %d %d %u %d %d", prefix, DEFAULT_PORT, player_count, ctx->max_players,
+                          (unsigned int)ctx->server_id, (int)phase, ARMADA_WIRE_VERSION);
+    return length > 0 ? strlen(out) : 0;
+}
+
+// Send the next beacon right away, e.g. when the player count or phase changed.
+// Thread 0 is told once the change is in the published snapshot (game thread).
+static void server_announce_change(ServerContext *ctx)
+{
+    ctx->announce_pending = 1;
+}
+
+// Announce the server on the beacon group and to the directory when one is due
+// (runs on I/O thread 0). The text only changes with the player count and phase,
+// so it is rebuilt just then.
+static void server_send_beacon(ServerContext *ctx, uint64_t now_us)
+{
+    if (!ctx->beacon_enabled)
+        return;
+    if (!server_take_flag(&ctx->beacon_due) && now_us < ctx->next_beacon_us)
+        return;
+    ctx->next_beacon_us = now_us + (uint64_t)NET_BEACON_INTERVAL_MS * 1000ULL;
 
-    if (ctx->discovery_thread)
+    ServerSnapshot snapshot;
+    server_read_snapshot(ctx, &snapshot);
+    int player_count = snapshot.game_state.player_count;
+    LobbyPhase phase = snapshot.phase;
+
+    if (player_count != ctx->beacon_player_count || (int)phase != ctx->beacon_phase || ctx->beacon_length == 0)
+    {
+        ctx->beacon_length = server_format_announcement(ctx, ARMADA_BEACON, player_count, phase, ctx->beacon, sizeof(ctx->beacon));
+        ctx->heartbeat_length = server_format_announcement(ctx, ARMADA_DIRECTORY_REGISTER, player_count, phase,
+                                                           ctx->heartbeat, sizeof(ctx->heartbeat));
+        ctx->beacon_player_count = player_count;
+        ctx->beacon_phase = (int)phase;
+    }
+    if (ctx->beacon_multicast)
+    {
+        net_beacon_send(ctx->discovery_socket, ctx->beacon, ctx->beacon_length);
+    }
+    if (ctx->has_directory)
     {
-        net_thread_join(ctx->discovery_thread);
-        ctx->discovery_thread = 0;
+        net_io_count(NET_IO_WRITE);
+        sendto(ctx->discovery_socket, ctx->heartbeat, (int)ctx->heartbeat_length, 0,
+               (const struct sockaddr *)&ctx->directory_addr, sizeof(ctx->directory_addr));
     }
 }
 
-static void *server_discovery_thread(void *arg)
+// Probes answered per sendmmsg() batch
+#define SERVER_DISCOVERY_BATCH 16
+
+// Answer every pending discovery probe (runs on I/O thread 0).
+// Replies are collected and sent in batches with one system call each.
+static void server_answer_discovery(ServerContext *ctx)
 {
-    ServerContext *ctx = (ServerContext *)arg;
-    while (ctx && ctx->running)
+    NetDatagram replies[SERVER_DISCOVERY_BATCH];
+    size_t reply_count = 0;
+    char response[128];
+    size_t response_length = 0;
+
+    for (;;)
     {
         struct sockaddr_in client_addr;
         socklen_t addrlen = sizeof(client_addr);
         char buffer[128];
+        net_io_count(NET_IO_READ);
         ssize_t bytes = recvfrom(ctx->discovery_socket, buffer, sizeof(buffer) - 1, 0, (struct sockaddr *)&client_addr, &addrlen);
         if (bytes < 0)
         {
-            if (!ctx->running)
-            {
-                break;
-            }
             int last_error = NET_ERRNO();
             if (last_error == NET_EINTR)
             {
                 continue;
             }
-            if (last_error == NET_EBADF)
-            {
-                break;
-            }
-            continue;
+            // EAGAIN: drained until the next edge. Anything else is not fatal for a datagram socket.
+            break;
         }
 
         buffer[bytes] = '\0';
@@ -256,148 +643,753 @@ static void *server_discovery_thread(void *arg)
             continue;
         }
 
-        int player_count = 0;
-        net_mutex_lock(&ctx->state_mutex);
-        player_count = ctx->game_state.player_count;
-        net_mutex_unlock(&ctx->state_mutex);
+        if (response_length == 0)
+        {
+            // Every reply in this drain carries the same player count and phase
+            ServerSnapshot snapshot;
+            server_read_snapshot(ctx, &snapshot);
+            response_length = server_format_announcement(ctx, ARMADA_DISCOVERY_RESPONSE, snapshot.game_state.player_count,
+                                                         snapshot.phase, response, sizeof(response));
+        }
 
-        char response[128];
-        snprintf(response, sizeof(response), "%s %d %d %d", ARMADA_DISCOVERY_RESPONSE, DEFAULT_PORT, player_count, ctx->max_players);
-        sendto(ctx->discovery_socket, response, strlen(response), 0, (struct sockaddr *)&client_addr, addrlen);
+        replies[reply_count].addr = client_addr;
+        replies[reply_count].data = response;
+        replies[reply_count].length = response_length;
+        if (++reply_count == SERVER_DISCOVERY_BATCH)
+        {
+            net_send_datagrams(ctx->discovery_socket, replies, reply_count);
+            reply_count = 0;
+        }
     }
 
-    return NULL;
+    if (reply_count > 0)
+    {
+        net_send_datagrams(ctx->discovery_socket, replies, reply_count);
+    }
 }
 
-// Accept thread: listens for new client connections
-static void *server_accept_thread(void *arg)
+// Let the reactor accept by itself when it can (io_uring multishot accept)
+static void server_watch_listener(ServerIoThread *io, net_socket_t listen_sock, void *userdata)
 {
-    ServerContext *ctx = (ServerContext *)arg;
-    struct sockaddr_in address;
-    socklen_t addrlen = sizeof(address);
-
-    server_on_accept_thread_started(ctx);
-
-    while (ctx->running)
+    if (net_reactor_accept(io->reactor, listen_sock, userdata) != 0)
     {
-        // Use select with timeout to allow clean shutdown on all platforms
-        fd_set readfds;
-        FD_ZERO(&readfds);
-        FD_SET(ctx->server_socket, &readfds);
+        net_reactor_add(io->reactor, listen_sock, NET_REACTOR_READ, userdata);
+    }
+}
 
-        struct timeval tv;
-        tv.tv_sec = 0;
-        tv.tv_usec = 500000; // 500ms timeout
+// Give every I/O thread past the first its own SO_REUSEPORT listener. If any
+// cannot be opened, thread 0 stays the only acceptor.
+static void server_open_acceptors(ServerContext *ctx)
+{
+    for (int i = 1; i < ctx->io_thread_count; ++i)
+    {
+        ServerIoThread *io = &ctx->io_threads[i];
+        io->listen_socket = net_create_listen_socket(DEFAULT_PORT, ctx->listen_backlog, 1);
+        if (io->listen_socket == NET_INVALID_SOCKET)
+        {
+            for (int j = 1; j < i; ++j)
+            {
+                ServerIoThread *opened = &ctx->io_threads[j];
+                net_reactor_remove(opened->reactor, opened->listen_socket);
+                net_close_socket(opened->listen_socket);
+                opened->listen_socket = NET_INVALID_SOCKET;
+            }
+            return;
+        }
+        net_set_nonblocking(io->listen_socket);
+        server_watch_listener(io, io->listen_socket, &io->listen_socket);
+    }
+    ctx->acceptor_count = ctx->io_thread_count;
+}
 
-#if defined(_WIN32)
-        int ready = select(0, &readfds, NULL, NULL, &tv);
-#else
-        int ready = select((int)(ctx->server_socket + 1), &readfds, NULL, NULL, &tv);
-#endif
-        if (ready < 0)
+// Accept every pending connection on one of this thread's listeners
+static void server_accept_connections(ServerIoThread *io, net_socket_t listen_sock)
+{
+    ServerContext *ctx = io->ctx;
+    for (;;)
+    {
+        net_io_count(NET_IO_READ);
+        net_socket_t new_socket = net_accept_nonblocking(listen_sock);
+        if (new_socket == NET_INVALID_SOCKET)
         {
             int last_error = NET_ERRNO();
             if (last_error == NET_EINTR)
                 continue;
-            if (!ctx->running)
-                break;
-            net_log_socket_error("select");
-            break;
+            if (last_error != NET_EAGAIN && last_error != NET_EWOULDBLOCK && ctx->running)
+                net_log_socket_error("accept");
+            return;
         }
-        if (ready == 0)
+        server_take_connection(io, new_socket);
+    }
+}
+
+// A server whose slots are all held by connected players has no room for anyone.
+// Away players keep their slot but may be about to resume, so they leave it open.
+static int server_is_full(ServerContext *ctx)
+{
+    ServerSnapshot snapshot;
+    server_read_snapshot(ctx, &snapshot);
+    return snapshot.game_state.player_count >= snapshot.max_players && !snapshot.has_away_players;
+}
+
+// Turn a connection away before anything is allocated for it. The joiner still
+// reads the same "Server full" ack a late join request would have earned.
+static void server_reject_connection(ServerContext *ctx, net_socket_t sock)
+{
+    GameEvent ack_event;
+    memset(&ack_event, 0, sizeof(GameEvent));
+    ack_event.type = EVENT_PLAYER_JOIN_ACK;
+    ack_event.timestamp = time(NULL);
+    ack_event.data.join_ack.player_id = -1;
+    ack_event.data.join_ack.host_player_id = -1;
+    snprintf(ack_event.data.join_ack.message, sizeof(ack_event.data.join_ack.message), "Server full");
+
+    unsigned char frame[NET_FRAME_MAX_SIZE];
+    size_t frame_size = net_encode_event(&ack_event, frame, sizeof(frame));
+    if (frame_size > 0)
+    {
+        // A fresh socket always has room for one small frame
+        net_io_count(NET_IO_WRITE);
+        send(sock, (const char *)frame, (int)frame_size, NET_MSG_NOSIGNAL);
+    }
+    net_close_socket(sock);
+    server_on_connection_rejected(ctx, "Server full");
+}
+
+// Set up an accepted socket and hand it to an I/O thread. With one listener
+// thread 0 accepts and deals connections round robin; with a listener per
+// thread each one keeps what it accepted.
+static void server_take_connection(ServerIoThread *acceptor, net_socket_t new_socket)
+{
+    ServerContext *ctx = acceptor->ctx;
+    if (server_is_full(ctx))
+    {
+        server_reject_connection(ctx, new_socket);
+        return;
+    }
+
+    // Enable TCP_NODELAY to reduce latency (disable Nagle's algorithm)
+    int nodelay = 1;
+    setsockopt(new_socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay, sizeof(nodelay));
+
+    ServerConnection *conn = (ServerConnection *)calloc(1, sizeof(ServerConnection));
+    if (!conn)
+    {
+        net_close_socket(new_socket);
+        return;
+    }
+    conn->sock = new_socket;
+    net_recv_buffer_reset(&conn->recv_buffer);
+
+    server_on_client_connected(ctx, new_socket);
+
+    ServerIoThread *target = acceptor;
+    if (ctx->acceptor_count == 1)
+    {
+        target = &ctx->io_threads[ctx->next_io_thread];
+        ctx->next_io_thread = (ctx->next_io_thread + 1) % ctx->io_thread_count;
+    }
+
+    net_mutex_lock(&target->incoming_mutex);
+    conn->next = target->incoming;
+    target->incoming = conn;
+    net_mutex_unlock(&target->incoming_mutex);
+    if (target != acceptor)
+    {
+        net_reactor_wake(target->reactor);
+    }
+}
+
+// Register connections handed over by the acceptor with this thread's reactor
+static void server_adopt_connections(ServerIoThread *io)
+{
+    ServerContext *ctx = io->ctx;
+    net_mutex_lock(&io->incoming_mutex);
+    ServerConnection *pending = io->incoming;
+    io->incoming = NULL;
+    net_mutex_unlock(&io->incoming_mutex);
+
+    while (pending)
+    {
+        ServerConnection *conn = pending;
+        pending = conn->next;
+
+        conn->owner = io;
+        conn->last_heard_us = net_monotonic_us();
+        conn->last_ping_us = conn->last_heard_us;
+        net_token_bucket_reset(&conn->total_bucket, &ctx->connection_limit, conn->last_heard_us);
+        for (int type = 0; type < EVENT_TYPE_COUNT; ++type)
         {
-            // Timeout - check if we should still be running
-            continue;
+            net_token_bucket_reset(&conn->event_buckets[type], &ctx->event_limits[type], conn->last_heard_us);
         }
+        conn->prev = NULL;
+        conn->next = io->connections;
+        if (io->connections)
+            io->connections->prev = conn;
+        io->connections = conn;
 
-        addrlen = sizeof(address);
-        net_socket_t new_socket = accept(ctx->server_socket, (struct sockaddr *)&address, &addrlen);
-        if (new_socket == NET_INVALID_SOCKET)
+        if (net_reactor_recv(io->reactor, conn->sock, conn) == 0)
         {
-            if (ctx->running)
-                net_log_socket_error("accept");
+            conn->streaming = 1;
+            continue;
+        }
+        if (net_reactor_add(io->reactor, conn->sock, NET_REACTOR_READ, conn) != 0)
+        {
+            server_close_connection(io, conn, 1);
             continue;
         }
+        // Bytes that arrived before registration raise no edge
+        server_read_connection(io, conn);
+    }
+}
 
-        // Enable TCP_NODELAY to reduce latency (disable Nagle's algorithm)
-        int nodelay = 1;
-        setsockopt(new_socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&nodelay, sizeof(nodelay));
+// Several I/O threads may refuse events at once
+static void server_count(volatile long *counter)
+{
+#if defined(_MSC_VER)
+    InterlockedIncrement(counter);
+#else
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+// Admission control, run before an event reaches the game thread.
+// Returns 1 to handle the event and 0 to discard it. A connection that keeps
+// sending past its overall limit for a whole burst is closed, and its player
+// removed without a resume grace period.
+static int server_admit_event(ServerIoThread *io, ServerConnection *conn, const GameEvent *event)
+{
+    ServerContext *ctx = io->ctx;
+    uint64_t now_us = conn->last_heard_us;
 
-        server_on_client_connected(ctx, new_socket);
+    if (!net_token_bucket_take(&conn->total_bucket, &ctx->connection_limit, now_us))
+    {
+        server_count(&ctx->dropped_events);
+        if (++conn->flood_drops < ctx->connection_limit.burst)
+            return 0;
 
-        // Create a thread for this client
-        ClientThreadArgs *args = malloc(sizeof(ClientThreadArgs));
-        args->ctx = ctx;
-        args->socket_fd = new_socket;
+        server_count(&ctx->flood_disconnects);
+        server_on_flood_disconnect(ctx, conn->sock, conn->flood_drops);
+        conn->forfeit_resume = 1;
+        server_close_connection(io, conn, 1);
+        return 0;
+    }
+    conn->flood_drops = 0;
 
-        net_thread_t tid;
-        if (net_thread_create(&tid, server_client_thread, args) != 0)
+    int type = (int)event->type;
+    if (type >= 0 && type < EVENT_TYPE_COUNT &&
+        !net_token_bucket_take(&conn->event_buckets[type], &ctx->event_limits[type], now_us))
+    {
+        server_count(&ctx->throttled_events[type]);
+        return 0;
+    }
+    return 1;
+}
+
+// Pass every complete frame buffered for a connection to the game thread.
+// Returns 0, or -1 after closing the connection on a malformed frame.
+static int server_drain_frames(ServerIoThread *io, ServerConnection *conn)
+{
+    ServerCommand command;
+    command.type = SERVER_COMMAND_EVENT;
+    command.conn = conn;
+    command.received_us = conn->last_heard_us;
+    int popped;
+    while (!conn->closed && (popped = net_recv_buffer_pop(&conn->recv_buffer, &command.event)) > 0)
+    {
+        if (server_admit_event(io, conn, &command.event))
+            server_submit_command(io->ctx, &command);
+    }
+    if (conn->closed)
+        return -1;
+    if (popped < 0)
+    {
+        server_close_connection(io, conn, 1);
+        return -1;
+    }
+    return 0;
+}
+
+// Bytes delivered by the reactor for a streaming connection
+static void server_receive_data(ServerIoThread *io, ServerConnection *conn, const unsigned char *data, size_t length)
+{
+    conn->last_heard_us = net_monotonic_us();
+    if (net_recv_buffer_append(&conn->recv_buffer, data, length) != 0)
+    {
+        server_close_connection(io, conn, 1);
+        return;
+    }
+    server_drain_frames(io, conn);
+}
+
+// Read until the socket would block, handling every complete frame.
+// Closes the connection on EOF, error or a malformed frame.
+static void server_read_connection(ServerIoThread *io, ServerConnection *conn)
+{
+    for (;;)
+    {
+        if (server_drain_frames(io, conn) != 0)
+            return;
+
+        int filled = net_recv_buffer_fill(conn->sock, &conn->recv_buffer);
+        if (filled == 0)
         {
-            server_on_accept_thread_failed(ctx, "Failed to create client thread");
-            free(args);
-            net_close_socket(new_socket);
+            return; // Drained; wait for the next edge
         }
-        else
+        if (filled < 0)
         {
-            net_thread_detach(tid); // Detach so we don't have to join
+            server_close_connection(io, conn, 1);
+            return;
         }
+        conn->last_heard_us = net_monotonic_us();
     }
-    return NULL;
 }
 
-// Client thread: handles communication with a single client
-static void *server_client_thread(void *arg)
+// Unregister and stop writing. The connection goes to the game thread after
+// the current batch, which may still reference it; the game thread releases
+// the player slot, then closes the socket and frees it. Closing the socket
+// there keeps the descriptor from being reused while commands still name it.
+// notify is 0 during shutdown, when nobody is left to tell.
+static void server_close_connection(ServerIoThread *io, ServerConnection *conn, int notify)
 {
-    ClientThreadArgs *args = (ClientThreadArgs *)arg;
-    ServerContext *ctx = args->ctx;
-    net_socket_t sock = args->socket_fd;
-    free(args);
+    ServerContext *ctx = io->ctx;
+    if (conn->closed)
+        return;
+
+    server_detach_outbox(ctx, conn);
+    net_reactor_remove(io->reactor, conn->sock);
+    if (conn->prev)
+        conn->prev->next = conn->next;
+    else if (io->connections == conn)
+        io->connections = conn->next;
+    if (conn->next)
+        conn->next->prev = conn->prev;
+
+    if (notify)
+    {
+        server_on_client_disconnected(ctx, conn->sock);
+    }
+    conn->notify_close = notify;
+    // A pending io_uring receive keeps the socket open past close(); shutdown sends the FIN now
+    if (conn->streaming)
+        shutdown(conn->sock, NET_SHUT_RDWR);
+    conn->closed = 1;
+    conn->prev = NULL;
+    conn->next = io->closed;
+    io->closed = conn;
+}
+
+// Ping every joined connection that is due and close the ones that went silent.
+// A peer that vanished without a FIN would otherwise hold its slot until TCP gives up.
+static void server_check_heartbeats(ServerIoThread *io, uint64_t now_us)
+{
+    ServerContext *ctx = io->ctx;
+    uint64_t interval_us = (uint64_t)ctx->heartbeat_interval_ms * 1000ULL;
+    uint64_t timeout_us = (uint64_t)ctx->heartbeat_timeout_ms * 1000ULL;
+
+    ServerConnection *conn = io->connections;
+    while (conn)
+    {
+        ServerConnection *next = conn->next;
+        uint64_t silent_us = now_us - conn->last_heard_us;
+        if (timeout_us > 0 && silent_us > timeout_us)
+        {
+            server_on_heartbeat_timeout(ctx, conn->sock, (int)(silent_us / 1000ULL));
+            server_close_connection(io, conn, 1);
+        }
+        else if (interval_us > 0 && now_us - conn->last_ping_us >= interval_us)
+        {
+            conn->last_ping_us = now_us;
+            // The game thread knows which player, if any, the connection belongs to
+            ServerCommand command;
+            memset(&command, 0, sizeof(ServerCommand));
+            command.type = SERVER_COMMAND_PING;
+            command.conn = conn;
+            command.received_us = now_us;
+            command.event.type = EVENT_PING;
+            command.event.sender_id = -1;
+            command.event.data.heartbeat.sequence = ++conn->ping_sequence;
+            command.event.data.heartbeat.sent_us = (uint32_t)now_us;
+            server_submit_command(ctx, &command);
+        }
+        conn = next;
+    }
+
+    io->next_heartbeat_us = now_us + (interval_us > 0 ? interval_us : timeout_us);
+}
+
+// Next time this thread has timed work, 0 when it has none and may sleep until
+// a socket or a wake-up needs it. Only thread 0 wakes on an idle server, for beacons.
+static uint64_t server_io_deadline_us(ServerIoThread *io)
+{
+    ServerContext *ctx = io->ctx;
+    uint64_t deadline_us = 0;
+    if (io->connections && (ctx->heartbeat_interval_ms > 0 || ctx->heartbeat_timeout_ms > 0))
+        deadline_us = io->next_heartbeat_us;
+
+    if (io->index == 0 && ctx->beacon_enabled)
+    {
+        // A change to announce is due at once
+        uint64_t beacon_us = server_read_count(&ctx->beacon_due) ? 1 : ctx->next_beacon_us;
+        if (deadline_us == 0 || beacon_us < deadline_us)
+            deadline_us = beacon_us;
+    }
+    return deadline_us;
+}
+
+// Reactor timeout until deadline_us, -1 (forever) when there is none
+static int server_wait_ms(uint64_t deadline_us)
+{
+    if (deadline_us == 0)
+        return -1;
+
+    uint64_t now_us = net_monotonic_us();
+    if (deadline_us <= now_us)
+        return 0;
+    return (int)((deadline_us - now_us + 999ULL) / 1000ULL);
+}
+
+// Hand the connections closed during this batch to the game thread
+static void server_submit_closed_connections(ServerIoThread *io)
+{
+    ServerCommand command;
+    memset(&command, 0, sizeof(ServerCommand));
+    command.type = SERVER_COMMAND_CLOSE;
+    while (io->closed)
+    {
+        ServerConnection *conn = io->closed;
+        io->closed = conn->next;
+        command.conn = conn;
+        server_submit_command(io->ctx, &command);
+    }
+}
+
+// Event loop: one per I/O thread
+static void *server_io_thread(void *arg)
+{
+    ServerIoThread *io = (ServerIoThread *)arg;
+    ServerContext *ctx = io->ctx;
+    NetReactorEvent events[SERVER_IO_BATCH];
 
-    GameEvent event;
     while (ctx->running)
     {
-        // Use timeout-based receive to allow clean shutdown
-        // This allows the thread to periodically check ctx->running
-        int result = net_receive_event_timeout(sock, &event, 500); // 500ms timeout
-        if (result == 0)
+        int count = net_reactor_wait(io->reactor, events, SERVER_IO_BATCH, server_wait_ms(server_io_deadline_us(io)));
+        if (count < 0)
+        {
+            net_log_socket_error("reactor wait");
+            break;
+        }
+        if (!ctx->running)
+            break;
+
+        server_adopt_connections(io);
+        for (int i = 0; i < count; ++i)
         {
-            // Timeout - no data, just loop back and check running flag
+            void *userdata = events[i].userdata;
+            if (userdata == &ctx->server_socket || userdata == &io->listen_socket)
+            {
+                if (events[i].events & NET_REACTOR_ACCEPTED)
+                    server_take_connection(io, events[i].accepted);
+                else
+                    server_accept_connections(io, *(net_socket_t *)userdata);
+                server_adopt_connections(io);
+            }
+            else if (userdata == &ctx->discovery_socket)
+            {
+                server_answer_discovery(ctx);
+            }
+            else
+            {
+                ServerConnection *conn = (ServerConnection *)userdata;
+                if (conn->closed)
+                    continue;
+                if (events[i].events & NET_REACTOR_DATA)
+                    server_receive_data(io, conn, events[i].data, events[i].length);
+                else if (conn->streaming && (events[i].events & NET_REACTOR_HANGUP))
+                    server_close_connection(io, conn, 1);
+                else if (!conn->streaming && (events[i].events & (NET_REACTOR_READ | NET_REACTOR_HANGUP)))
+                    server_read_connection(io, conn);
+            }
+        }
+
+        uint64_t deadline_us = server_io_deadline_us(io);
+        if (deadline_us != 0)
+        {
+            uint64_t now_us = net_monotonic_us();
+            if (now_us >= deadline_us)
+            {
+                if (io->connections && now_us >= io->next_heartbeat_us)
+                    server_check_heartbeats(io, now_us);
+                if (io->index == 0)
+                    server_send_beacon(ctx, now_us);
+            }
+        }
+
+        // Frames queued while handling this batch, and sockets that became writable
+        server_flush_outboxes(ctx);
+        server_submit_closed_connections(io);
+    }
+
+    while (io->connections)
+    {
+        server_close_connection(io, io->connections, 0);
+    }
+    server_submit_closed_connections(io);
+    return NULL;
+}
+
+// Producer and game thread each write one side and read the other; this fence
+// keeps either from reading before its own write is visible
+static void server_full_fence(void)
+{
+#if defined(_MSC_VER)
+    MemoryBarrier();
+#else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+static void server_set_flag(volatile long *flag, long value)
+{
+#if defined(_MSC_VER)
+    InterlockedExchange(flag, value);
+#else
+    __atomic_store_n(flag, value, __ATOMIC_RELAXED);
+#endif
+}
+
+static long server_take_flag(volatile long *flag)
+{
+#if defined(_MSC_VER)
+    return InterlockedExchange(flag, 0);
+#else
+    return __atomic_exchange_n(flag, 0, __ATOMIC_ACQUIRE);
+#endif
+}
+
+// Copy game state for outside readers. Only one thread publishes at a time:
+// the game thread while it runs, otherwise whoever starts or stops the server.
+static void server_publish_snapshot(ServerContext *ctx)
+{
+    long sequence = (long)server_read_count(&ctx->snapshot_sequence);
+    server_set_flag(&ctx->snapshot_sequence, sequence + 1);
+    server_full_fence();
+
+    ServerSnapshot *snapshot = &ctx->snapshot;
+    snapshot->game_state = ctx->game_state;
+    memcpy(snapshot->peer_rtt, ctx->peer_rtt, sizeof(snapshot->peer_rtt));
+    snapshot->max_players = ctx->max_players;
+    snapshot->phase = server_lobby_phase(ctx);
+    snapshot->has_away_players = ctx->away_deadline_us != 0;
+
+    server_full_fence();
+    server_set_flag(&ctx->snapshot_sequence, sequence + 2);
+
+    // The beacon reads the snapshot, so it may go out only now
+    if (ctx->announce_pending)
+    {
+        ctx->announce_pending = 0;
+        if (ctx->beacon_enabled && ctx->io_threads)
+        {
+            server_set_flag(&ctx->beacon_due, 1);
+            net_reactor_wake(ctx->io_threads[0].reactor);
+        }
+    }
+}
+
+// A copy is only kept if the sequence was even and unchanged around it, so a
+// reader never waits on the game thread for more than one copy in progress
+void server_read_snapshot(ServerContext *ctx, ServerSnapshot *out_snapshot)
+{
+    if (!ctx || !out_snapshot)
+        return;
+
+    for (;;)
+    {
+        long before = (long)server_read_count(&ctx->snapshot_sequence);
+        if (before & 1)
+        {
+            net_thread_yield();
             continue;
         }
-        if (result < 0)
+        server_full_fence();
+        *out_snapshot = ctx->snapshot;
+        server_full_fence();
+        if ((long)server_read_count(&ctx->snapshot_sequence) == before)
+            return;
+    }
+}
+
+// Hand a command to the game thread, waking it only if it sleeps. A full queue
+// means the game thread is behind; the I/O thread waits for room rather than
+// drop a command, which would leak a connection or lose a player's action.
+static void server_submit_command(ServerContext *ctx, const ServerCommand *command)
+{
+    while (!net_mpsc_push(ctx->commands, command))
+    {
+        net_thread_yield();
+    }
+    // Either the game thread sees this command before it sleeps, or we see it asleep
+    server_full_fence();
+    if (server_read_count(&ctx->game_sleeping))
+    {
+        net_mutex_lock(&ctx->game_wake_mutex);
+        net_cond_signal(&ctx->game_wake);
+        net_mutex_unlock(&ctx->game_wake_mutex);
+    }
+}
+
+// Sleep until a command arrives or the earliest away deadline passes
+static void server_game_wait(ServerContext *ctx)
+{
+    net_mutex_lock(&ctx->game_wake_mutex);
+    server_set_flag(&ctx->game_sleeping, 1);
+    server_full_fence();
+    if (net_mpsc_empty(ctx->commands))
+    {
+        int timeout_ms = server_wait_ms(ctx->away_deadline_us);
+        if (timeout_ms < 0)
+            net_cond_wait(&ctx->game_wake, &ctx->game_wake_mutex);
+        else if (timeout_ms > 0)
+            net_cond_timedwait(&ctx->game_wake, &ctx->game_wake_mutex, timeout_ms);
+    }
+    server_set_flag(&ctx->game_sleeping, 0);
+    net_mutex_unlock(&ctx->game_wake_mutex);
+}
+
+// Finish closing a connection its I/O thread gave up on. Every command it
+// queued before the close has run, so this is the last mention of it.
+static void server_release_connection(ServerContext *ctx, ServerConnection *conn)
+{
+    if (conn->notify_close && ctx->running)
+    {
+        if (conn->forfeit_resume)
         {
-            server_on_client_disconnected(ctx, sock);
+            int player_id = server_find_player_by_socket(ctx, conn->sock);
+            if (player_id >= 0)
+                ctx->resume_slots[player_id].token = 0;
+        }
+        server_handle_disconnect(ctx, conn->sock);
+    }
+    net_close_socket(conn->sock);
+    free(conn);
+}
+
+// Run one command from an I/O thread. Once the server is stopping only
+// connections are released; nobody is left to see the game move on.
+static void server_run_command(ServerContext *ctx, const ServerCommand *command)
+{
+    ServerConnection *conn = command->conn;
+    switch (command->type)
+    {
+    case SERVER_COMMAND_EVENT:
+        if (!ctx->running)
+            break;
+        if (command->event.type == EVENT_PLAYER_JOIN_REQUEST)
+            server_handle_player_join(ctx, conn, &command->event.data.join_req);
+        else
+            server_handle_event(ctx, conn->sock, &command->event, command->received_us);
+        break;
+    case SERVER_COMMAND_PING:
+    {
+        if (!ctx->running)
             break;
+        int player_id = server_find_player_by_socket(ctx, conn->sock);
+        if (player_id >= 0)
+        {
+            server_queue_event(ctx, player_id, &command->event);
+        }
+        break;
+    }
+    case SERVER_COMMAND_CLOSE:
+        server_release_connection(ctx, conn);
+        break;
+    default:
+        break;
+    }
+}
+
+// Game loop: the only thread that runs game logic. Frames it queues are
+// flushed after each batch of commands, so a burst of events still leaves
+// in a few writes per client.
+static void *server_game_thread(void *arg)
+{
+    ServerContext *ctx = (ServerContext *)arg;
+    ServerCommand command;
+
+    for (;;)
+    {
+        int handled = 0;
+        while (handled < SERVER_GAME_BATCH && net_mpsc_pop(ctx->commands, &command))
+        {
+            if (command.type == SERVER_COMMAND_STOP)
+                return NULL;
+            server_run_command(ctx, &command);
+            ++handled;
         }
 
-        if (event.type == EVENT_PLAYER_JOIN_REQUEST)
+        // Away players are not tied to a connection, so their expiry is timed here
+        if (ctx->away_deadline_us != 0)
         {
-            server_handle_player_join(ctx, sock, &event.data.join_req);
-            continue;
+            uint64_t now_us = net_monotonic_us();
+            if (now_us >= ctx->away_deadline_us && ctx->running)
+            {
+                server_expire_away_players(ctx, now_us);
+                ++handled;
+            }
         }
 
-        server_handle_event(ctx, sock, &event);
+        if (handled > 0)
+        {
+            server_publish_snapshot(ctx);
+            server_flush_outboxes(ctx);
+        }
+        else
+        {
+            server_game_wait(ctx);
+        }
     }
+}
 
-    // Cleanup
-    net_close_socket(sock);
+static int server_start_game_thread(ServerContext *ctx)
+{
+    ctx->commands = net_mpsc_create(SERVER_COMMAND_QUEUE_CAPACITY, sizeof(ServerCommand));
+    if (!ctx->commands)
+        return -1;
+    ctx->game_sleeping = 0;
+    if (net_thread_create(&ctx->game_thread, server_game_thread, ctx) != 0)
+    {
+        net_mpsc_destroy(ctx->commands);
+        ctx->commands = NULL;
+        return -1;
+    }
+    return 0;
+}
 
-    // Remove from player_sockets if present
-    server_handle_disconnect(ctx, sock);
+// Call once the I/O threads are gone: the game thread runs everything they
+// handed over, closing their connections, and exits at the stop command
+static void server_stop_game_thread(ServerContext *ctx)
+{
+    if (!ctx->commands)
+        return;
 
-    return NULL;
+    ServerCommand command;
+    memset(&command, 0, sizeof(ServerCommand));
+    command.type = SERVER_COMMAND_STOP;
+    server_submit_command(ctx, &command);
+    net_thread_join(ctx->game_thread);
+    net_mpsc_destroy(ctx->commands);
+    ctx->commands = NULL;
 }
 
 // Dispatch incoming events to appropriate handlers
-static void server_handle_event(ServerContext *ctx, net_socket_t sender_socket, const GameEvent *event)
+static void server_handle_event(ServerContext *ctx, net_socket_t sender_socket, const GameEvent *event, uint64_t received_us)
 {
     if (!event)
         return;
 
     // Look up the actual player ID from the socket to prevent spoofing
-    net_mutex_lock(&ctx->state_mutex);
     int verified_player_id = server_find_player_by_socket(ctx, sender_socket);
-    net_mutex_unlock(&ctx->state_mutex);
 
     // Create a mutable copy of the event with verified sender_id
     GameEvent verified_event = *event;
@@ -413,16 +1405,61 @@ static void server_handle_event(ServerContext *ctx, net_socket_t sender_socket,
     case EVENT_MATCH_START_REQUEST:
         server_handle_match_start_request(ctx, verified_player_id);
         break;
+    case EVENT_STATE_RESYNC_REQUEST:
+        server_handle_resync_request(ctx, verified_player_id);
+        break;
+    case EVENT_PLAYER_LEFT:
+        server_handle_leave(ctx, verified_player_id);
+        break;
+    case EVENT_PING:
+        server_handle_ping(ctx, verified_player_id, &verified_event.data.heartbeat);
+        break;
+    case EVENT_PONG:
+        server_handle_pong(ctx, verified_player_id, &verified_event.data.heartbeat, received_us);
+        break;
     default:
         server_on_unhandled_event(ctx, verified_event.type);
         break;
     }
 }
 
+// Echo a client's ping so it can measure its own round trip
+static void server_handle_ping(ServerContext *ctx, int player_id, const EventPayload_Heartbeat *ping)
+{
+    if (player_id < 0)
+        return;
+
+    GameEvent pong;
+    memset(&pong, 0, sizeof(GameEvent));
+    pong.type = EVENT_PONG;
+    pong.sender_id = -1;
+    pong.data.heartbeat = *ping;
+    server_send_event_to(ctx, player_id, &pong);
+}
+
+// A client answered one of our pings. The round trip ends when its I/O thread
+// read the answer, not when the game thread got to it.
+static void server_handle_pong(ServerContext *ctx, int player_id, const EventPayload_Heartbeat *pong, uint64_t received_us)
+{
+    if (player_id < 0)
+        return;
+
+    uint32_t rtt_us = (uint32_t)received_us - pong->sent_us;
+    net_rtt_sample(&ctx->peer_rtt[player_id], rtt_us);
+}
+
 // Handle player join requests
-static void server_handle_player_join(ServerContext *ctx, net_socket_t sender_socket, const EventPayload_PlayerJoin *payload)
+static void server_handle_player_join(ServerContext *ctx, ServerConnection *conn, const EventPayload_PlayerJoin *payload)
 {
-    if (!payload || sender_socket == NET_INVALID_SOCKET)
+    if (!payload || !conn || conn->sock == NET_INVALID_SOCKET)
+        return;
+
+    net_socket_t sender_socket = conn->sock;
+    // One slot per connection: a second slot would give the socket a second
+    // outbox, flushed under another player mutex and interleaving its frames
+    if (server_find_player_by_socket(ctx, sender_socket) >= 0)
+        return;
+    if (payload->resume_token != 0 && server_handle_resume(ctx, conn, payload))
         return;
 
     GameEvent ack_event;
@@ -434,11 +1471,15 @@ static void server_handle_player_join(ServerContext *ctx, net_socket_t sender_so
     ack_event.data.join_ack.host_player_id = -1;
     ack_event.data.join_ack.is_host = 0;
 
+    GameEvent lobby_event;
+    memset(&lobby_event, 0, sizeof(GameEvent));
+    lobby_event.type = EVENT_LOBBY_SNAPSHOT;
+    lobby_event.timestamp = ack_event.timestamp;
+
     int host_changed = 0;
     int new_host_id = -1;
     char new_host_name[MAX_NAME_LEN] = {0};
 
-    net_mutex_lock(&ctx->state_mutex);
     int slot = server_find_open_slot(ctx);
     if (slot == -1)
     {
@@ -449,13 +1490,31 @@ static void server_handle_player_join(ServerContext *ctx, net_socket_t sender_so
     {
         server_reset_player(&ctx->game_state.players[slot], slot, payload->player_name);
         ctx->player_sockets[slot] = sender_socket;
+        ctx->viewer_snapshots[slot].needs_keyframe = 1;
+        net_rtt_reset(&ctx->peer_rtt[slot]);
+        ServerResumeSlot *resume = &ctx->resume_slots[slot];
+        resume->token = server_new_resume_token(ctx);
+        resume->deadline_us = 0;
+        net_profiled_mutex_lock(&ctx->roster_mutex);
+        net_profiled_mutex_lock(&ctx->player_mutexes[slot]);
+        // A connection its I/O thread already closed gets no outbox; the
+        // disconnect queued behind this join releases the slot again
+        int attached = !conn->detached;
+        net_outbox_reset(&ctx->outboxes[slot], attached ? sender_socket : NET_INVALID_SOCKET);
+        ctx->slot_connections[slot] = attached ? conn : NULL;
+        conn->write_interest = 0;
+        resume->missed_count = 0;
+        resume->missed_overflow = 0;
+        net_profiled_mutex_unlock(&ctx->player_mutexes[slot]);
+        net_profiled_mutex_unlock(&ctx->roster_mutex);
         server_refresh_player_count(ctx);
         ack_event.data.join_ack.success = 1;
         ack_event.data.join_ack.player_id = slot;
+        ack_event.data.join_ack.resume_token = resume->token;
         snprintf(ack_event.data.join_ack.message, sizeof(ack_event.data.join_ack.message), "Welcome!");
 
         int previous_host = ctx->game_state.host_player_id;
-        new_host_id = server_select_host_locked(ctx);
+        new_host_id = server_select_host(ctx);
         ack_event.data.join_ack.host_player_id = ctx->game_state.host_player_id;
         ack_event.data.join_ack.is_host = (ctx->game_state.host_player_id == slot);
         if (new_host_id != previous_host)
@@ -467,8 +1526,8 @@ static void server_handle_player_join(ServerContext *ctx, net_socket_t sender_so
                 new_host_name[MAX_NAME_LEN - 1] = '\0';
             }
         }
+        server_build_lobby_snapshot(ctx, &lobby_event.data.lobby);
     }
-    net_mutex_unlock(&ctx->state_mutex);
 
     if (!ack_event.data.join_ack.success)
     {
@@ -476,52 +1535,179 @@ static void server_handle_player_join(ServerContext *ctx, net_socket_t sender_so
         return;
     }
 
-    server_send_event_to(ctx, ack_event.data.join_ack.player_id, &ack_event);
+    // The joiner learns the whole lobby from its ack plus one snapshot, queued
+    // together so they leave in the same write as the broadcasts below
+    GameEvent welcome_events[2];
+    welcome_events[0] = ack_event;
+    welcome_events[1] = lobby_event;
+    server_send_events_to(ctx, ack_event.data.join_ack.player_id, welcome_events, 2);
+
+    // Notify all players of new join
+    GameEvent lifecycle;
+    memset(&lifecycle, 0, sizeof(GameEvent));
+    lifecycle.type = EVENT_PLAYER_JOINED;
+    lifecycle.timestamp = time(NULL);
+    lifecycle.data.player_event.player_id = ack_event.data.join_ack.player_id;
+    strncpy(lifecycle.data.player_event.player_name, payload->player_name, MAX_NAME_LEN - 1);
+    server_broadcast_event(ctx, &lifecycle);
+
+    server_broadcast_current_turn(ctx, 0, NULL);
+
+    if (host_changed)
+    {
+        server_emit_host_update(ctx, new_host_id, new_host_name);
+    }
+}
+
+// Describe every occupied slot, the host and the match phase (game thread only)
+static void server_build_lobby_snapshot(ServerContext *ctx, EventPayload_LobbySnapshot *lobby)
+{
+    memset(lobby, 0, sizeof(*lobby));
+    lobby->host_player_id = ctx->game_state.host_player_id;
+    lobby->phase = server_lobby_phase(ctx);
+
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        if (!ctx->game_state.players[i].is_active)
+            continue;
+        lobby->active_mask |= 1u << i;
+        strncpy(lobby->player_names[i], ctx->game_state.players[i].name, MAX_NAME_LEN - 1);
+    }
+}
+
+// Draw a fresh resume token (game thread only).
+// splitmix64 over a seed taken at server_create: unguessable enough for a LAN game.
+static uint64_t server_new_resume_token(ServerContext *ctx)
+{
+    uint64_t token;
+    do
+    {
+        ctx->resume_seed += 0x9E3779B97F4A7C15ULL;
+        token = ctx->resume_seed;
+        token = (token ^ (token >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        token = (token ^ (token >> 27)) * 0x94D049BB133111EBULL;
+        token ^= token >> 31;
+    } while (token == 0);
+    return token;
+}
+
+// Give a returning player its old slot back on the new connection.
+// Returns 1 if the token matched, 0 to treat the request as a fresh join.
+static int server_handle_resume(ServerContext *ctx, ServerConnection *conn, const EventPayload_PlayerJoin *payload)
+{
+    net_socket_t sender_socket = conn->sock;
+
+    GameEvent ack_event;
+    memset(&ack_event, 0, sizeof(GameEvent));
+    ack_event.type = EVENT_PLAYER_JOIN_ACK;
+    ack_event.timestamp = time(NULL);
+    ack_event.data.join_ack.success = 1;
+    ack_event.data.join_ack.resumed = 1;
+    ack_event.data.join_ack.resume_token = payload->resume_token;
+    snprintf(ack_event.data.join_ack.message, sizeof(ack_event.data.join_ack.message), "Welcome back!");
+
+    int host_changed = 0;
+    int new_host_id = -1;
+    char new_host_name[MAX_NAME_LEN] = {0};
+    char name_copy[MAX_NAME_LEN] = {0};
+    int replayed = 0;
+
+    int slot = -1;
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        if (ctx->game_state.players[i].is_active && ctx->resume_slots[i].token == payload->resume_token)
+        {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == -1)
+    {
+        return 0;
+    }
+
+    PlayerState *player = &ctx->game_state.players[slot];
+    ServerResumeSlot *resume = &ctx->resume_slots[slot];
+    strncpy(name_copy, player->name, MAX_NAME_LEN - 1);
+    ctx->player_sockets[slot] = sender_socket;
+    player->is_connected = 1;
+    resume->deadline_us = 0;
+    ctx->viewer_snapshots[slot].needs_keyframe = 1;
+    net_rtt_reset(&ctx->peer_rtt[slot]);
+
+    int previous_host = ctx->game_state.host_player_id;
+    new_host_id = server_select_host(ctx);
+    if (new_host_id != previous_host)
+    {
+        host_changed = 1;
+        if (new_host_id >= 0)
+        {
+            strncpy(new_host_name, ctx->game_state.players[new_host_id].name, MAX_NAME_LEN - 1);
+            new_host_name[MAX_NAME_LEN - 1] = '\0';
+        }
+    }
+    ack_event.data.join_ack.player_id = slot;
+    ack_event.data.join_ack.host_player_id = ctx->game_state.host_player_id;
+    ack_event.data.join_ack.is_host = (ctx->game_state.host_player_id == slot);
+
+    GameEvent lobby_event;
+    memset(&lobby_event, 0, sizeof(GameEvent));
+    lobby_event.type = EVENT_LOBBY_SNAPSHOT;
+    lobby_event.timestamp = ack_event.timestamp;
+    server_build_lobby_snapshot(ctx, &lobby_event.data.lobby);
 
-    // Send existing players info to the new joiner
-    int new_player_id = ack_event.data.join_ack.player_id;
+    unsigned char frame[NET_FRAME_MAX_SIZE];
+    size_t ack_size = net_encode_event(&ack_event, frame, sizeof(frame));
 
-    // Collect existing players while holding the lock
-    GameEvent existing_events[MAX_PLAYERS];
-    int existing_count = 0;
-
-    net_mutex_lock(&ctx->state_mutex);
-    for (int i = 0; i < MAX_PLAYERS; ++i)
+    net_profiled_mutex_lock(&ctx->roster_mutex);
+    net_profiled_mutex_lock(&ctx->player_mutexes[slot]);
+    NetOutbox *outbox = &ctx->outboxes[slot];
+    if (outbox->sock != NET_INVALID_SOCKET && outbox->sock != sender_socket)
     {
-        if (i != new_player_id && ctx->game_state.players[i].is_active)
-        {
-            memset(&existing_events[existing_count], 0, sizeof(GameEvent));
-            existing_events[existing_count].type = EVENT_PLAYER_JOINED;
-            existing_events[existing_count].timestamp = time(NULL);
-            existing_events[existing_count].data.player_event.player_id = i;
-            strncpy(existing_events[existing_count].data.player_event.player_name,
-                    ctx->game_state.players[i].name, MAX_NAME_LEN - 1);
-            existing_count++;
-        }
+        // The old connection has not timed out yet. Keep what it never sent, then
+        // let its owner close it; by then the slot no longer refers to it.
+        server_salvage_outbox_locked(ctx, slot);
+        shutdown(outbox->sock, NET_SHUT_RDWR);
     }
-    net_mutex_unlock(&ctx->state_mutex);
+    // Already closed by its I/O thread: keep the missed frames for the next try
+    int attached = !conn->detached;
+    net_outbox_reset(outbox, attached ? sender_socket : NET_INVALID_SOCKET);
+    ctx->slot_connections[slot] = attached ? conn : NULL;
+    conn->write_interest = 0;
 
-    // Send events outside the lock to avoid deadlock
-    for (int i = 0; i < existing_count; ++i)
+    // The ack, then everything the player missed, in one write
+    if (attached)
     {
-        server_send_event_to(ctx, new_player_id, &existing_events[i]);
+        net_outbox_push(outbox, frame, ack_size);
+        if (resume->missed_overflow)
+        {
+            size_t lobby_size = net_encode_event(&lobby_event, frame, sizeof(frame));
+            net_outbox_push(outbox, frame, lobby_size);
+        }
+        else
+        {
+            for (int i = 0; i < resume->missed_count; ++i)
+            {
+                net_outbox_push(outbox, resume->missed[i].data, resume->missed[i].length);
+            }
+            replayed = resume->missed_count;
+        }
+        resume->missed_count = 0;
+        resume->missed_overflow = 0;
     }
+    net_profiled_mutex_unlock(&ctx->player_mutexes[slot]);
+    net_profiled_mutex_unlock(&ctx->roster_mutex);
 
-    // Notify all players of new join
-    GameEvent lifecycle;
-    memset(&lifecycle, 0, sizeof(GameEvent));
-    lifecycle.type = EVENT_PLAYER_JOINED;
-    lifecycle.timestamp = time(NULL);
-    lifecycle.data.player_event.player_id = ack_event.data.join_ack.player_id;
-    strncpy(lifecycle.data.player_event.player_name, payload->player_name, MAX_NAME_LEN - 1);
-    server_broadcast_event(ctx, &lifecycle);
+    server_on_player_resumed(ctx, slot, name_copy, replayed);
 
-    server_broadcast_current_turn(ctx, 0, NULL);
+    // Turn updates were not kept: bring the player up to date with keyframes
+    server_handle_resync_request(ctx, slot);
 
     if (host_changed)
     {
         server_emit_host_update(ctx, new_host_id, new_host_name);
     }
+    return 1;
 }
 
 // Handle user actions (gameplay)
@@ -543,19 +1729,15 @@ static void server_handle_user_action(ServerContext *ctx, const EventPayload_Use
     int winner_id = -1;
     char game_over_reason[64] = {0};
 
-    net_mutex_lock(&ctx->state_mutex);
-
     // Validate turn and player
     if (!ctx->game_state.match_started || ctx->game_state.turn.current_player_id != player_id)
     {
-        net_mutex_unlock(&ctx->state_mutex);
         return;
     }
 
     PlayerState *player = server_get_player(ctx, player_id);
     if (!player || !player->is_active)
     {
-        net_mutex_unlock(&ctx->state_mutex);
         return;
     }
 
@@ -600,8 +1782,6 @@ static void server_handle_user_action(ServerContext *ctx, const EventPayload_Use
         strncpy(game_over_reason, "Star goal reached", sizeof(game_over_reason) - 1);
     }
 
-    net_mutex_unlock(&ctx->state_mutex);
-
     if (winner_id != -1)
     {
         GameEvent over_event;
@@ -615,11 +1795,10 @@ static void server_handle_user_action(ServerContext *ctx, const EventPayload_Use
         }
         strncpy(over_event.data.game_over.reason, game_over_reason, sizeof(over_event.data.game_over.reason) - 1);
 
-        net_mutex_lock(&ctx->state_mutex);
         ctx->game_state.match_started = 0;
         ctx->game_state.is_game_over = 1;
         ctx->game_state.winner_id = winner_id;
-        net_mutex_unlock(&ctx->state_mutex);
+        server_announce_change(ctx);
 
         server_broadcast_event(ctx, &over_event);
         return;
@@ -638,24 +1817,20 @@ static void server_handle_match_start_request(ServerContext *ctx, int requester_
     if (!ctx)
         return;
 
-    net_mutex_lock(&ctx->state_mutex);
     if (requester_id < 0 || requester_id >= MAX_PLAYERS)
     {
-        net_mutex_unlock(&ctx->state_mutex);
         return;
     }
 
     PlayerState *requester = server_get_player(ctx, requester_id);
     if (!requester || !requester->is_active)
     {
-        net_mutex_unlock(&ctx->state_mutex);
         return;
     }
 
     int host_id = ctx->game_state.host_player_id;
     int match_started = ctx->game_state.match_started;
     int player_count = ctx->game_state.player_count;
-    net_mutex_unlock(&ctx->state_mutex);
 
     if (match_started)
     {
@@ -678,33 +1853,125 @@ static void server_handle_match_start_request(ServerContext *ctx, int requester_
     server_start_match(ctx);
 }
 
-// Handle player disconnects
+// Handle a client that lost track of its snapshot chain: resend the current turn as a keyframe
+static void server_handle_resync_request(ServerContext *ctx, int requester_id)
+{
+    if (!ctx || requester_id < 0 || requester_id >= MAX_PLAYERS)
+        return;
+
+    ctx->viewer_snapshots[requester_id].needs_keyframe = 1;
+    int match_started = ctx->game_state.match_started;
+    int current_id = ctx->game_state.turn.current_player_id;
+    int turn_number = ctx->game_state.turn.turn_number;
+    int next_id = server_next_active_player(ctx, current_id);
+
+    if (!match_started || current_id < 0)
+        return;
+
+    server_emit_turn_event(ctx, EVENT_TURN_STARTED, turn_number, current_id, next_id, 0, NULL, -1, requester_id);
+}
+
+// Handle player disconnects. A player holding a resume token keeps its slot for
+// the grace period and is skipped in the turn order until it resumes or expires.
 static void server_handle_disconnect(ServerContext *ctx, net_socket_t socket_fd)
 {
     int host_changed = 0;
     int new_host_id = -1;
     char new_host_name[MAX_NAME_LEN] = {0};
 
-    net_mutex_lock(&ctx->state_mutex);
     int player_id = server_find_player_by_socket(ctx, socket_fd);
     if (player_id == -1)
     {
-        net_mutex_unlock(&ctx->state_mutex);
         return;
     }
 
+    ServerResumeSlot *resume = &ctx->resume_slots[player_id];
+    int grace_ms = (int)server_read_count(&ctx->resume_grace_ms);
+    if (grace_ms <= 0 || resume->token == 0)
+    {
+        server_remove_player(ctx, player_id);
+        return;
+    }
+
+    PlayerState *player = &ctx->game_state.players[player_id];
+    char name_copy[MAX_NAME_LEN];
+    strncpy(name_copy, player->name, sizeof(name_copy) - 1);
+    name_copy[sizeof(name_copy) - 1] = '\0';
+    player->is_connected = 0;
+    ctx->player_sockets[player_id] = NET_INVALID_SOCKET;
+    resume->deadline_us = net_monotonic_us() + (uint64_t)grace_ms * 1000ULL;
+    // The game thread times its next wait from this
+    if (ctx->away_deadline_us == 0 || resume->deadline_us < ctx->away_deadline_us)
+    {
+        ctx->away_deadline_us = resume->deadline_us;
+    }
+
+    int was_current = (ctx->game_state.turn.current_player_id == player_id);
+    int previous_host = ctx->game_state.host_player_id;
+    new_host_id = server_select_host(ctx);
+    if (new_host_id != previous_host)
+    {
+        host_changed = 1;
+        if (new_host_id >= 0)
+        {
+            strncpy(new_host_name, ctx->game_state.players[new_host_id].name, MAX_NAME_LEN - 1);
+            new_host_name[MAX_NAME_LEN - 1] = '\0';
+        }
+    }
+
+    server_on_player_away(ctx, player_id, name_copy, grace_ms);
+
+    // Nobody waits on an absent player
+    if (was_current)
+    {
+        server_advance_turn(ctx, NULL);
+    }
+
+    if (host_changed)
+    {
+        server_emit_host_update(ctx, new_host_id, new_host_name);
+    }
+}
+
+// A player is leaving on purpose: its next disconnect frees the slot at once
+static void server_handle_leave(ServerContext *ctx, int player_id)
+{
+    if (player_id < 0 || player_id >= MAX_PLAYERS)
+        return;
+
+    ctx->resume_slots[player_id].token = 0;
+}
+
+// Free a player's slot and tell everyone it is gone
+static void server_remove_player(ServerContext *ctx, int player_id)
+{
+    int host_changed = 0;
+    int new_host_id = -1;
+    char new_host_name[MAX_NAME_LEN] = {0};
+
     PlayerState *player = &ctx->game_state.players[player_id];
+    if (!player->is_active)
+    {
+        return;
+    }
+
     char name_copy[MAX_NAME_LEN];
     strncpy(name_copy, player->name, sizeof(name_copy) - 1);
     name_copy[sizeof(name_copy) - 1] = '\0';
     player->is_active = 0;
     player->is_connected = 0;
     ctx->player_sockets[player_id] = NET_INVALID_SOCKET;
+    ctx->resume_slots[player_id].token = 0;
+    ctx->resume_slots[player_id].deadline_us = 0;
+    net_profiled_mutex_lock(&ctx->player_mutexes[player_id]);
+    ctx->resume_slots[player_id].missed_count = 0;
+    ctx->resume_slots[player_id].missed_overflow = 0;
+    net_profiled_mutex_unlock(&ctx->player_mutexes[player_id]);
     server_refresh_player_count(ctx);
 
     int was_current = (ctx->game_state.turn.current_player_id == player_id);
     int previous_host = ctx->game_state.host_player_id;
-    new_host_id = server_select_host_locked(ctx);
+    new_host_id = server_select_host(ctx);
     if (new_host_id != previous_host)
     {
         host_changed = 1;
@@ -714,7 +1981,6 @@ static void server_handle_disconnect(ServerContext *ctx, net_socket_t socket_fd)
             new_host_name[MAX_NAME_LEN - 1] = '\0';
         }
     }
-    net_mutex_unlock(&ctx->state_mutex);
 
     // Notify all players of player leaving
     GameEvent lifecycle;
@@ -739,94 +2005,264 @@ static void server_handle_disconnect(ServerContext *ctx, net_socket_t socket_fd)
     }
 }
 
+// Remove away players whose grace period ran out
+static void server_expire_away_players(ServerContext *ctx, uint64_t now_us)
+{
+    int expired[MAX_PLAYERS];
+    int expired_count = 0;
+    uint64_t next_deadline_us = 0;
+
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        ServerResumeSlot *resume = &ctx->resume_slots[i];
+        if (resume->deadline_us == 0)
+            continue;
+        if (now_us >= resume->deadline_us)
+        {
+            // Clearing the token first means a late resume cannot race the removal
+            resume->token = 0;
+            resume->deadline_us = 0;
+            expired[expired_count++] = i;
+        }
+        else if (next_deadline_us == 0 || resume->deadline_us < next_deadline_us)
+        {
+            next_deadline_us = resume->deadline_us;
+        }
+    }
+    // Resumed players leave a stale earlier deadline behind; it costs one wake-up
+    ctx->away_deadline_us = next_deadline_us;
+
+    for (int i = 0; i < expired_count; ++i)
+    {
+        server_remove_player(ctx, expired[i]);
+    }
+}
+
 // Broadcast an event to all active players
 static void server_broadcast_event(ServerContext *ctx, const GameEvent *event)
 {
-    net_mutex_lock(&ctx->state_mutex);
+    unsigned char frame[NET_FRAME_MAX_SIZE];
+    size_t frame_size = net_encode_event(event, frame, sizeof(frame));
+    if (frame_size == 0)
+        return;
+
     for (int i = 0; i < MAX_PLAYERS; ++i)
     {
-        net_socket_t sock = ctx->player_sockets[i];
-        if (sock != NET_INVALID_SOCKET)
+        if (ctx->game_state.players[i].is_active)
         {
-            net_send_event(sock, event);
+            server_queue_frame(ctx, i, frame, frame_size);
         }
     }
-    net_mutex_unlock(&ctx->state_mutex);
 }
 
 // Send an event to a specific player
 static void server_send_event_to(ServerContext *ctx, int player_id, const GameEvent *event)
 {
-    net_mutex_lock(&ctx->state_mutex);
     if (player_id >= 0 && player_id < MAX_PLAYERS)
     {
-        net_socket_t sock = ctx->player_sockets[player_id];
-        if (sock != NET_INVALID_SOCKET)
+        server_queue_event(ctx, player_id, event);
+    }
+}
+
+// Queue several events for one player
+static void server_send_events_to(ServerContext *ctx, int player_id, const GameEvent *events, int count)
+{
+    if (player_id >= 0 && player_id < MAX_PLAYERS)
+    {
+        for (int i = 0; i < count; ++i)
         {
-            net_send_event(sock, event);
+            server_queue_event(ctx, player_id, &events[i]);
         }
     }
-    net_mutex_unlock(&ctx->state_mutex);
 }
 
-// Collect IDs of all active players
-static int server_collect_active_players(ServerContext *ctx, int *out_ids, int max_ids)
+// Frames the slow-consumer coalesce policy may drop: every turn update is
+// superseded by the next one, which is then sent as a keyframe
+#define SERVER_STATE_FRAME_TYPES (NET_OUTBOX_TYPE_BIT(EVENT_TURN_STARTED) | NET_OUTBOX_TYPE_BIT(EVENT_TURN_PRIVATE))
+
+// Frames a resumed player does not need replayed: turn updates are replaced
+// by a keyframe and heartbeats are meaningless once late
+#define SERVER_UNREPLAYED_FRAME_TYPES (SERVER_STATE_FRAME_TYPES | NET_OUTBOX_TYPE_BIT(EVENT_PING) | NET_OUTBOX_TYPE_BIT(EVENT_PONG))
+
+// Append a frame to a player's outbox (game thread only).
+// The game thread flushes it after its current batch of commands.
+// Frames for a player waiting to resume are kept for replay instead.
+static void server_queue_frame(ServerContext *ctx, int player_id, const unsigned char *frame, size_t len)
 {
-    if (!out_ids || max_ids <= 0)
+    if (ctx->player_sockets[player_id] == NET_INVALID_SOCKET)
     {
-        return 0;
+        if (ctx->resume_slots[player_id].deadline_us != 0)
+        {
+            net_profiled_mutex_lock(&ctx->player_mutexes[player_id]);
+            server_keep_missed_locked(ctx, player_id, frame, len);
+            net_profiled_mutex_unlock(&ctx->player_mutexes[player_id]);
+        }
+        return;
     }
 
-    int count = 0;
-    net_mutex_lock(&ctx->state_mutex);
-    for (int i = 0; i < MAX_PLAYERS && count < max_ids; ++i)
+    net_profiled_mutex_lock(&ctx->player_mutexes[player_id]);
+    NetOutbox *outbox = &ctx->outboxes[player_id];
+    if (!net_outbox_push(outbox, frame, len) && outbox->sock != NET_INVALID_SOCKET)
     {
-        if (ctx->game_state.players[i].is_active)
+        int first_overflow = outbox->dropped_frames == 0 && outbox->coalesced_frames == 0;
+        NetOutboxPolicy policy = ctx->slow_consumer_policy;
+        if (first_overflow || policy == NET_OUTBOX_POLICY_DISCONNECT)
+        {
+            server_on_slow_consumer(ctx, player_id, policy);
+        }
+
+        switch (policy)
         {
-            out_ids[count++] = i;
+        case NET_OUTBOX_POLICY_COALESCE:
+        {
+            size_t removed = net_outbox_discard(outbox, SERVER_STATE_FRAME_TYPES);
+            outbox->coalesced_frames += removed;
+            if (removed > 0)
+            {
+                ctx->viewer_snapshots[player_id].needs_keyframe = 1;
+            }
+            if (!net_outbox_push(outbox, frame, len))
+            {
+                outbox->dropped_frames += 1;
+            }
+            break;
+        }
+        case NET_OUTBOX_POLICY_DISCONNECT:
+            // The owning I/O thread sees the shutdown as a hang-up and cleans up
+            server_salvage_outbox_locked(ctx, player_id);
+            shutdown(outbox->sock, NET_SHUT_RDWR);
+            net_outbox_reset(outbox, NET_INVALID_SOCKET);
+            break;
+        case NET_OUTBOX_POLICY_DROP:
+        default:
+            outbox->dropped_frames += 1;
+            if (SERVER_STATE_FRAME_TYPES & NET_OUTBOX_TYPE_BIT(frame[NET_FRAME_LENGTH_SIZE + 1]))
+            {
+                ctx->viewer_snapshots[player_id].needs_keyframe = 1; // The client's chain is broken
+            }
+            break;
         }
     }
-    net_mutex_unlock(&ctx->state_mutex);
-    return count;
+    net_profiled_mutex_unlock(&ctx->player_mutexes[player_id]);
 }
 
-// Build a snapshot of game state for a specific viewer
-static int server_build_player_snapshot(ServerContext *ctx, int viewer_id, PlayerGameState *out_state)
+// Encode an event and append it to a player's outbox (game thread only)
+static void server_queue_event(ServerContext *ctx, int player_id, const GameEvent *event)
 {
-    if (!out_state)
+    unsigned char frame[NET_FRAME_MAX_SIZE];
+    size_t frame_size = net_encode_event(event, frame, sizeof(frame));
+    if (frame_size == 0)
     {
-        return 0;
+        fprintf(stderr, "Warning: Event type %d does not fit in a frame\n", (int)event->type);
+        return;
     }
-    int previous_host = ctx->game_state.host_player_id;
-    int host_changed = 0;
-    int new_host_id = -1;
-    char new_host_name[MAX_NAME_LEN] = {0};
+    server_queue_frame(ctx, player_id, frame, frame_size);
+}
 
-    new_host_id = server_select_host_locked(ctx);
-    if (new_host_id != previous_host)
+// Keep a frame for a player that may resume (must be called with the player's mutex locked)
+static void server_keep_missed_locked(ServerContext *ctx, int player_id, const unsigned char *frame, size_t len)
+{
+    ServerResumeSlot *resume = &ctx->resume_slots[player_id];
+    unsigned int type = frame[NET_FRAME_LENGTH_SIZE + 1];
+    if (type < 32 && (SERVER_UNREPLAYED_FRAME_TYPES & NET_OUTBOX_TYPE_BIT(type)))
+        return;
+    if (resume->missed_overflow || len > NET_FRAME_MAX_SIZE)
+        return;
+    if (resume->missed_count == SERVER_RESUME_REPLAY_FRAMES)
     {
-        host_changed = 1;
-        if (new_host_id >= 0)
+        resume->missed_overflow = 1;
+        resume->missed_count = 0;
+        return;
+    }
+
+    NetOutboxFrame *slot = &resume->missed[resume->missed_count++];
+    memcpy(slot->data, frame, len);
+    slot->length = len;
+}
+
+// Move the frames a dying connection never finished sending to the player's
+// replay buffer (must be called with the player's mutex locked). A partly written
+// head frame is kept whole; the resumed connection starts a fresh stream.
+static void server_salvage_outbox_locked(ServerContext *ctx, int player_id)
+{
+    NetOutbox *outbox = &ctx->outboxes[player_id];
+    for (size_t i = 0; i < outbox->count; ++i)
+    {
+        NetOutboxFrame *frame = &outbox->frames[(outbox->head + i) % NET_OUTBOX_CAPACITY];
+        server_keep_missed_locked(ctx, player_id, frame->data, frame->length);
+    }
+    outbox->count = 0;
+    outbox->head_offset = 0;
+}
+
+// Stop writing to a connection that is being closed. Once detached, a join
+// still queued for it is given no outbox.
+static void server_detach_outbox(ServerContext *ctx, ServerConnection *conn)
+{
+    net_profiled_mutex_lock(&ctx->roster_mutex);
+    conn->detached = 1;
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        net_profiled_mutex_lock(&ctx->player_mutexes[i]);
+        if (ctx->outboxes[i].sock == conn->sock)
         {
-            strncpy(new_host_name, ctx->game_state.players[new_host_id].name, MAX_NAME_LEN - 1);
-            new_host_name[MAX_NAME_LEN - 1] = '\0';
+            server_salvage_outbox_locked(ctx, i);
+            net_outbox_reset(&ctx->outboxes[i], NET_INVALID_SOCKET);
+            ctx->slot_connections[i] = NULL;
         }
+        net_profiled_mutex_unlock(&ctx->player_mutexes[i]);
+    }
+    net_profiled_mutex_unlock(&ctx->roster_mutex);
+}
+
+// Write every pending outbox without blocking. A connection whose socket is
+// full is registered for writability so its owner wakes up when it drains.
+// Each slot is locked on its own, so threads flushing or queueing for
+// different players do not wait for each other.
+static void server_flush_outboxes(ServerContext *ctx)
+{
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        net_profiled_mutex_lock(&ctx->player_mutexes[i]);
+        server_flush_outbox_locked(ctx, i);
+        net_profiled_mutex_unlock(&ctx->player_mutexes[i]);
     }
+}
 
-    PlayerGameState snapshot;
-    memset(&snapshot, 0, sizeof(PlayerGameState));
+// Write one player's outbox (must be called with the player's mutex locked)
+static void server_flush_outbox_locked(ServerContext *ctx, int player_id)
+{
+    NetOutbox *outbox = &ctx->outboxes[player_id];
+    if (outbox->sock == NET_INVALID_SOCKET)
+        return;
 
-    net_mutex_lock(&ctx->state_mutex);
-    PlayerState *viewer = server_get_player(ctx, viewer_id);
-    if (!viewer || !viewer->is_active)
+    int result = outbox->count > 0 ? net_outbox_flush(outbox) : 1;
+    if (result < 0)
     {
-        net_mutex_unlock(&ctx->state_mutex);
-        return 0;
+        // Broken connection: let the owning I/O thread notice and clean up
+        server_salvage_outbox_locked(ctx, player_id);
+        shutdown(outbox->sock, NET_SHUT_RDWR);
+        net_outbox_reset(outbox, NET_INVALID_SOCKET);
+        ctx->slot_connections[player_id] = NULL;
+        return;
     }
 
-    snapshot.viewer_id = viewer_id;
-    snapshot.self = *viewer;
+    ServerConnection *conn = ctx->slot_connections[player_id];
+    int want_write = result == 0;
+    if (conn && conn->write_interest != want_write)
+    {
+        unsigned int interest = NET_REACTOR_READ | (want_write ? NET_REACTOR_WRITE : 0);
+        if (net_reactor_modify(conn->owner->reactor, conn->sock, interest, conn) == 0)
+        {
+            conn->write_interest = want_write;
+        }
+    }
+}
 
+// Build the public view of every player, identical for all viewers (game thread only).
+// Each viewer's exact own numbers travel separately in EVENT_TURN_PRIVATE.
+static void server_build_public_view(ServerContext *ctx, PlayerPublicInfo *out_view)
+{
     for (int i = 0; i < MAX_PLAYERS; ++i)
     {
         PlayerPublicInfo info;
@@ -837,32 +2273,15 @@ static int server_build_player_snapshot(ServerContext *ctx, int viewer_id, Playe
         info.is_active = candidate->is_active;
         info.name[MAX_NAME_LEN - 1] = '\0'; // safety null-term
         info.planet_level = candidate->planet.level;
-
-        if (host_changed)
-        {
-            server_emit_host_update(ctx, new_host_id, new_host_name);
-        }
         info.ship_level = candidate->ship.level;
         info.ship_base_damage = candidate->ship.base_damage;
         if (candidate->is_active)
         {
-            if (viewer_id == i)
-            {
-                info.show_stars = 1;
-                info.coarse_planet_health = (candidate->planet.max_health == 0) ? 0 : (candidate->planet.current_health * 100) / candidate->planet.max_health;
-            }
-            else
-            {
-                info.show_stars = candidate->stars >= STAR_WARNING_THRESHOLD;
-                info.coarse_planet_health = to_coarse_percent(candidate->planet.current_health, candidate->planet.max_health);
-            }
+            info.show_stars = candidate->stars >= STAR_WARNING_THRESHOLD;
+            info.coarse_planet_health = to_coarse_percent(candidate->planet.current_health, candidate->planet.max_health);
         }
-        snapshot.entries[i] = info;
+        out_view[i] = info;
     }
-    net_mutex_unlock(&ctx->state_mutex);
-
-    *out_state = snapshot;
-    return 1;
 }
 
 // Get pointer to player state by ID
@@ -932,6 +2351,11 @@ static void server_refresh_player_count(ServerContext *ctx)
             ++count;
         }
     }
+    if (count != ctx->game_state.player_count)
+    {
+        // Let browsing clients see the new count without waiting for the interval
+        server_announce_change(ctx);
+    }
     ctx->game_state.player_count = count;
 }
 
@@ -941,10 +2365,8 @@ static void server_start_match(ServerContext *ctx)
     GameState snapshot;
     memset(&snapshot, 0, sizeof(GameState));
 
-    net_mutex_lock(&ctx->state_mutex);
     if (ctx->game_state.match_started || ctx->game_state.player_count < MIN_PLAYERS)
     {
-        net_mutex_unlock(&ctx->state_mutex);
         return;
     }
 
@@ -956,29 +2378,34 @@ static void server_start_match(ServerContext *ctx)
 
     if (start_player == -1)
     {
-        net_mutex_unlock(&ctx->state_mutex);
         return;
     }
 
     ctx->game_state.match_started = 1;
     ctx->game_state.is_game_over = 0;
     ctx->game_state.winner_id = -1;
+    server_announce_change(ctx);
     ctx->game_state.turn.turn_number = 1;
     ctx->game_state.turn.current_player_id = start_player;
+    for (int i = 0; i < MAX_PLAYERS; ++i)
+    {
+        ctx->viewer_snapshots[i].needs_keyframe = 1; // Clients reset their view on match start
+    }
     snapshot = ctx->game_state;
-    net_mutex_unlock(&ctx->state_mutex);
 
     GameEvent start_event;
     memset(&start_event, 0, sizeof(GameEvent));
     start_event.type = EVENT_MATCH_START;
     start_event.timestamp = time(NULL);
-    start_event.data.match_start.state = snapshot;
+    start_event.data.match_start.host_player_id = snapshot.host_player_id;
+    start_event.data.match_start.first_player_id = snapshot.turn.current_player_id;
+    start_event.data.match_start.player_count = snapshot.player_count;
     server_broadcast_event(ctx, &start_event);
 
     server_broadcast_current_turn(ctx, 1, NULL);
 }
 
-// Compute valid actions for a player (must be called with mutex locked)
+// Compute valid actions for a player (game thread only)
 static int server_compute_valid_actions(ServerContext *ctx, int player_id, int current_player_id)
 {
     int valid = 0;
@@ -1039,11 +2466,134 @@ static int server_compute_valid_actions(ServerContext *ctx, int player_id, int c
     return valid;
 }
 
-// Emit a turn event to all players
-static void server_emit_turn_event(ServerContext *ctx, EventType type, int turn_number, int current_id, int next_id, int is_match_start, const EventPayload_UserAction *last_action, int threshold_player_id)
+// Bump a snapshot version, skipping 0 which means "no base"
+static unsigned int server_next_snapshot_version(unsigned int version)
+{
+    version += 1;
+    return version == 0 ? 1 : version;
+}
+
+// Move the shared public view forward and describe the step as a delta (game thread only)
+static void server_advance_public_view(ServerContext *ctx, const PlayerPublicInfo *view, EventPayload_TurnInfo *turn)
+{
+    int keyframe = ctx->public_version == 0;
+    net_snapshot_make_public_delta(keyframe ? NULL : ctx->public_view, view, turn);
+    turn->base_version = keyframe ? 0 : ctx->public_version;
+
+    ctx->public_version = server_next_snapshot_version(ctx->public_version);
+    turn->snapshot_version = ctx->public_version;
+    memcpy(ctx->public_view, view, sizeof(ctx->public_view));
+}
+
+// Encode a viewer's own state and valid actions into out_frame, left empty when
+// nothing changed since the last update (game thread only)
+static void server_build_private_state(ServerContext *ctx, int viewer_id, int valid_actions, int keyframe, NetOutboxFrame *out_frame)
+{
+    ServerViewerSnapshot *viewer = &ctx->viewer_snapshots[viewer_id];
+    out_frame->length = 0;
+
+    keyframe = keyframe || viewer->version == 0;
+    const PlayerState *self = &ctx->game_state.players[viewer_id];
+
+    GameEvent event;
+    memset(&event, 0, sizeof(GameEvent));
+    event.type = EVENT_TURN_PRIVATE;
+    event.timestamp = time(NULL);
+    event.data.turn_private.player_id = viewer_id;
+    event.data.turn_private.valid_actions = valid_actions;
+    net_snapshot_make_private_delta(keyframe ? NULL : &viewer->sent_self, self, &event.data.turn_private);
+    if (!keyframe && event.data.turn_private.self_mask == 0 && valid_actions == viewer->sent_valid_actions)
+    {
+        return;
+    }
+
+    event.data.turn_private.base_version = keyframe ? 0 : viewer->version;
+    viewer->version = server_next_snapshot_version(viewer->version);
+    event.data.turn_private.snapshot_version = viewer->version;
+    out_frame->length = net_encode_event(&event, out_frame->data, sizeof(out_frame->data));
+    viewer->sent_self = *self;
+    viewer->sent_valid_actions = valid_actions;
+}
+
+// Fill the turn buffer in one pass (game thread only): the host, the next
+// public view and its version, then every viewer's private update, valid
+// actions and which public frame it needs. event carries the turn fields; its
+// public part is filled in here.
+static void server_build_turn(ServerContext *ctx, ServerTurnBuffer *build, GameEvent *event, int current_id, int target_viewer)
+{
+    build->viewer_count = 0;
+    build->delta_frame.length = 0;
+    build->keyframe_frame.length = 0;
+    build->host_changed = 0;
+
+    int any_active = 0;
+    for (int i = 0; i < MAX_PLAYERS && !any_active; ++i)
+    {
+        any_active = ctx->game_state.players[i].is_active;
+    }
+    if (!any_active)
+    {
+        return;
+    }
+
+    int previous_host = ctx->game_state.host_player_id;
+    build->host_id = server_select_host(ctx);
+    if (build->host_id != previous_host)
+    {
+        build->host_changed = 1;
+        build->host_name[0] = '\0';
+        if (build->host_id >= 0)
+        {
+            strncpy(build->host_name, ctx->game_state.players[build->host_id].name, MAX_NAME_LEN - 1);
+            build->host_name[MAX_NAME_LEN - 1] = '\0';
+        }
+    }
+
+    PlayerPublicInfo view[MAX_PLAYERS];
+    server_build_public_view(ctx, view);
+    if (target_viewer < 0)
+    {
+        server_advance_public_view(ctx, view, &event->data.turn);
+        build->delta_frame.length = net_encode_event(event, build->delta_frame.data, sizeof(build->delta_frame.data));
+    }
+
+    for (int viewer_id = 0; viewer_id < MAX_PLAYERS; ++viewer_id)
+    {
+        if (target_viewer >= 0 && viewer_id != target_viewer)
+        {
+            continue;
+        }
+        if (ctx->player_sockets[viewer_id] == NET_INVALID_SOCKET || !ctx->game_state.players[viewer_id].is_active)
+        {
+            continue;
+        }
+
+        int n = build->viewer_count++;
+        int keyframe = target_viewer >= 0 || ctx->viewer_snapshots[viewer_id].needs_keyframe || build->delta_frame.length == 0;
+        build->viewer_ids[n] = viewer_id;
+        build->public_keyframe[n] = keyframe;
+        build->valid_actions[n] = server_compute_valid_actions(ctx, viewer_id, current_id);
+        server_build_private_state(ctx, viewer_id, build->valid_actions[n], keyframe, &build->private_frames[n]);
+        ctx->viewer_snapshots[viewer_id].needs_keyframe = 0;
+
+        if (keyframe && build->keyframe_frame.length == 0)
+        {
+            net_snapshot_make_public_delta(NULL, ctx->public_view, &event->data.turn);
+            event->data.turn.base_version = 0;
+            event->data.turn.snapshot_version = ctx->public_version;
+            build->keyframe_frame.length = net_encode_event(event, build->keyframe_frame.data, sizeof(build->keyframe_frame.data));
+        }
+    }
+}
+
+// Emit a turn event to all players, or only to target_viewer when it is >= 0.
+// The public part is encoded once and the same frame goes to every viewer;
+// only viewers that need a keyframe get a separately encoded copy. Everything
+// is built first and queued after; the game thread is the only one queueing,
+// so frames reach each outbox in version order.
+static void server_emit_turn_event(ServerContext *ctx, EventType type, int turn_number, int current_id, int next_id, int is_match_start, const EventPayload_UserAction *last_action, int threshold_player_id, int target_viewer)
 {
-    int viewers[MAX_PLAYERS];
-    int viewer_count = server_collect_active_players(ctx, viewers, MAX_PLAYERS);
+    ServerTurnBuffer *build = &ctx->turn_buffer;
 
     EventPayload_UserAction empty_action;
     memset(&empty_action, 0, sizeof(empty_action));
@@ -1051,49 +2601,49 @@ static void server_emit_turn_event(ServerContext *ctx, EventType type, int turn_
     empty_action.action_type = USER_ACTION_NONE;
     const EventPayload_UserAction *action_payload = last_action ? last_action : &empty_action;
 
-    for (int i = 0; i < viewer_count; ++i)
-    {
-        PlayerGameState snapshot;
-        if (!server_build_player_snapshot(ctx, viewers[i], &snapshot))
-        {
-            continue;
-        }
+    GameEvent event;
+    memset(&event, 0, sizeof(GameEvent));
+    event.type = type;
+    event.timestamp = time(NULL);
+    event.data.turn.current_player_id = current_id;
+    event.data.turn.next_player_id = next_id;
+    event.data.turn.turn_number = turn_number;
+    event.data.turn.is_match_start = is_match_start;
+    event.data.turn.threshold_player_id = threshold_player_id;
+    event.data.turn.last_action = *action_payload;
 
-        // Compute valid actions for this viewer
-        net_mutex_lock(&ctx->state_mutex);
-        int valid_actions = server_compute_valid_actions(ctx, viewers[i], current_id);
-        net_mutex_unlock(&ctx->state_mutex);
+    server_build_turn(ctx, build, &event, current_id, target_viewer);
 
-        GameEvent event;
-        memset(&event, 0, sizeof(GameEvent));
-        event.type = type;
-        event.timestamp = time(NULL);
-        event.data.turn.current_player_id = current_id;
-        event.data.turn.next_player_id = next_id;
-        event.data.turn.turn_number = turn_number;
-        event.data.turn.is_match_start = is_match_start;
-        event.data.turn.valid_actions = valid_actions;
-        event.data.turn.threshold_player_id = threshold_player_id;
-        event.data.turn.last_action = *action_payload;
-        event.data.turn.game = snapshot;
+    if (build->host_changed)
+    {
+        server_emit_host_update(ctx, build->host_id, build->host_name);
+    }
 
-        server_send_event_to(ctx, viewers[i], &event);
+    for (int n = 0; n < build->viewer_count; ++n)
+    {
+        int viewer_id = build->viewer_ids[n];
+        const NetOutboxFrame *public_frame = build->public_keyframe[n] ? &build->keyframe_frame : &build->delta_frame;
+        if (build->private_frames[n].length > 0)
+        {
+            server_queue_frame(ctx, viewer_id, build->private_frames[n].data, build->private_frames[n].length);
+        }
+        if (public_frame->length > 0)
+        {
+            server_queue_frame(ctx, viewer_id, public_frame->data, public_frame->length);
+        }
     }
 }
 
 // Broadcast current turn info to all players
 static void server_broadcast_current_turn(ServerContext *ctx, int is_match_start, const EventPayload_UserAction *last_action)
 {
-    net_mutex_lock(&ctx->state_mutex);
     if (!ctx->game_state.match_started)
     {
-        net_mutex_unlock(&ctx->state_mutex);
         return;
     }
     int current_id = ctx->game_state.turn.current_player_id;
     if (current_id < 0)
     {
-        net_mutex_unlock(&ctx->state_mutex);
         return;
     }
 
@@ -1109,9 +2659,8 @@ static void server_broadcast_current_turn(ServerContext *ctx, int is_match_start
 
     int turn_number = ctx->game_state.turn.turn_number;
     int next_id = server_next_active_player(ctx, current_id);
-    net_mutex_unlock(&ctx->state_mutex);
 
-    server_emit_turn_event(ctx, EVENT_TURN_STARTED, turn_number, current_id, next_id, is_match_start, last_action, -1);
+    server_emit_turn_event(ctx, EVENT_TURN_STARTED, turn_number, current_id, next_id, is_match_start, last_action, -1, -1);
 }
 
 // Advance to the next player's turn
@@ -1120,17 +2669,14 @@ static void server_advance_turn(ServerContext *ctx, const EventPayload_UserActio
     // Extract threshold player id from last_action metadata (set by server_handle_user_action)
     int threshold_player_id = (last_action && last_action->metadata >= 0) ? last_action->metadata : -1;
 
-    net_mutex_lock(&ctx->state_mutex);
     if (!ctx->game_state.match_started)
     {
-        net_mutex_unlock(&ctx->state_mutex);
         return;
     }
 
     int next_player = server_next_active_player(ctx, ctx->game_state.turn.current_player_id);
     if (next_player == -1)
     {
-        net_mutex_unlock(&ctx->state_mutex);
         return;
     }
 
@@ -1146,8 +2692,7 @@ static void server_advance_turn(ServerContext *ctx, const EventPayload_UserActio
     int current_turn = ctx->game_state.turn.current_player_id;
     int turn_number = ctx->game_state.turn.turn_number;
     int following = server_next_active_player(ctx, current_turn);
-    net_mutex_unlock(&ctx->state_mutex);
-    server_emit_turn_event(ctx, EVENT_TURN_STARTED, turn_number, current_turn, following, 0, last_action, threshold_player_id);
+    server_emit_turn_event(ctx, EVENT_TURN_STARTED, turn_number, current_turn, following, 0, last_action, threshold_player_id, -1);
 }
 
 // Find the next active player after a given player
@@ -1159,7 +2704,8 @@ static int server_next_active_player(ServerContext *ctx, int start_after)
     for (int offset = 1; offset <= MAX_PLAYERS; ++offset)
     {
         int candidate = (start_after + offset + MAX_PLAYERS) % MAX_PLAYERS;
-        if (ctx->game_state.players[candidate].is_active)
+        // Players waiting to resume are skipped
+        if (ctx->game_state.players[candidate].is_active && ctx->game_state.players[candidate].is_connected)
         {
             if (start_after >= 0 && start_after < MAX_PLAYERS && ctx->game_state.players[start_after].is_active && candidate == start_after)
             {
@@ -1215,21 +2761,23 @@ static void server_send_error_event(ServerContext *ctx, int player_id, int error
     server_send_event_to(ctx, player_id, &error_event);
 }
 
-// Select the host player (must be called with mutex locked)
-static int server_select_host_locked(ServerContext *ctx)
+// Select the host player (game thread only)
+static int server_select_host(ServerContext *ctx)
 {
     if (!ctx)
         return -1;
 
+    // Only a connected player can host; an away host hands over and does not take it back
     int current = ctx->game_state.host_player_id;
-    if (current >= 0 && current < MAX_PLAYERS && ctx->game_state.players[current].is_active)
+    if (current >= 0 && current < MAX_PLAYERS && ctx->game_state.players[current].is_active &&
+        ctx->game_state.players[current].is_connected)
     {
         return current;
     }
 
     for (int i = 0; i < MAX_PLAYERS; ++i)
     {
-        if (ctx->game_state.players[i].is_active)
+        if (ctx->game_state.players[i].is_active && ctx->game_state.players[i].is_connected)
         {
             ctx->game_state.host_player_id = i;
             return i;
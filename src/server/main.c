@@ -42,16 +42,16 @@ void server_on_started(ServerContext *ctx, int port)
     armada_server_logf(SRV_COLOR_GREEN "[Server]" SRV_COLOR_RESET " Server listening on port " SRV_COLOR_BOLD "%d" SRV_COLOR_RESET ".", port);
 }
 
-void server_on_accept_thread_started(ServerContext *ctx)
+void server_on_io_threads_started(ServerContext *ctx, int thread_count, const char *backend)
 {
     (void)ctx;
-    armada_server_logf(SRV_COLOR_GREEN "[Server]" SRV_COLOR_RESET " Accept thread running.");
+    armada_server_logf(SRV_COLOR_GREEN "[Server]" SRV_COLOR_RESET " %d I/O thread%s running (%s).", thread_count, thread_count == 1 ? "" : "s", backend);
 }
 
-void server_on_accept_thread_failed(ServerContext *ctx, const char *message)
+void server_on_io_threads_failed(ServerContext *ctx, const char *message)
 {
     (void)ctx;
-    armada_server_logf(SRV_COLOR_RED "[Server] ERROR:" SRV_COLOR_RESET " Accept thread failed: %s", message ? message : "unknown error");
+    armada_server_logf(SRV_COLOR_RED "[Server] ERROR:" SRV_COLOR_RESET " I/O threads failed: %s", message ? message : "unknown error");
 }
 
 void server_on_stopping(ServerContext *ctx)
@@ -66,6 +66,18 @@ void server_on_client_connected(ServerContext *ctx, net_socket_t socket_fd)
     armada_server_logf(SRV_COLOR_GREEN "[Server]" SRV_COLOR_RESET " Client connected on socket " SRV_COLOR_CYAN "%llu" SRV_COLOR_RESET ".", (unsigned long long)socket_fd);
 }
 
+void server_on_flood_disconnect(ServerContext *ctx, net_socket_t socket_fd, unsigned int dropped)
+{
+    (void)ctx;
+    armada_server_logf(SRV_COLOR_RED "[Server]" SRV_COLOR_RESET " Closed socket " SRV_COLOR_CYAN "%llu" SRV_COLOR_RESET " for flooding (%u events over its limit).", (unsigned long long)socket_fd, dropped);
+}
+
+void server_on_connection_rejected(ServerContext *ctx, const char *reason)
+{
+    (void)ctx;
+    armada_server_logf(SRV_COLOR_YELLOW "[Server]" SRV_COLOR_RESET " Turned a connection away: %s.", reason);
+}
+
 void server_on_client_disconnected(ServerContext *ctx, net_socket_t socket_fd)
 {
     (void)ctx;
@@ -84,6 +96,33 @@ void server_on_unknown_action(ServerContext *ctx, UserActionType action, int pla
     armada_server_logf(SRV_COLOR_RED "[Server] WARNING:" SRV_COLOR_RESET " Unknown action " SRV_COLOR_MAGENTA "%d" SRV_COLOR_RESET " from player " SRV_COLOR_CYAN "%d" SRV_COLOR_RESET ".", action, player_id);
 }
 
+void server_on_slow_consumer(ServerContext *ctx, int player_id, NetOutboxPolicy policy)
+{
+    (void)ctx;
+    const char *outcome = policy == NET_OUTBOX_POLICY_DISCONNECT ? "disconnecting"
+                          : policy == NET_OUTBOX_POLICY_COALESCE ? "coalescing state updates"
+                                                                 : "dropping events";
+    armada_server_logf(SRV_COLOR_YELLOW "[Server]" SRV_COLOR_RESET " Player " SRV_COLOR_CYAN "%d" SRV_COLOR_RESET " is not keeping up, %s.", player_id, outcome);
+}
+
+void server_on_heartbeat_timeout(ServerContext *ctx, net_socket_t socket_fd, int silent_ms)
+{
+    (void)ctx;
+    armada_server_logf(SRV_COLOR_YELLOW "[Server]" SRV_COLOR_RESET " Socket " SRV_COLOR_CYAN "%llu" SRV_COLOR_RESET " silent for %d ms, dropping it.", (unsigned long long)socket_fd, silent_ms);
+}
+
+void server_on_player_away(ServerContext *ctx, int player_id, const char *player_name, int grace_ms)
+{
+    (void)ctx;
+    armada_server_logf(SRV_COLOR_YELLOW "[Server]" SRV_COLOR_RESET " Player " SRV_COLOR_BOLD "%s" SRV_COLOR_RESET " (ID %d) lost connection, holding the slot for %d s.", player_name, player_id, grace_ms / 1000);
+}
+
+void server_on_player_resumed(ServerContext *ctx, int player_id, const char *player_name, int replayed_frames)
+{
+    (void)ctx;
+    armada_server_logf(SRV_COLOR_GREEN "[Server]" SRV_COLOR_RESET " Player " SRV_COLOR_BOLD "%s" SRV_COLOR_RESET " (ID %d) resumed, replayed %d missed event(s).", player_name, player_id, replayed_frames);
+}
+
 void server_on_turn_action(ServerContext *ctx, const EventPayload_UserAction *action)
 {
 